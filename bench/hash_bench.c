@@ -0,0 +1,408 @@
+/*-
+ * Copyright (c) 2016 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Hash kernel microbenchmark.
+ *
+ * Every _data function is measured for each key length and
+ * misalignment, array variants for lengths divisible by their
+ * element size (aligned only, arrays of misaligned elements aren't
+ * valid input) and fixed width variants once. Output is CSV:
+ * hash,variant,len,misalign,iters,ns_per_key,cycles_per_byte.
+ *
+ * Cycles are read with rdtsc on x86 and reported as 0 elsewhere.
+ * Build ../lib with and without -DUNALIGNED_READ to compare the
+ * read paths.
+ */
+
+#include <err.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#include <rgph.h>
+
+#define MAXLEN 4096
+#define NALIGN 4
+#define NBATCH 64 /* Keys per call of batch functions. */
+
+typedef uint64_t (*bench_fn)(const void *, size_t, size_t);
+
+enum kind { DATA, VALUE, ARRAY, BATCH };
+
+struct variant {
+	const char *hash;
+	const char *name;
+	enum kind kind;
+	size_t elemsz;
+	bench_fn fn;
+};
+
+/*
+ * Loops are generated per function to call the hash directly.
+ * The loop index is passed as a seed to defeat hoisting.
+ */
+#define VECTOR_DATA(P, n)						\
+static uint64_t								\
+bench_##P##_data(const void *key, size_t len, size_t iters)		\
+{									\
+	uint32_t out[n];						\
+	uint64_t acc = 0;						\
+	size_t i;							\
+									\
+	for (i = 0; i < iters; i++) {					\
+		P##_data(key, len, i, out);				\
+		acc += out[0];						\
+	}								\
+	return acc;							\
+}
+
+#define VECTOR_VALUE(P, n, s, T)					\
+static uint64_t								\
+bench_##P##_##s(const void *key, size_t len, size_t iters)		\
+{									\
+	uint32_t out[n];						\
+	uint64_t acc = 0;						\
+	size_t i;							\
+	T v;								\
+									\
+	(void)len;							\
+	memcpy(&v, key, sizeof(v));					\
+	for (i = 0; i < iters; i++) {					\
+		P##_##s(v, i, out);					\
+		acc += out[0];						\
+	}								\
+	return acc;							\
+}
+
+#define VECTOR_ARRAY(P, n, s, T)					\
+static uint64_t								\
+bench_##P##_##s(const void *key, size_t len, size_t iters)		\
+{									\
+	uint32_t out[n];						\
+	uint64_t acc = 0;						\
+	size_t i;							\
+									\
+	for (i = 0; i < iters; i++) {					\
+		P##_##s((const T *)key, len / sizeof(T), i, out);	\
+		acc += out[0];						\
+	}								\
+	return acc;							\
+}
+
+#define VECTOR_BATCH(P, n, s, T)					\
+static uint64_t								\
+bench_##P##_##s(const void *key, size_t len, size_t iters)		\
+{									\
+	uint32_t out[n * NBATCH];					\
+	uint64_t acc = 0;						\
+	size_t i;							\
+									\
+	(void)len;							\
+	for (i = 0; i < iters; i += NBATCH) {				\
+		P##_##s((const T *)key, NBATCH, i, out);		\
+		acc += out[0];						\
+	}								\
+	return acc;							\
+}
+
+#define SCALAR_DATA(P, n)						\
+static uint64_t								\
+bench_##P##_data(const void *key, size_t len, size_t iters)		\
+{									\
+	uint64_t acc = 0;						\
+	size_t i;							\
+									\
+	for (i = 0; i < iters; i++)					\
+		acc += P##_data(key, len, i);				\
+	return acc;							\
+}
+
+#define SCALAR_VALUE(P, n, s, T)					\
+static uint64_t								\
+bench_##P##_##s(const void *key, size_t len, size_t iters)		\
+{									\
+	uint64_t acc = 0;						\
+	size_t i;							\
+	T v;								\
+									\
+	(void)len;							\
+	memcpy(&v, key, sizeof(v));					\
+	for (i = 0; i < iters; i++)					\
+		acc += P##_##s(v, i);					\
+	return acc;							\
+}
+
+#define SCALAR_ARRAY(P, n, s, T)					\
+static uint64_t								\
+bench_##P##_##s(const void *key, size_t len, size_t iters)		\
+{									\
+	uint64_t acc = 0;						\
+	size_t i;							\
+									\
+	for (i = 0; i < iters; i++)					\
+		acc += P##_##s((const T *)key, len / sizeof(T), i);	\
+	return acc;							\
+}
+
+#define SCALAR_BATCH(P, n, s, T)					\
+static uint64_t								\
+bench_##P##_##s(const void *key, size_t len, size_t iters)		\
+{									\
+	uint64_t out[NBATCH];						\
+	uint64_t acc = 0;						\
+	size_t i;							\
+									\
+	(void)len;							\
+	for (i = 0; i < iters; i += NBATCH) {				\
+		P##_##s((const T *)key, NBATCH, i, (void *)out);	\
+		acc += out[0];						\
+	}								\
+	return acc;							\
+}
+
+/* Hashes without batch variants. */
+#define BENCH_FUNCS_NOBATCH(K, P, n)					\
+	K##_DATA(P, n)							\
+	K##_VALUE(P, n, u8,  uint8_t)					\
+	K##_VALUE(P, n, u16, uint16_t)					\
+	K##_VALUE(P, n, u32, uint32_t)					\
+	K##_VALUE(P, n, u64, uint64_t)					\
+	K##_VALUE(P, n, f32, float)					\
+	K##_VALUE(P, n, f64, double)					\
+	K##_ARRAY(P, n, u8a,  uint8_t)					\
+	K##_ARRAY(P, n, u16a, uint16_t)					\
+	K##_ARRAY(P, n, u32a, uint32_t)					\
+	K##_ARRAY(P, n, u64a, uint64_t)					\
+	K##_ARRAY(P, n, f32a, float)					\
+	K##_ARRAY(P, n, f64a, double)
+
+#define BENCH_FUNCS(K, P, n)						\
+	BENCH_FUNCS_NOBATCH(K, P, n)					\
+	K##_BATCH(P, n, u32_batch, uint32_t)				\
+	K##_BATCH(P, n, u64_batch, uint64_t)
+
+BENCH_FUNCS(VECTOR, rgph_u32x3_jenkins2v, 3)
+BENCH_FUNCS(VECTOR, rgph_u32x4_murmur32v, 4)
+BENCH_FUNCS(SCALAR, rgph_u32_murmur32s, 1)
+BENCH_FUNCS(SCALAR, rgph_u32_xxh32s, 1)
+BENCH_FUNCS(SCALAR, rgph_u64_xxh64s, 1)
+BENCH_FUNCS(SCALAR, rgph_u64_t1ha64s, 1)
+BENCH_FUNCS_NOBATCH(VECTOR, rgph_u32x4_aes128v, 4)
+BENCH_FUNCS_NOBATCH(VECTOR, rgph_u32x4_xxh128v, 4)
+
+#define VARIANTS_NOBATCH(h, P)						\
+	{ h, "data", DATA,  1, &bench_##P##_data },			\
+	{ h, "u8",   VALUE, 1, &bench_##P##_u8   },			\
+	{ h, "u16",  VALUE, 2, &bench_##P##_u16  },			\
+	{ h, "u32",  VALUE, 4, &bench_##P##_u32  },			\
+	{ h, "u64",  VALUE, 8, &bench_##P##_u64  },			\
+	{ h, "f32",  VALUE, 4, &bench_##P##_f32  },			\
+	{ h, "f64",  VALUE, 8, &bench_##P##_f64  },			\
+	{ h, "u8a",  ARRAY, 1, &bench_##P##_u8a  },			\
+	{ h, "u16a", ARRAY, 2, &bench_##P##_u16a },			\
+	{ h, "u32a", ARRAY, 4, &bench_##P##_u32a },			\
+	{ h, "u64a", ARRAY, 8, &bench_##P##_u64a },			\
+	{ h, "f32a", ARRAY, 4, &bench_##P##_f32a },			\
+	{ h, "f64a", ARRAY, 8, &bench_##P##_f64a }
+
+#define VARIANTS(h, P)							\
+	VARIANTS_NOBATCH(h, P),						\
+	{ h, "u32_batch", BATCH, 4, &bench_##P##_u32_batch },		\
+	{ h, "u64_batch", BATCH, 8, &bench_##P##_u64_batch }
+
+static const struct variant variants[] = {
+	VARIANTS("jenkins2v", rgph_u32x3_jenkins2v),
+	VARIANTS("murmur32v", rgph_u32x4_murmur32v),
+	VARIANTS("murmur32s", rgph_u32_murmur32s),
+	VARIANTS("xxh32s",    rgph_u32_xxh32s),
+	VARIANTS("xxh64s",    rgph_u64_xxh64s),
+	VARIANTS("t1ha64s",   rgph_u64_t1ha64s),
+	VARIANTS_NOBATCH("aes128v", rgph_u32x4_aes128v),
+	VARIANTS_NOBATCH("xxh128v", rgph_u32x4_xxh128v),
+	{ NULL, NULL, DATA, 0, NULL }
+};
+
+static const size_t default_lengths[] = {
+	1, 2, 3, 4, 5, 7, 8, 12, 13, 15, 16, 20, 24, 31, 32, 33, 48,
+	63, 64, 100, 128, 255, 256, 512, 1000, 1024, 2048, 4096, 0
+};
+
+static size_t budget = 1u << 22; /* Bytes hashed per measurement. */
+static size_t repeat = 3;
+static volatile uint64_t sink;
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint64_t
+cycles(void)
+{
+
+#ifdef HAVE_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Print the best of repeat runs.
+ */
+static void
+measure(struct variant const *v, const uint8_t *key, size_t len,
+    size_t misalign)
+{
+	size_t const iters = budget / (len + 16) + 16;
+	uint64_t ns, cyc, best_ns = UINT64_MAX, best_cyc = UINT64_MAX;
+	uint64_t t0, c0;
+	size_t i;
+
+	for (i = 0; i < repeat; i++) {
+		t0 = now_ns();
+		c0 = cycles();
+		sink += v->fn(key, len, iters);
+		cyc = cycles() - c0;
+		ns = now_ns() - t0;
+
+		if (ns < best_ns)
+			best_ns = ns;
+		if (cyc < best_cyc)
+			best_cyc = cyc;
+	}
+
+	printf("%s,%s,%zu,%zu,%zu,%.3f,%.3f\n", v->hash, v->name,
+	    len, misalign, iters, (double)best_ns / iters,
+	    (double)best_cyc / ((double)iters * len));
+}
+
+static void
+usage(void)
+{
+
+	fprintf(stderr, "usage: hash_bench [-a] [-b budget] [-H hash] "
+	    "[-r repeat] [-V variant] [len ...]\n");
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static uint64_t buf[(MAXLEN + NALIGN) / sizeof(uint64_t) + 1];
+	uint8_t *bytes = (uint8_t *)buf;
+	struct variant const *v;
+	const char *hash = NULL, *variant = NULL;
+	size_t *lengths;
+	size_t i, j, n = 0, misalign;
+	int all = 0, ch;
+
+	while ((ch = getopt(argc, argv, "ab:H:r:V:")) != -1) {
+		switch (ch) {
+		case 'a': all = 1; break;
+		case 'b': budget = strtoul(optarg, NULL, 0); break;
+		case 'H': hash = optarg; break;
+		case 'r': repeat = strtoul(optarg, NULL, 0); break;
+		case 'V': variant = optarg; break;
+		default:
+			usage();
+		}
+	}
+
+	if (repeat == 0)
+		usage();
+
+	lengths = calloc(MAXLEN + 1, sizeof(lengths[0]));
+	if (lengths == NULL)
+		err(EXIT_FAILURE, "calloc");
+
+	if (all) {
+		for (i = 1; i <= MAXLEN; i++)
+			lengths[n++] = i;
+	} else if (optind < argc) {
+		for (i = optind; i < (size_t)argc && n < MAXLEN; i++) {
+			lengths[n] = strtoul(argv[i], NULL, 0);
+			if (lengths[n] == 0 || lengths[n] > MAXLEN)
+				errx(EXIT_FAILURE, "bad length %s", argv[i]);
+			n++;
+		}
+	} else {
+		for (i = 0; default_lengths[i] != 0; i++)
+			lengths[n++] = default_lengths[i];
+	}
+
+	for (i = 0; i < sizeof(buf); i++)
+		bytes[i] = i * 0x9d + 0x3b;
+
+	printf("hash,variant,len,misalign,iters,ns_per_key,cycles_per_byte\n");
+
+	for (v = variants; v->hash != NULL; v++) {
+		if (hash != NULL && strcmp(hash, v->hash) != 0)
+			continue;
+		if (variant != NULL && strcmp(variant, v->name) != 0)
+			continue;
+
+		switch (v->kind) {
+		case VALUE:
+		case BATCH:
+			measure(v, bytes, v->elemsz, 0);
+			break;
+		case ARRAY:
+			for (j = 0; j < n; j++) {
+				if ((lengths[j] % v->elemsz) == 0)
+					measure(v, bytes, lengths[j], 0);
+			}
+			break;
+		case DATA:
+			for (j = 0; j < n; j++) {
+				for (misalign = 0; misalign < NALIGN; misalign++) {
+					measure(v, bytes + misalign,
+					    lengths[j], misalign);
+				}
+			}
+			break;
+		}
+	}
+
+	free(lengths);
+	return EXIT_SUCCESS;
+}
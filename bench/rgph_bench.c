@@ -0,0 +1,567 @@
+/*-
+ * Copyright (c) 2016 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Build and lookup benchmark.
+ *
+ * Every combination of hash, rank, algorithm and reduction selected
+ * on the command line is built in a separate process and reported
+ * as one CSV line on stdout. Peak memory is the child's maxrss, it
+ * includes the key set.
+ */
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rgph.h>
+
+struct key {
+	const void *key;
+	size_t keylen;
+};
+
+struct keyset {
+	struct key *keys;
+	size_t nkeys;
+};
+
+struct iterator_state {
+	struct keyset const *ks;
+	size_t pos;
+	struct rgph_entry entry;
+};
+
+struct name {
+	const char *name;
+	int flag;
+};
+
+struct row {
+	const char *status;
+	size_t nverts;
+	size_t tries;
+	uint64_t build_ns;      /* Sum over all tries. */
+	uint64_t last_build_ns; /* Last try only. */
+	uint64_t dup_ns;
+	uint64_t assign_ns;
+	uint64_t lookup_ns;     /* Per key. */
+	uint64_t batch_ns;      /* Per key. */
+	long maxrss_kb;
+	struct rgph_stats stats;
+};
+
+static const struct name hashes[] = {
+	{ "jenkins2v", RGPH_HASH_JENKINS2V },
+	{ "murmur32v", RGPH_HASH_MURMUR32V },
+	{ "murmur32s", RGPH_HASH_MURMUR32S },
+	{ "xxh32s",    RGPH_HASH_XXH32S    },
+	{ "xxh64s",    RGPH_HASH_XXH64S    },
+	{ "t1ha64s",   RGPH_HASH_T1HA64S   },
+	{ "aes128v",   RGPH_HASH_AES128V   },
+	{ "xxh128v",   RGPH_HASH_XXH128V   },
+	{ NULL, 0 }
+};
+
+static const struct name ranks[] = {
+	{ "2", RGPH_RANK2 },
+	{ "3", RGPH_RANK3 },
+	{ NULL, 0 }
+};
+
+static const struct name algos[] = {
+	{ "chm", RGPH_ALGO_CHM },
+	{ "bdz", RGPH_ALGO_BDZ },
+	{ NULL, 0 }
+};
+
+static const struct name reductions[] = {
+	{ "mod", RGPH_REDUCE_MOD },
+	{ "mul", RGPH_REDUCE_MUL },
+	{ NULL, 0 }
+};
+
+static size_t ntries = 20;
+static size_t nrounds = 3;
+static size_t batch = 64;
+static unsigned long seed = 0;
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint64_t
+splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += UINT64_C(0x9e3779b97f4a7c15));
+
+	z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return z ^ (z >> 31);
+}
+
+static const struct rgph_entry *
+iterator_func(void *state)
+{
+	struct iterator_state *s = state;
+	struct rgph_entry *res = &s->entry;
+
+	if (s->pos == s->ks->nkeys)
+		return NULL;
+
+	res->key = res->data = s->ks->keys[s->pos].key;
+	res->keylen = res->datalen = s->ks->keys[s->pos].keylen;
+	s->pos++;
+	return res;
+}
+
+static void
+rewind_state(struct iterator_state *s, struct keyset const *ks)
+{
+
+	memset(s, 0, sizeof(*s));
+	s->ks = ks;
+}
+
+/*
+ * Decimal keys "0", "1", ... or, when keylen isn't zero, fixed-length
+ * random keys. The first min(8, keylen) bytes of a fixed-length key
+ * are a bijection of its number, the rest is filler.
+ */
+static void
+synthetic_keys(struct keyset *ks, size_t nkeys, size_t keylen)
+{
+	uint64_t const odd = UINT64_C(0x9e3779b97f4a7c15);
+	uint64_t rnd = seed;
+	size_t const sz = keylen != 0 ? keylen : 21;
+	char *buf;
+	size_t i, j;
+
+	if (keylen != 0 && keylen < 8 &&
+	    nkeys - 1 > UINT64_MAX >> 8 * (8 - keylen)) {
+		errx(EXIT_FAILURE, "too many keys of length %zu", keylen);
+	}
+
+	ks->nkeys = nkeys;
+	ks->keys = calloc(nkeys, sizeof(ks->keys[0]));
+	buf = calloc(nkeys, sz);
+	if (ks->keys == NULL || buf == NULL)
+		err(EXIT_FAILURE, "calloc");
+
+	for (i = 0; i < nkeys; i++) {
+		char *key = &buf[i * sz];
+
+		ks->keys[i].key = key;
+		if (keylen == 0) {
+			ks->keys[i].keylen = snprintf(key, sz, "%zu", i);
+			continue;
+		}
+
+		/* Multiplication by an odd number is a bijection. */
+		uint64_t x = keylen < 8 ? i : i * odd;
+		for (j = 0; j < keylen && j < 8; j++)
+			key[j] = x >> 8 * j;
+		for (; j < keylen; j++) {
+			if ((j % 8) == 0)
+				x = splitmix64(&rnd);
+			key[j] = x >> 8 * (j % 8);
+		}
+		ks->keys[i].keylen = keylen;
+	}
+}
+
+/*
+ * One key per line without a newline character. Duplicates are
+ * reported as "dup" status.
+ */
+static void
+file_keys(struct keyset *ks, const char *filename, size_t maxkeys)
+{
+	FILE *f;
+	char *line = NULL;
+	size_t linecap = 0, cap = 0;
+	ssize_t len;
+
+	f = fopen(filename, "r");
+	if (f == NULL)
+		err(EXIT_FAILURE, "%s", filename);
+
+	ks->nkeys = 0;
+	ks->keys = NULL;
+
+	while (ks->nkeys < maxkeys && (len = getline(&line, &linecap, f)) > 0) {
+		if (line[len-1] == '\n')
+			line[--len] = '\0';
+
+		if (ks->nkeys == cap) {
+			cap = cap != 0 ? 2 * cap : 1024;
+			ks->keys = realloc(ks->keys, cap * sizeof(ks->keys[0]));
+			if (ks->keys == NULL)
+				err(EXIT_FAILURE, "realloc");
+		}
+
+		ks->keys[ks->nkeys].key = strdup(line);
+		ks->keys[ks->nkeys].keylen = len;
+		if (ks->keys[ks->nkeys].key == NULL)
+			err(EXIT_FAILURE, "strdup");
+		ks->nkeys++;
+	}
+
+	if (ferror(f))
+		err(EXIT_FAILURE, "%s", filename);
+
+	free(line);
+	fclose(f);
+}
+
+/*
+ * Parse a comma separated list of names into a bitmask of
+ * indices in the names array. NULL selects all names.
+ */
+static unsigned int
+parse_list(const char *opt, const struct name *names)
+{
+	unsigned int res = 0;
+	const char *s = opt;
+	size_t i, len;
+
+	if (opt == NULL)
+		return ~0u;
+
+	while (*s != '\0') {
+		len = strcspn(s, ",");
+		for (i = 0; names[i].name != NULL; i++) {
+			if (strlen(names[i].name) == len &&
+			    strncmp(names[i].name, s, len) == 0) {
+				res |= 1u << i;
+				break;
+			}
+		}
+
+		if (names[i].name == NULL)
+			errx(EXIT_FAILURE, "unknown name '%.*s'", (int)len, s);
+
+		s += len;
+		if (*s == ',')
+			s++;
+	}
+
+	return res;
+}
+
+/*
+ * CHM maps the key number to itself because the iterator doesn't
+ * set an index. BDZ maps keys to distinct vertices.
+ */
+static bool
+check_lookup(struct rgph_graph const *g, struct keyset const *ks, int algo)
+{
+	size_t const nverts = rgph_vertices(g);
+	uint8_t *seen;
+	uint64_t v;
+	size_t i;
+	bool res = true;
+
+	seen = calloc(nverts, 1);
+	if (seen == NULL)
+		err(EXIT_FAILURE, "calloc");
+
+	for (i = 0; i < ks->nkeys && res; i++) {
+		if (rgph_lookup(g, ks->keys[i].key,
+		    ks->keys[i].keylen, &v) != RGPH_SUCCESS) {
+			res = false;
+		} else if (algo == RGPH_ALGO_CHM) {
+			res = (v == i);
+		} else {
+			res = (v < nverts && !seen[v]);
+			if (res)
+				seen[v] = 1;
+		}
+	}
+
+	free(seen);
+	return res;
+}
+
+static uint64_t
+bench_lookup(struct rgph_graph const *g, struct keyset const *ks)
+{
+	uint64_t start, v;
+	size_t i, n;
+
+	start = now_ns();
+	for (n = 0; n < nrounds; n++) {
+		for (i = 0; i < ks->nkeys; i++) {
+			rgph_lookup(g, ks->keys[i].key,
+			    ks->keys[i].keylen, &v);
+		}
+	}
+
+	return (now_ns() - start) / (nrounds * ks->nkeys);
+}
+
+static uint64_t
+bench_batch(struct rgph_graph const *g, struct keyset const *ks)
+{
+	const void **keys;
+	size_t *keylens;
+	uint64_t *out;
+	uint64_t start, elapsed = 0;
+	size_t i, j, n, sz;
+
+	keys = calloc(batch, sizeof(keys[0]));
+	keylens = calloc(batch, sizeof(keylens[0]));
+	out = calloc(batch, sizeof(out[0]));
+	if (keys == NULL || keylens == NULL || out == NULL)
+		err(EXIT_FAILURE, "calloc");
+
+	for (n = 0; n < nrounds; n++) {
+		for (i = 0; i < ks->nkeys; i += batch) {
+			sz = ks->nkeys - i < batch ? ks->nkeys - i : batch;
+			for (j = 0; j < sz; j++) {
+				keys[j] = ks->keys[i + j].key;
+				keylens[j] = ks->keys[i + j].keylen;
+			}
+
+			start = now_ns();
+			rgph_lookup_batch(g, keys, keylens, sz, out);
+			elapsed += now_ns() - start;
+		}
+	}
+
+	free(out);
+	free(keylens);
+	free(keys);
+
+	return elapsed / (nrounds * ks->nkeys);
+}
+
+static void
+run(struct keyset const *ks, int flags, struct row *row)
+{
+	struct iterator_state state;
+	struct rgph_graph *g;
+	size_t dup[2];
+	uint64_t start;
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(ks->nkeys, flags);
+	if (g == NULL) {
+		row->status = errno == ERANGE ? "range" : "nomem";
+		return;
+	}
+
+	row->nverts = rgph_vertices(g);
+
+	for (row->tries = 0; row->tries < ntries && res == RGPH_AGAIN; ) {
+		rewind_state(&state, ks);
+		start = now_ns();
+		res = rgph_build_graph(g, flags & ~RGPH_RANK_MASK, NULL,
+		    seed + row->tries, &iterator_func, &state);
+		row->last_build_ns = now_ns() - start;
+		row->build_ns += row->last_build_ns;
+		row->tries++;
+	}
+
+	if (res == RGPH_AGAIN) {
+		rewind_state(&state, ks);
+		start = now_ns();
+		res = rgph_find_duplicates(g, &iterator_func, &state, dup);
+		row->dup_ns = now_ns() - start;
+		row->status = res == RGPH_SUCCESS ? "dup" : "again";
+		goto out;
+	} else if (res != RGPH_SUCCESS) {
+		row->status = res == RGPH_RANGE ? "range" : "error";
+		goto out;
+	}
+
+	start = now_ns();
+	res = rgph_assign(g, flags & RGPH_ALGO_MASK);
+	row->assign_ns = now_ns() - start;
+	if (res != RGPH_SUCCESS) {
+		row->status = "error";
+		goto out;
+	}
+
+	if (!check_lookup(g, ks, flags & RGPH_ALGO_MASK)) {
+		row->status = "mismatch";
+		goto out;
+	}
+
+	row->lookup_ns = bench_lookup(g, ks);
+	row->batch_ns = bench_batch(g, ks);
+	row->status = "ok";
+out:
+	rgph_get_stats(g, &row->stats);
+	rgph_free_graph(g);
+}
+
+static void
+print_row(struct keyset const *ks, const struct name *h, const struct name *r,
+    const struct name *a, const struct name *m, struct row const *row)
+{
+	uint64_t const ns = row->build_ns + row->assign_ns;
+	bool const ok = strcmp(row->status, "ok") == 0;
+	double const kps = ok && ns != 0 ? 1e9 * ks->nkeys / ns : 0.0;
+
+	printf("%s,%s,%s,%s,%zu,%zu,%s,%zu,%" PRIu64 ",%" PRIu64
+	    ",%" PRIu64 ",%" PRIu64 ",%.0f,%" PRIu64 ",%" PRIu64 ",%ld"
+	    ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%zu\n",
+	    h->name, r->name, a->name, m->name, ks->nkeys, row->nverts,
+	    row->status, row->tries, row->build_ns, row->last_build_ns,
+	    row->dup_ns, row->assign_ns, kps, row->lookup_ns, row->batch_ns,
+	    row->maxrss_kb, row->stats.hash_ns, row->stats.add_edge_ns,
+	    row->stats.peel_ns, row->stats.allocated);
+}
+
+static void
+run_child(struct keyset const *ks, const struct name *h, const struct name *r,
+    const struct name *a, const struct name *m)
+{
+	struct rusage ru;
+	struct row row;
+	int const flags = h->flag | r->flag | a->flag | m->flag;
+
+	memset(&row, 0, sizeof(row));
+	run(ks, flags, &row);
+
+	if (getrusage(RUSAGE_SELF, &ru) == 0)
+		row.maxrss_kb = ru.ru_maxrss;
+
+	print_row(ks, h, r, a, m, &row);
+	fflush(stdout);
+}
+
+static void
+usage(void)
+{
+
+	fprintf(stderr, "usage: rgph_bench [-n nkeys] [-l keylen | -f file] "
+	    "[-s seed] [-t tries] [-r rounds] [-B batch]\n"
+	    "\t[-H hash,...] [-R rank,...] [-A algo,...] [-M reduce,...]\n");
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct keyset ks;
+	const char *filename = NULL;
+	const char *hopt = NULL, *ropt = NULL, *aopt = NULL, *mopt = NULL;
+	unsigned int hmask, rmask, amask, mmask;
+	size_t nkeys = 0, keylen = 0;
+	size_t h, r, a, m;
+	pid_t pid;
+	int ch, status;
+
+	while ((ch = getopt(argc, argv, "A:B:f:H:l:M:n:R:r:s:t:")) != -1) {
+		switch (ch) {
+		case 'A': aopt = optarg; break;
+		case 'B': batch = strtoul(optarg, NULL, 0); break;
+		case 'f': filename = optarg; break;
+		case 'H': hopt = optarg; break;
+		case 'l': keylen = strtoul(optarg, NULL, 0); break;
+		case 'M': mopt = optarg; break;
+		case 'n': nkeys = strtoul(optarg, NULL, 0); break;
+		case 'R': ropt = optarg; break;
+		case 'r': nrounds = strtoul(optarg, NULL, 0); break;
+		case 's': seed = strtoul(optarg, NULL, 0); break;
+		case 't': ntries = strtoul(optarg, NULL, 0); break;
+		default:
+			usage();
+		}
+	}
+
+	if (optind != argc || batch == 0 || nrounds == 0 || ntries == 0)
+		usage();
+
+	hmask = parse_list(hopt, hashes);
+	rmask = parse_list(ropt, ranks);
+	amask = parse_list(aopt, algos);
+	mmask = parse_list(mopt, reductions);
+
+	if (filename != NULL)
+		file_keys(&ks, filename, nkeys != 0 ? nkeys : SIZE_MAX);
+	else
+		synthetic_keys(&ks, nkeys != 0 ? nkeys : 100000, keylen);
+
+	if (ks.nkeys == 0)
+		errx(EXIT_FAILURE, "no keys");
+
+	printf("hash,rank,algo,reduce,nkeys,nverts,status,tries,"
+	    "build_ns,last_build_ns,dup_ns,assign_ns,keys_per_s,"
+	    "lookup_ns,batch_lookup_ns,maxrss_kb,"
+	    "hash_ns,add_edge_ns,peel_ns,alloc_bytes\n");
+
+	for (h = 0; hashes[h].name != NULL; h++)
+	for (r = 0; ranks[r].name != NULL; r++)
+	for (a = 0; algos[a].name != NULL; a++)
+	for (m = 0; reductions[m].name != NULL; m++) {
+		if (!(hmask & 1u << h) || !(rmask & 1u << r) ||
+		    !(amask & 1u << a) || !(mmask & 1u << m)) {
+			continue;
+		}
+
+		fflush(stdout);
+		pid = fork();
+		if (pid == -1)
+			err(EXIT_FAILURE, "fork");
+
+		if (pid == 0) {
+			run_child(&ks, &hashes[h], &ranks[r],
+			    &algos[a], &reductions[m]);
+			_exit(EXIT_SUCCESS);
+		}
+
+		if (waitpid(pid, &status, 0) == -1)
+			err(EXIT_FAILURE, "waitpid");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			warnx("%s,%s,%s,%s: child failed", hashes[h].name,
+			    ranks[r].name, algos[a].name, reductions[m].name);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
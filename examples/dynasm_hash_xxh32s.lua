@@ -1,6 +1,6 @@
 local dasm   = require "dasm"
-local dynasm = require "dynasm" -- to load dynasm_hash.dasl file
-local hash   = require "dynasm_hash"
+local dynasm = require "dynasm" -- to load rgph_jit.dasl file
+local hash   = require "rgph_jit"
 local pretty = require "pl.pretty"
 
 local args = { ... }
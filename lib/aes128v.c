@@ -0,0 +1,295 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * AES based 128bit hash. Every 16 byte block of a key goes through
+ * one AES encryption round (AESENC) and the state is finalised with
+ * three more rounds. It's not a cryptographic hash.
+ *
+ * This file is compiled once with portable rounds and then included
+ * by aes128v-aesni.c to use AES-NI instructions. Both copies produce
+ * identical results. The public name dispatches in cpu.c.
+ */
+#include "rgph_hash_impl.h"
+#include "rgph_cpu.h"
+
+#if !defined(RGPH_AES128V_ISA)
+#define RGPH_AES128V_ISA generic
+#endif
+
+#define rgph_u32x4_aes128v_data \
+	RGPH_ISA_NAME(rgph_u32x4_aes128v_data, RGPH_AES128V_ISA)
+
+#include "rgph_hash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(RGPH_AES128V_AESNI)
+#include <wmmintrin.h>
+
+typedef __m128i block_t;
+
+static inline block_t
+block_set(uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3)
+{
+
+	return _mm_set_epi32(w3, w2, w1, w0);
+}
+
+static inline block_t
+block_load(const uint8_t *ptr)
+{
+
+	return _mm_loadu_si128((const __m128i *)ptr);
+}
+
+static inline void
+block_store(block_t b, uint32_t *h)
+{
+
+	_mm_storeu_si128((__m128i *)h, b);
+}
+
+static inline block_t
+block_xor(block_t a, block_t b)
+{
+
+	return _mm_xor_si128(a, b);
+}
+
+static inline block_t
+aes_round(block_t s, block_t k)
+{
+
+	return _mm_aesenc_si128(s, k);
+}
+#else
+/* Four little-endian columns of the AES state. */
+typedef struct {
+	uint32_t w[4];
+} block_t;
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+	0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+	0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc,
+	0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a,
+	0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+	0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+	0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85,
+	0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+	0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17,
+	0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+	0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+	0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9,
+	0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6,
+	0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+	0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94,
+	0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68,
+	0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static inline block_t
+block_set(uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3)
+{
+	block_t b = { { w0, w1, w2, w3 } };
+
+	return b;
+}
+
+static inline block_t
+block_load(const uint8_t *ptr)
+{
+	block_t b;
+	int i;
+
+	memcpy(b.w, ptr, sizeof(b.w));
+	for (i = 0; i < 4; i++)
+		b.w[i] = htole32(b.w[i]);
+
+	return b;
+}
+
+static inline void
+block_store(block_t b, uint32_t *h)
+{
+
+	h[0] = b.w[0];
+	h[1] = b.w[1];
+	h[2] = b.w[2];
+	h[3] = b.w[3];
+}
+
+static inline block_t
+block_xor(block_t a, block_t b)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		a.w[i] ^= b.w[i];
+
+	return a;
+}
+
+/*
+ * Multiply four bytes by x in GF(2^8).
+ */
+static inline uint32_t
+xtime(uint32_t x)
+{
+
+	return ((x & UINT32_C(0x7f7f7f7f)) << 1) ^
+	    (((x >> 7) & UINT32_C(0x01010101)) * 0x1b);
+}
+
+/*
+ * Same as AESENC: ShiftRows, SubBytes, MixColumns and AddRoundKey.
+ */
+static inline block_t
+aes_round(block_t s, block_t k)
+{
+	block_t r;
+	uint32_t t;
+	int c;
+
+	for (c = 0; c < 4; c++) {
+		t = (uint32_t)sbox[s.w[c] & 0xff] |
+		    (uint32_t)sbox[(s.w[(c + 1) & 3] >> 8) & 0xff] << 8 |
+		    (uint32_t)sbox[(s.w[(c + 2) & 3] >> 16) & 0xff] << 16 |
+		    (uint32_t)sbox[s.w[(c + 3) & 3] >> 24] << 24;
+		r.w[c] = xtime(t) ^ xtime(rgph_rotr(t, 8)) ^ rgph_rotr(t, 8) ^
+		    rgph_rotr(t, 16) ^ rgph_rotr(t, 24) ^ k.w[c];
+	}
+
+	return r;
+}
+#endif /* RGPH_AES128V_AESNI */
+
+/*
+ * Read 32bit and 64bit words from any pointer in little-endian order.
+ */
+static inline uint32_t
+read32(const uint8_t *ptr)
+{
+	uint32_t w;
+
+	memcpy(&w, ptr, sizeof(w));
+	return htole32(w);
+}
+
+static inline uint64_t
+read64(const uint8_t *ptr)
+{
+	uint64_t w;
+
+	memcpy(&w, ptr, sizeof(w));
+	return htole64(w);
+}
+
+/*
+ * Load the last 0-15 bytes of a key padded with zeroes without
+ * reading past the end.
+ */
+static inline block_t
+block_tail(const uint8_t *key, size_t n)
+{
+	const uint8_t *end = key + n;
+	uint64_t lo = 0, hi = 0;
+
+	if (n > 8) {
+		lo = read64(key);
+		hi = read64(end - 8) >> (CHAR_BIT * (16 - n));
+	} else if (n == 8) {
+		lo = read64(key);
+	} else if (n >= 4) {
+		lo = read32(key) |
+		    (uint64_t)read32(end - 4) >> (CHAR_BIT * (8 - n)) << 32;
+	} else if (n > 0) {
+		lo = key[0] | (uint64_t)key[n / 2] << (CHAR_BIT * (n / 2)) |
+		    (uint64_t)key[n - 1] << (CHAR_BIT * (n - 1));
+	}
+
+	return block_set(lo, lo >> 32, hi, hi >> 32);
+}
+
+inline void
+rgph_u32x4_aes128v_data(const void *data,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+	const uint8_t *key = data;
+	const uint8_t *end = key + len;
+	const block_t k0 = block_set(RGPH_AES128V_K0);
+	const block_t k1 = block_set(RGPH_AES128V_K1);
+	const block_t k2 = block_set(RGPH_AES128V_K2);
+	const block_t k3 = block_set(RGPH_AES128V_K3);
+	const uint64_t s = seed, l = len;
+	block_t h0, h1;
+
+	h0 = block_set(s, s >> 32, l, l >> 32);
+	h1 = block_xor(h0, k1);
+	h0 = block_xor(h0, k0);
+
+	/* Two independent chains hide the latency of AESENC. */
+	for (; end - key >= 32; key += 32) {
+		h0 = aes_round(block_xor(h0, block_load(&key[0])), k2);
+		h1 = aes_round(block_xor(h1, block_load(&key[16])), k3);
+	}
+
+	if (end - key >= 16) {
+		h0 = aes_round(block_xor(h0, block_load(key)), k2);
+		key += 16;
+	}
+
+	h1 = aes_round(block_xor(h1, block_tail(key, end - key)), k3);
+
+	h0 = aes_round(h0, h1);
+	h0 = aes_round(h0, k0);
+	h0 = aes_round(h0, k1);
+
+	block_store(h0, h);
+}
+
+RGPH_FIXED_VECTOR(rgph_u32x4_aes128v_data, uint32_t)
@@ -0,0 +1,606 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Batch hashes of fixed width keys. Each function hashes an array of
+ * keys in blocks of RGPH_BATCH_LANES and produces exactly the same
+ * values as the corresponding _data function applied to every key.
+ *
+ * Lanes are GCC vector extensions. The compiler picks SSE2, AVX2 or
+ * AVX-512 instructions depending on a target. Other compilers get
+ * scalar code with a single lane.
+ *
+ * This file is compiled once for a generic target and then included
+ * by batch-<isa>.c files for other targets. Every copy defines its
+ * kernels with an _<isa> suffix and exports them in a table named
+ * rgph_batch_kernels_<isa>. Public names dispatch in cpu.c.
+ */
+#include "rgph_hash_impl.h"
+#include "rgph_cpu.h"
+
+#if !defined(RGPH_BATCH_ISA)
+#define RGPH_BATCH_ISA generic
+#endif
+
+#define BATCH_NAME(name) RGPH_ISA_NAME(name, RGPH_BATCH_ISA)
+
+#define rgph_u32x3_jenkins2v_u32_batch \
+	BATCH_NAME(rgph_u32x3_jenkins2v_u32_batch)
+#define rgph_u32x3_jenkins2v_u64_batch \
+	BATCH_NAME(rgph_u32x3_jenkins2v_u64_batch)
+#define rgph_u32x4_murmur32v_u32_batch \
+	BATCH_NAME(rgph_u32x4_murmur32v_u32_batch)
+#define rgph_u32x4_murmur32v_u64_batch \
+	BATCH_NAME(rgph_u32x4_murmur32v_u64_batch)
+#define rgph_u32_murmur32s_u32_batch BATCH_NAME(rgph_u32_murmur32s_u32_batch)
+#define rgph_u32_murmur32s_u64_batch BATCH_NAME(rgph_u32_murmur32s_u64_batch)
+#define rgph_u32_xxh32s_u32_batch    BATCH_NAME(rgph_u32_xxh32s_u32_batch)
+#define rgph_u32_xxh32s_u64_batch    BATCH_NAME(rgph_u32_xxh32s_u64_batch)
+#define rgph_u64_xxh64s_u32_batch    BATCH_NAME(rgph_u64_xxh64s_u32_batch)
+#define rgph_u64_xxh64s_u64_batch    BATCH_NAME(rgph_u64_xxh64s_u64_batch)
+#define rgph_u64_t1ha64s_u32_batch   BATCH_NAME(rgph_u64_t1ha64s_u32_batch)
+#define rgph_u64_t1ha64s_u64_batch   BATCH_NAME(rgph_u64_t1ha64s_u64_batch)
+
+#include "rgph_hash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#if !defined(RGPH_BATCH_LANES)
+#define RGPH_BATCH_LANES 8
+#endif
+typedef uint32_t v32_t __attribute__((vector_size(4 * RGPH_BATCH_LANES)));
+typedef uint64_t v64_t __attribute__((vector_size(8 * RGPH_BATCH_LANES)));
+#define lane(v, i) ((v)[i])
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_convertvector)
+#define convert(v, T) __builtin_convertvector(v, T)
+#endif
+#endif
+#else
+#undef RGPH_BATCH_LANES
+#define RGPH_BATCH_LANES 1
+typedef uint32_t v32_t;
+typedef uint64_t v64_t;
+#define lane(v, i) (v)
+#endif
+
+#define LANES RGPH_BATCH_LANES
+
+/* Broadcast x to all lanes. */
+#define splat32(x) ((v32_t){ 0 } + (uint32_t)(x))
+
+/*
+ * rgph_rotl() doesn't work for vectors because sizeof(x)
+ * is a size of the whole vector.
+ */
+#define rotl32(x, l) (((x) << (l)) | ((x) >> (32 - (l))))
+#define rotl64(x, l) (((x) << (l)) | ((x) >> (64 - (l))))
+
+/*
+ * Hash full blocks of LANES keys in place and pass remaining keys
+ * through zero padded buffers. All loops inside block functions have
+ * a constant trip count and compile to plain vector loads and stores.
+ */
+#define BATCH(block, K, H, width, keys, nkeys, seed, out) do {		\
+	K tail_keys[LANES];						\
+	H tail_out[LANES * (width)];					\
+									\
+	for (; nkeys >= LANES; nkeys -= LANES) {			\
+		block(keys, seed, out);					\
+		keys += LANES;						\
+		out += LANES * (width);					\
+	}								\
+									\
+	if (nkeys > 0) {						\
+		memset(tail_keys, 0, sizeof(tail_keys));		\
+		memcpy(tail_keys, keys, nkeys * sizeof(K));		\
+		block(tail_keys, seed, tail_out);			\
+		memcpy(out, tail_out, nkeys * (width) * sizeof(H));	\
+	}								\
+} while (0)
+
+/*
+ * Loads on little-endian hosts are plain vector loads. Going through
+ * a temporary array is slower because it defeats store forwarding.
+ */
+static inline void
+load_u32(const uint32_t *keys, v32_t *v)
+{
+#if BYTE_ORDER == LITTLE_ENDIAN
+	memcpy(v, keys, sizeof(*v));
+#else
+	uint32_t w[LANES];
+	size_t i;
+
+	for (i = 0; i < LANES; i++)
+		w[i] = htole32(keys[i]);
+
+	memcpy(v, w, sizeof(w));
+#endif
+}
+
+static inline void
+load_u64(const uint64_t *keys, v64_t *v)
+{
+#if BYTE_ORDER == LITTLE_ENDIAN
+	memcpy(v, keys, sizeof(*v));
+#else
+	uint64_t w[LANES];
+	size_t i;
+
+	for (i = 0; i < LANES; i++)
+		w[i] = htole64(keys[i]);
+
+	memcpy(v, w, sizeof(w));
+#endif
+}
+
+static inline void
+load_u32_wide(const uint32_t *keys, v64_t *v)
+{
+#if defined(convert)
+	v32_t k;
+
+	load_u32(keys, &k);
+	*v = convert(k, v64_t);
+#else
+	uint64_t w[LANES];
+	size_t i;
+
+	for (i = 0; i < LANES; i++)
+		w[i] = htole32(keys[i]);
+
+	memcpy(v, w, sizeof(w));
+#endif
+}
+
+static inline void
+load_u64_halves(const uint64_t *keys, v32_t *lo, v32_t *hi)
+{
+#if defined(convert)
+	v64_t k;
+
+	load_u64(keys, &k);
+	*lo = convert(k, v32_t);
+	*hi = convert(k >> 32, v32_t);
+#else
+	uint32_t l[LANES], h[LANES];
+	size_t i;
+
+	for (i = 0; i < LANES; i++) {
+		l[i] = htole64(keys[i]) & UINT32_MAX;
+		h[i] = htole64(keys[i]) >> 32;
+	}
+
+	memcpy(lo, l, sizeof(l));
+	memcpy(hi, h, sizeof(h));
+#endif
+}
+
+/*
+ * Interleave width vectors into out, e.g. h[0][0], h[1][0], h[2][0],
+ * h[0][1], h[1][1], h[2][1] and so on for width 3.
+ */
+static inline void
+store_u32(const v32_t *h, size_t width, uint32_t *out)
+{
+	size_t i, j;
+
+	for (i = 0; i < LANES; i++) {
+		for (j = 0; j < width; j++)
+			out[i * width + j] = lane(h[j], i);
+	}
+}
+
+static inline void
+jenkins2_mix(v32_t h[/* static 3 */])
+{
+
+	h[0] -= h[1]; h[0] -= h[2]; h[0] ^= (h[2] >> 13);
+	h[1] -= h[2]; h[1] -= h[0]; h[1] ^= (h[0] << 8);
+	h[2] -= h[0]; h[2] -= h[1]; h[2] ^= (h[1] >> 13);
+	h[0] -= h[1]; h[0] -= h[2]; h[0] ^= (h[2] >> 12);
+	h[1] -= h[2]; h[1] -= h[0]; h[1] ^= (h[0] << 16);
+	h[2] -= h[0]; h[2] -= h[1]; h[2] ^= (h[1] >> 5);
+	h[0] -= h[1]; h[0] -= h[2]; h[0] ^= (h[2] >> 3);
+	h[1] -= h[2]; h[1] -= h[0]; h[1] ^= (h[0] << 10);
+	h[2] -= h[0]; h[2] -= h[1]; h[2] ^= (h[1] >> 15);
+}
+
+static inline void
+jenkins2v_block_u32(const uint32_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t h[3];
+
+	load_u32(keys, &h[0]);
+	h[0] += RGPH_JENKINS2V_SEED1;
+	h[1] = splat32(RGPH_JENKINS2V_SEED2);
+	h[2] = splat32(seed + sizeof(*keys));
+	jenkins2_mix(h);
+	store_u32(h, 3, out);
+}
+
+static inline void
+jenkins2v_block_u64(const uint64_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t h[3];
+
+	load_u64_halves(keys, &h[0], &h[1]);
+	h[0] += RGPH_JENKINS2V_SEED1;
+	h[1] += RGPH_JENKINS2V_SEED2;
+	h[2] = splat32(seed + sizeof(*keys));
+	jenkins2_mix(h);
+	store_u32(h, 3, out);
+}
+
+void
+rgph_u32x3_jenkins2v_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(jenkins2v_block_u32, uint32_t, uint32_t, 3,
+	    keys, nkeys, seed, out);
+}
+
+void
+rgph_u32x3_jenkins2v_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(jenkins2v_block_u64, uint64_t, uint32_t, 3,
+	    keys, nkeys, seed, out);
+}
+
+static inline void
+murmur32_fmix(v32_t *h)
+{
+
+	*h ^= *h >> 16;
+	*h *= RGPH_MURMUR32V_FMIXMUL1;
+	*h ^= *h >> 13;
+	*h *= RGPH_MURMUR32V_FMIXMUL2;
+	*h ^= *h >> 16;
+}
+
+/*
+ * Keys shorter than 16 bytes mix only h[0] and h[1]. Lanes of h[1]
+ * are left intact by 4 byte keys because the high half is zero.
+ */
+static inline void
+murmur32v_block(v32_t *lo, v32_t *hi, uint32_t len,
+    uintptr_t seed, uint32_t *out)
+{
+	v32_t h[4];
+	size_t i;
+
+	*lo *= RGPH_MURMUR32V_MUL1;
+	*lo = rotl32(*lo, 15) * RGPH_MURMUR32V_MUL2;
+	h[0] = *lo ^ (uint32_t)seed;
+
+	*hi *= RGPH_MURMUR32V_MUL2;
+	*hi = rotl32(*hi, 16) * RGPH_MURMUR32V_MUL3;
+	h[1] = *hi ^ (uint32_t)seed;
+
+	h[2] = h[3] = splat32(seed);
+
+	for (i = 0; i < 4; i++)
+		h[i] ^= len;
+
+	h[0] += h[1]; h[0] += h[2]; h[0] += h[3];
+	h[1] += h[0]; h[2] += h[0]; h[3] += h[0];
+
+	for (i = 0; i < 4; i++)
+		murmur32_fmix(&h[i]);
+
+	h[0] += h[1]; h[0] += h[2]; h[0] += h[3];
+	h[1] += h[0]; h[2] += h[0]; h[3] += h[0];
+
+	store_u32(h, 4, out);
+}
+
+static inline void
+murmur32v_block_u32(const uint32_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t lo, hi = splat32(0);
+
+	load_u32(keys, &lo);
+	murmur32v_block(&lo, &hi, sizeof(*keys), seed, out);
+}
+
+static inline void
+murmur32v_block_u64(const uint64_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t lo, hi;
+
+	load_u64_halves(keys, &lo, &hi);
+	murmur32v_block(&lo, &hi, sizeof(*keys), seed, out);
+}
+
+void
+rgph_u32x4_murmur32v_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(murmur32v_block_u32, uint32_t, uint32_t, 4,
+	    keys, nkeys, seed, out);
+}
+
+void
+rgph_u32x4_murmur32v_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(murmur32v_block_u64, uint64_t, uint32_t, 4,
+	    keys, nkeys, seed, out);
+}
+
+static inline void
+murmur32s_mix(const v32_t *w, v32_t *h)
+{
+	v32_t k;
+
+	k = *w * RGPH_MURMUR32S_MUL1;
+	k = rotl32(k, 15);
+	k *= RGPH_MURMUR32S_MUL2;
+	*h ^= k;
+	*h = rotl32(*h, 13);
+	*h = 5 * *h + RGPH_MURMUR32S_ADD1;
+}
+
+/*
+ * The last mix of a zero tail is a no-op and it's omitted.
+ */
+static inline void
+murmur32s_finalise(uint32_t len, v32_t *h)
+{
+
+	*h ^= len;
+	*h ^= *h >> 16;
+	*h *= RGPH_MURMUR32S_FMIXMUL1;
+	*h ^= *h >> 13;
+	*h *= RGPH_MURMUR32S_FMIXMUL2;
+	*h ^= *h >> 16;
+}
+
+static inline void
+murmur32s_block_u32(const uint32_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t h = splat32(seed), k;
+
+	load_u32(keys, &k);
+	murmur32s_mix(&k, &h);
+	murmur32s_finalise(sizeof(*keys), &h);
+	memcpy(out, &h, sizeof(h));
+}
+
+static inline void
+murmur32s_block_u64(const uint64_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t h = splat32(seed), lo, hi;
+
+	load_u64_halves(keys, &lo, &hi);
+	murmur32s_mix(&lo, &h);
+	murmur32s_mix(&hi, &h);
+	murmur32s_finalise(sizeof(*keys), &h);
+	memcpy(out, &h, sizeof(h));
+}
+
+void
+rgph_u32_murmur32s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(murmur32s_block_u32, uint32_t, uint32_t, 1,
+	    keys, nkeys, seed, out);
+}
+
+void
+rgph_u32_murmur32s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(murmur32s_block_u64, uint64_t, uint32_t, 1,
+	    keys, nkeys, seed, out);
+}
+
+static inline void
+xxh32s_fmix4(const v32_t *w, v32_t *h)
+{
+
+	*h += *w * RGPH_XXH32S_PRIME3;
+	*h = rotl32(*h, 17) * RGPH_XXH32S_PRIME4;
+}
+
+static inline void
+xxh32s_finalise(v32_t *h)
+{
+
+	*h ^= *h >> 15;
+	*h *= RGPH_XXH32S_PRIME2;
+	*h ^= *h >> 13;
+	*h *= RGPH_XXH32S_PRIME3;
+	*h ^= *h >> 16;
+}
+
+/*
+ * Short keys skip the xxHash stripe loop. The initial value
+ * is seed + PRIME5 + len.
+ */
+static inline void
+xxh32s_block_u32(const uint32_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t h, k;
+
+	h = splat32((uint32_t)seed + RGPH_XXH32S_PRIME5 + sizeof(*keys));
+	load_u32(keys, &k);
+	xxh32s_fmix4(&k, &h);
+	xxh32s_finalise(&h);
+	memcpy(out, &h, sizeof(h));
+}
+
+static inline void
+xxh32s_block_u64(const uint64_t *keys, uintptr_t seed, uint32_t *out)
+{
+	v32_t h, lo, hi;
+
+	h = splat32((uint32_t)seed + RGPH_XXH32S_PRIME5 + sizeof(*keys));
+	load_u64_halves(keys, &lo, &hi);
+	xxh32s_fmix4(&lo, &h);
+	xxh32s_fmix4(&hi, &h);
+	xxh32s_finalise(&h);
+	memcpy(out, &h, sizeof(h));
+}
+
+void
+rgph_u32_xxh32s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(xxh32s_block_u32, uint32_t, uint32_t, 1,
+	    keys, nkeys, seed, out);
+}
+
+void
+rgph_u32_xxh32s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	BATCH(xxh32s_block_u64, uint64_t, uint32_t, 1,
+	    keys, nkeys, seed, out);
+}
+
+static inline void
+xxh64s_finalise(v64_t *h)
+{
+
+	*h ^= *h >> 33;
+	*h *= RGPH_XXH64S_PRIME2;
+	*h ^= *h >> 29;
+	*h *= RGPH_XXH64S_PRIME3;
+	*h ^= *h >> 32;
+}
+
+/*
+ * Note that rgph_xxh64s_init() truncates the seed to 32 bits.
+ */
+static inline void
+xxh64s_block_u32(const uint32_t *keys, uintptr_t seed, uint64_t *out)
+{
+	const uint64_t h0 = (uint32_t)seed + RGPH_XXH64S_PRIME5 + 4;
+	v64_t h, k;
+
+	load_u32_wide(keys, &k);
+	h = (k * RGPH_XXH64S_PRIME1) ^ h0;
+	h = rotl64(h, 23) * RGPH_XXH64S_PRIME2 + RGPH_XXH64S_PRIME3;
+	xxh64s_finalise(&h);
+	memcpy(out, &h, sizeof(h));
+}
+
+static inline void
+xxh64s_block_u64(const uint64_t *keys, uintptr_t seed, uint64_t *out)
+{
+	const uint64_t h0 = (uint32_t)seed + RGPH_XXH64S_PRIME5 + 8;
+	v64_t h, k;
+
+	load_u64(keys, &k);
+	k *= RGPH_XXH64S_PRIME2;
+	k = rotl64(k, 31) * RGPH_XXH64S_PRIME1;
+	h = k ^ h0;
+	h = rotl64(h, 27) * RGPH_XXH64S_PRIME1 + RGPH_XXH64S_PRIME4;
+	xxh64s_finalise(&h);
+	memcpy(out, &h, sizeof(h));
+}
+
+void
+rgph_u64_xxh64s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+
+	BATCH(xxh64s_block_u32, uint32_t, uint64_t, 1,
+	    keys, nkeys, seed, out);
+}
+
+void
+rgph_u64_xxh64s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+
+	BATCH(xxh64s_block_u64, uint64_t, uint64_t, 1,
+	    keys, nkeys, seed, out);
+}
+
+/*
+ * t1ha needs a full 64x64->128 multiplication which doesn't map to
+ * SIMD lanes. Plain loops are still faster than calling _data.
+ */
+void
+rgph_u64_t1ha64s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+	uint64_t h[4];
+	size_t i;
+
+	for (i = 0; i < nkeys; i++) {
+		rgph_t1ha64s_init(sizeof(*keys), seed, h);
+		rgph_t1ha64s_fmix1(htole32(keys[i]), h);
+		out[i] = rgph_t1ha64s_finalise(h);
+	}
+}
+
+void
+rgph_u64_t1ha64s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+	uint64_t h[4];
+	size_t i;
+
+	for (i = 0; i < nkeys; i++) {
+		rgph_t1ha64s_init(sizeof(*keys), seed, h);
+		rgph_t1ha64s_fmix1(htole64(keys[i]), h);
+		out[i] = rgph_t1ha64s_finalise(h);
+	}
+}
+
+const struct rgph_batch_kernels BATCH_NAME(rgph_batch_kernels) = {
+	&rgph_u32x3_jenkins2v_u32_batch,
+	&rgph_u32x3_jenkins2v_u64_batch,
+	&rgph_u32x4_murmur32v_u32_batch,
+	&rgph_u32x4_murmur32v_u64_batch,
+	&rgph_u32_murmur32s_u32_batch,
+	&rgph_u32_murmur32s_u64_batch,
+	&rgph_u32_xxh32s_u32_batch,
+	&rgph_u32_xxh32s_u64_batch,
+	&rgph_u64_xxh64s_u32_batch,
+	&rgph_u64_xxh64s_u64_batch,
+	&rgph_u64_t1ha64s_u32_batch,
+	&rgph_u64_t1ha64s_u64_batch
+};
@@ -0,0 +1,357 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Runtime selection of hash kernels. The best kernels supported by
+ * the CPU are picked once. Set RGPH_KERNELS to generic, unaligned,
+ * sse4.2, avx2 or avx512 to force other kernels. Unsupported or
+ * unknown names are ignored. The x86 kernels use AES-NI for
+ * the aes128v hash if the CPU has it.
+ */
+#include "rgph_cpu.h"
+#include "rgph_hash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct candidate {
+	struct rgph_kernels kernels;
+	int (*supported)(void);
+};
+
+static const struct rgph_data_kernels rgph_data_kernels_generic = {
+	&rgph_u32x3_jenkins2v_data,
+	&rgph_u32x4_murmur32v_data,
+	&rgph_u32_murmur32s_data,
+	&rgph_u32_xxh32s_data,
+	&rgph_u64_xxh64s_data,
+	&rgph_u64_t1ha64s_data,
+	&rgph_u32x4_aes128v_data_generic,
+	&rgph_u32x4_xxh128v_data,
+	&rgph_u32x3_jenkins2v_data_batch
+};
+
+#define FIXED_KERNELS(n) {                      \
+	&rgph_u32x3_jenkins2v_data_fixed##n,        \
+	&rgph_u32x4_murmur32v_data_fixed##n,        \
+	&rgph_u32_murmur32s_data_fixed##n,          \
+	&rgph_u32_xxh32s_data_fixed##n,             \
+	&rgph_u64_xxh64s_data_fixed##n,             \
+	&rgph_u64_t1ha64s_data_fixed##n,            \
+	&rgph_u32x4_aes128v_data_generic_fixed##n,  \
+	&rgph_u32x4_xxh128v_data_fixed##n,          \
+	NULL                                        \
+}
+
+static const struct rgph_data_kernels
+    rgph_fixed_kernels_generic[RGPH_FIXED_NLENS] = {
+	FIXED_KERNELS(4),
+	FIXED_KERNELS(8),
+	FIXED_KERNELS(12),
+	FIXED_KERNELS(16),
+	FIXED_KERNELS(20),
+	FIXED_KERNELS(32)
+};
+
+static int
+always(void)
+{
+
+	return 1;
+}
+
+#if defined(RGPH_X86_KERNELS)
+static int
+has_aes(void)
+{
+
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("aes");
+}
+
+static int
+has_sse42(void)
+{
+
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+}
+
+static int
+has_avx2(void)
+{
+
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+static int
+has_avx512(void)
+{
+
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx512f") &&
+	    __builtin_cpu_supports("avx512dq");
+}
+
+static int
+has_sse42_aes(void)
+{
+
+	return has_sse42() && has_aes();
+}
+
+static int
+has_avx2_aes(void)
+{
+
+	return has_avx2() && has_aes();
+}
+
+static int
+has_avx512_aes(void)
+{
+
+	return has_avx512() && has_aes();
+}
+#endif
+
+/*
+ * Best kernels first. Batch kernels don't depend on AES-NI, each x86
+ * ISA is listed with and without the aes128v kernel that uses it.
+ */
+static const struct candidate candidates[] = {
+#if defined(RGPH_X86_KERNELS)
+	{ { "avx512", &rgph_data_kernels_aesni,
+	    &rgph_batch_kernels_avx512, rgph_fixed_kernels_aesni },
+	    &has_avx512_aes },
+	{ { "avx512", &rgph_data_kernels_unaligned,
+	    &rgph_batch_kernels_avx512, rgph_fixed_kernels_unaligned },
+	    &has_avx512 },
+	{ { "avx2", &rgph_data_kernels_aesni,
+	    &rgph_batch_kernels_avx2, rgph_fixed_kernels_aesni },
+	    &has_avx2_aes },
+	{ { "avx2", &rgph_data_kernels_unaligned,
+	    &rgph_batch_kernels_avx2, rgph_fixed_kernels_unaligned },
+	    &has_avx2 },
+	{ { "sse4.2", &rgph_data_kernels_aesni,
+	    &rgph_batch_kernels_sse42, rgph_fixed_kernels_aesni },
+	    &has_sse42_aes },
+	{ { "sse4.2", &rgph_data_kernels_unaligned,
+	    &rgph_batch_kernels_sse42, rgph_fixed_kernels_unaligned },
+	    &has_sse42 },
+#endif
+#if defined(RGPH_UNALIGNED_KERNELS)
+	{ { "unaligned", &rgph_data_kernels_unaligned,
+	    &rgph_batch_kernels_generic, rgph_fixed_kernels_unaligned },
+	    &always },
+#endif
+	{ { "generic", &rgph_data_kernels_generic,
+	    &rgph_batch_kernels_generic, rgph_fixed_kernels_generic },
+	    &always },
+	{ { NULL, NULL, NULL, NULL }, NULL }
+};
+
+static const struct rgph_kernels *selected;
+
+static const struct rgph_kernels *
+select_kernels(void)
+{
+	const char *name = getenv("RGPH_KERNELS");
+	const struct candidate *c;
+
+	for (c = candidates; name != NULL && c->supported != NULL; c++) {
+		if (strcmp(name, c->kernels.name) == 0 && c->supported())
+			return &c->kernels;
+	}
+
+	for (c = candidates; c->supported != NULL; c++) {
+		if (c->supported())
+			return &c->kernels;
+	}
+
+	return NULL; /* Not reached, generic kernels are always supported. */
+}
+
+const struct rgph_kernels *
+rgph_kernels(void)
+{
+	const struct rgph_kernels *k;
+
+	/*
+	 * Concurrent first callers select the same kernels, the last
+	 * store wins. Normally, the constructor runs first.
+	 */
+	k = __atomic_load_n(&selected, __ATOMIC_ACQUIRE);
+	if (k == NULL) {
+		k = select_kernels();
+		__atomic_store_n(&selected, k, __ATOMIC_RELEASE);
+	}
+
+	return k;
+}
+
+#if defined(__GNUC__)
+static void init_kernels(void) __attribute__((constructor));
+
+static void
+init_kernels(void)
+{
+
+	(void)rgph_kernels();
+}
+#endif
+
+const struct rgph_data_kernels *
+rgph_fixed_kernels(const struct rgph_kernels *k, size_t keylen)
+{
+
+	switch (keylen) {
+	case 4:  return &k->fixed[0];
+	case 8:  return &k->fixed[1];
+	case 12: return &k->fixed[2];
+	case 16: return &k->fixed[3];
+	case 20: return &k->fixed[4];
+	case 32: return &k->fixed[5];
+	default: return NULL;
+	}
+}
+
+const char *
+rgph_hash_kernels(void)
+{
+
+	return rgph_kernels()->name;
+}
+
+void
+rgph_u32x4_aes128v_data(const void *data,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_kernels()->data->aes128v(data, len, seed, h);
+}
+
+void
+rgph_u32x3_jenkins2v_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->jenkins2v_u32(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32x3_jenkins2v_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->jenkins2v_u64(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32x4_murmur32v_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->murmur32v_u32(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32x4_murmur32v_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->murmur32v_u64(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32_murmur32s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->murmur32s_u32(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32_murmur32s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->murmur32s_u64(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32_xxh32s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->xxh32s_u32(keys, nkeys, seed, out);
+}
+
+void
+rgph_u32_xxh32s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+
+	rgph_kernels()->batch->xxh32s_u64(keys, nkeys, seed, out);
+}
+
+void
+rgph_u64_xxh64s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+
+	rgph_kernels()->batch->xxh64s_u32(keys, nkeys, seed, out);
+}
+
+void
+rgph_u64_xxh64s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+
+	rgph_kernels()->batch->xxh64s_u64(keys, nkeys, seed, out);
+}
+
+void
+rgph_u64_t1ha64s_u32_batch(const uint32_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+
+	rgph_kernels()->batch->t1ha64s_u32(keys, nkeys, seed, out);
+}
+
+void
+rgph_u64_t1ha64s_u64_batch(const uint64_t *keys,
+    size_t nkeys, uintptr_t seed, uint64_t *out)
+{
+
+	rgph_kernels()->batch->t1ha64s_u64(keys, nkeys, seed, out);
+}
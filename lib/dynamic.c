@@ -0,0 +1,811 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rgph_defs.h"
+#include "rgph_dynamic.h"
+#include "rgph_graph.h"
+#include "rgph_hash.h"
+
+#define OVF_SEED      0x5eed0f10u /* Seed of overflow hashes. */
+#define OVF_MINSIZE   16
+#define REBUILD_TRIES 100         /* Seeds to try before giving up. */
+
+#define WORD_BITS (sizeof(unsigned long) * CHAR_BIT)
+
+/* States of overflow entries. */
+enum {
+	OVF_FREE = 0,
+	OVF_LIVE,
+	OVF_DELETED /* Hides a key of the static part or a frozen entry. */
+};
+
+struct ovf_entry {
+	uint64_t hash;
+	uint8_t *key; /* Copy of the key. */
+	size_t keylen;
+	uint64_t value;
+	int state;
+};
+
+/* Open addressing with linear probing, size is a power of 2. */
+struct overflow {
+	struct ovf_entry *slots;
+	size_t size;
+	size_t count;
+};
+
+/*
+ * Static part, entry i is keys[off[i]..off[i+1]) with values[i].
+ * The graph is built with implicit indices, so i is a lookup result.
+ */
+struct stable {
+	struct rgph_graph *g; /* NULL if there are no keys. */
+	uint8_t *keys;
+	size_t *off;
+	uint64_t *values;
+	unsigned long *dead;  /* Tombstones. */
+	size_t n;
+	size_t ndead;
+};
+
+struct rgph_dynamic {
+	pthread_rwlock_t lock; /* Protects st, ovf, frozen and nentries. */
+	struct stable st;
+	struct overflow ovf;
+	struct overflow frozen; /* Overflow being merged by a rebuild. */
+	int rebuilding;
+	size_t nentries;
+
+	pthread_mutex_t rebuild_lock; /* Serialises rebuilds. */
+	unsigned long seed;
+	size_t threshold;
+	int flags;
+
+	pthread_mutex_t wake_lock; /* Background thread. */
+	pthread_cond_t wake;
+	pthread_t thread;
+	int has_thread;
+	int pending;
+	int stop;
+};
+
+struct build_state {
+	struct rgph_entry ent;
+	const struct stable *st;
+	size_t i;
+};
+
+static uint64_t
+ovf_hash(const void *key, size_t keylen)
+{
+
+	return rgph_u64_xxh64s_data(key, keylen, OVF_SEED);
+}
+
+static struct ovf_entry *
+ovf_find(const struct overflow *t, uint64_t h, const void *key, size_t keylen)
+{
+	size_t i;
+
+	if (t->size == 0)
+		return NULL;
+
+	for (i = h & (t->size - 1); t->slots[i].state != OVF_FREE;
+	    i = (i + 1) & (t->size - 1)) {
+		struct ovf_entry *s = &t->slots[i];
+
+		if (s->hash == h && s->keylen == keylen &&
+		    memcmp(s->key, key, keylen) == 0) {
+			return s;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+ovf_place(struct overflow *t, const struct ovf_entry *ent)
+{
+	size_t i;
+
+	for (i = ent->hash & (t->size - 1); t->slots[i].state != OVF_FREE;
+	    i = (i + 1) & (t->size - 1)) {
+		continue;
+	}
+
+	t->slots[i] = *ent;
+}
+
+static int
+ovf_grow(struct overflow *t)
+{
+	struct overflow n;
+	size_t i;
+
+	n.size = t->size == 0 ? OVF_MINSIZE : 2 * t->size;
+	n.count = t->count;
+	n.slots = calloc(n.size, sizeof(n.slots[0]));
+	if (n.slots == NULL)
+		return RGPH_NOMEM;
+
+	for (i = 0; i < t->size; i++) {
+		if (t->slots[i].state != OVF_FREE)
+			ovf_place(&n, &t->slots[i]);
+	}
+
+	free(t->slots);
+	*t = n;
+	return RGPH_SUCCESS;
+}
+
+/* Add a new entry, the key must not be in the table. */
+static int
+ovf_add(struct overflow *t, uint64_t h, const void *key, size_t keylen,
+    uint64_t value, int state)
+{
+	struct ovf_entry ent;
+
+	if (2 * (t->count + 1) > t->size && ovf_grow(t) != RGPH_SUCCESS)
+		return RGPH_NOMEM;
+
+	ent.hash = h;
+	ent.keylen = keylen;
+	ent.value = value;
+	ent.state = state;
+	ent.key = malloc(keylen > 0 ? keylen : 1);
+	if (ent.key == NULL)
+		return RGPH_NOMEM;
+	memcpy(ent.key, key, keylen);
+
+	ovf_place(t, &ent);
+	t->count++;
+	return RGPH_SUCCESS;
+}
+
+/* Backward shift deletion, no tombstones in the probe sequence. */
+static void
+ovf_remove(struct overflow *t, struct ovf_entry *s)
+{
+	size_t const mask = t->size - 1;
+	size_t i = s - t->slots, j, k;
+
+	free(s->key);
+
+	for (j = (i + 1) & mask; t->slots[j].state != OVF_FREE;
+	    j = (j + 1) & mask) {
+		k = t->slots[j].hash & mask;
+		/* Move j to i unless k is cyclically in (i, j]. */
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		t->slots[i] = t->slots[j];
+		i = j;
+	}
+
+	memset(&t->slots[i], 0, sizeof(t->slots[i]));
+	t->count--;
+}
+
+static void
+ovf_free(struct overflow *t)
+{
+	size_t i;
+
+	for (i = 0; i < t->size; i++)
+		free(t->slots[i].key);
+	free(t->slots);
+	memset(t, 0, sizeof(*t));
+}
+
+static void
+stable_free(struct stable *st)
+{
+
+	rgph_free_graph(st->g);
+	free(st->keys);
+	free(st->off);
+	free(st->values);
+	free(st->dead);
+	memset(st, 0, sizeof(*st));
+}
+
+static int
+is_dead(const struct stable *st, size_t i)
+{
+
+	return (st->dead[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+static void
+set_dead(struct stable *st, size_t i)
+{
+
+	if (!is_dead(st, i)) {
+		st->dead[i / WORD_BITS] |= 1ul << (i % WORD_BITS);
+		st->ndead++;
+	}
+}
+
+/* Position of a key in the static part or SIZE_MAX. */
+static size_t
+stable_find(const struct stable *st, const void *key, size_t keylen)
+{
+	uint64_t i;
+
+	if (st->g == NULL ||
+	    rgph_lookup(st->g, key, keylen, &i) != RGPH_SUCCESS ||
+	    i >= st->n) {
+		return SIZE_MAX;
+	}
+
+	if (st->off[i + 1] - st->off[i] != keylen ||
+	    memcmp(&st->keys[st->off[i]], key, keylen) != 0) {
+		return SIZE_MAX;
+	}
+
+	return i;
+}
+
+/*
+ * Look a key up in the overflow, in the frozen overflow if there is
+ * a rebuild and in the static part, in that order. Return the entry
+ * state and set *pos to the static position if it's found there.
+ */
+static int
+find_locked(const struct rgph_dynamic *d, uint64_t h,
+    const void *key, size_t keylen, uint64_t *value, size_t *pos)
+{
+	const struct ovf_entry *s;
+	size_t i;
+
+	*pos = SIZE_MAX;
+
+	s = ovf_find(&d->ovf, h, key, keylen);
+	if (s == NULL && d->rebuilding)
+		s = ovf_find(&d->frozen, h, key, keylen);
+	if (s != NULL) {
+		*value = s->value;
+		return s->state;
+	}
+
+	i = stable_find(&d->st, key, keylen);
+	if (i == SIZE_MAX || is_dead(&d->st, i))
+		return OVF_FREE;
+
+	*pos = i;
+	*value = d->st.values[i];
+	return OVF_LIVE;
+}
+
+static void
+request_rebuild(struct rgph_dynamic *d, size_t changes)
+{
+
+	if (!d->has_thread || changes < d->threshold)
+		return;
+
+	pthread_mutex_lock(&d->wake_lock);
+	d->pending = 1;
+	pthread_cond_signal(&d->wake);
+	pthread_mutex_unlock(&d->wake_lock);
+}
+
+int
+rgph_dynamic_insert(struct rgph_dynamic *d,
+    const void *key, size_t keylen, uint64_t value)
+{
+	uint64_t const h = ovf_hash(key, keylen);
+	struct ovf_entry *s;
+	uint64_t old;
+	size_t changes, pos;
+	int added, res = RGPH_SUCCESS;
+
+	pthread_rwlock_wrlock(&d->lock);
+
+	added = find_locked(d, h, key, keylen, &old, &pos) != OVF_LIVE;
+	if (added)
+		d->nentries++;
+
+	s = ovf_find(&d->ovf, h, key, keylen);
+	if (s != NULL) {
+		s->value = value;
+		s->state = OVF_LIVE;
+	} else {
+		res = ovf_add(&d->ovf, h, key, keylen, value, OVF_LIVE);
+	}
+
+	if (res == RGPH_SUCCESS && pos != SIZE_MAX)
+		set_dead(&d->st, pos); /* The overflow entry replaces it. */
+	else if (res != RGPH_SUCCESS && added)
+		d->nentries--;
+
+	changes = d->ovf.count + d->st.ndead;
+	pthread_rwlock_unlock(&d->lock);
+
+	if (res == RGPH_NOMEM)
+		errno = ENOMEM;
+	else
+		request_rebuild(d, changes);
+
+	return res;
+}
+
+int
+rgph_dynamic_delete(struct rgph_dynamic *d, const void *key, size_t keylen)
+{
+	uint64_t const h = ovf_hash(key, keylen);
+	struct ovf_entry *s;
+	uint64_t value;
+	size_t changes, pos;
+	int res = RGPH_SUCCESS;
+
+	pthread_rwlock_wrlock(&d->lock);
+
+	if (find_locked(d, h, key, keylen, &value, &pos) != OVF_LIVE) {
+		pthread_rwlock_unlock(&d->lock);
+		return RGPH_NOKEY;
+	}
+
+	/*
+	 * A rebuild may have copied the key to the next static part,
+	 * keep a deleted entry to hide it there.
+	 */
+	s = ovf_find(&d->ovf, h, key, keylen);
+	if (s != NULL && d->rebuilding)
+		s->state = OVF_DELETED;
+	else if (s != NULL)
+		ovf_remove(&d->ovf, s);
+	else if (d->rebuilding)
+		res = ovf_add(&d->ovf, h, key, keylen, 0, OVF_DELETED);
+
+	if (res == RGPH_SUCCESS) {
+		if (pos != SIZE_MAX)
+			set_dead(&d->st, pos);
+		d->nentries--;
+	}
+
+	changes = d->ovf.count + d->st.ndead;
+	pthread_rwlock_unlock(&d->lock);
+
+	if (res == RGPH_NOMEM)
+		errno = ENOMEM;
+	else
+		request_rebuild(d, changes);
+
+	return res;
+}
+
+int
+rgph_dynamic_lookup(struct rgph_dynamic *d,
+    const void *key, size_t keylen, uint64_t *value)
+{
+	uint64_t const h = ovf_hash(key, keylen);
+	size_t pos;
+	int state;
+
+	pthread_rwlock_rdlock(&d->lock);
+	state = find_locked(d, h, key, keylen, value, &pos);
+	pthread_rwlock_unlock(&d->lock);
+
+	return state == OVF_LIVE ? RGPH_SUCCESS : RGPH_NOKEY;
+}
+
+static const struct rgph_entry *
+build_iter(void *raw_state)
+{
+	struct build_state *state = raw_state;
+	const struct stable *st = state->st;
+	size_t const i = state->i;
+
+	if (i == st->n)
+		return NULL;
+
+	state->ent.key = &st->keys[st->off[i]];
+	state->ent.keylen = st->off[i + 1] - st->off[i];
+	state->i++;
+	return &state->ent;
+}
+
+/* Copy live entries of the old static part and the frozen overflow. */
+static int
+collect(struct stable *st, const struct stable *old,
+    const unsigned long *olddead, const struct overflow *frozen)
+{
+	size_t i, n = 0, len = 0, nwords;
+
+	memset(st, 0, sizeof(*st));
+
+	for (i = 0; i < old->n; i++) {
+		if (!((olddead[i / WORD_BITS] >> (i % WORD_BITS)) & 1)) {
+			len += old->off[i + 1] - old->off[i];
+			n++;
+		}
+	}
+
+	for (i = 0; i < frozen->size; i++) {
+		if (frozen->slots[i].state == OVF_LIVE) {
+			len += frozen->slots[i].keylen;
+			n++;
+		}
+	}
+
+	nwords = n / WORD_BITS + 1;
+	st->keys = malloc(len > 0 ? len : 1);
+	st->off = malloc(sizeof(st->off[0]) * (n + 1));
+	st->values = malloc(sizeof(st->values[0]) * (n + 1));
+	st->dead = calloc(nwords, sizeof(st->dead[0]));
+	if (st->keys == NULL || st->off == NULL ||
+	    st->values == NULL || st->dead == NULL) {
+		stable_free(st);
+		return RGPH_NOMEM;
+	}
+
+	st->off[0] = 0;
+
+	for (i = 0; i < old->n; i++) {
+		size_t const keylen = old->off[i + 1] - old->off[i];
+
+		if ((olddead[i / WORD_BITS] >> (i % WORD_BITS)) & 1)
+			continue;
+		memcpy(&st->keys[st->off[st->n]],
+		    &old->keys[old->off[i]], keylen);
+		st->values[st->n] = old->values[i];
+		st->off[st->n + 1] = st->off[st->n] + keylen;
+		st->n++;
+	}
+
+	for (i = 0; i < frozen->size; i++) {
+		const struct ovf_entry *s = &frozen->slots[i];
+
+		if (s->state != OVF_LIVE)
+			continue;
+		memcpy(&st->keys[st->off[st->n]], s->key, s->keylen);
+		st->values[st->n] = s->value;
+		st->off[st->n + 1] = st->off[st->n] + s->keylen;
+		st->n++;
+	}
+
+	assert(st->n == n);
+	return RGPH_SUCCESS;
+}
+
+static int
+build_stable(struct rgph_dynamic *d, struct stable *st, unsigned long *seed)
+{
+	struct build_state state;
+	int i, res = RGPH_AGAIN;
+
+	if (st->n == 0)
+		return RGPH_SUCCESS;
+
+	st->g = rgph_alloc_graph(st->n, d->flags);
+	if (st->g == NULL)
+		return errno == ENOMEM ? RGPH_NOMEM : RGPH_RANGE;
+
+	for (i = 0; i < REBUILD_TRIES && res == RGPH_AGAIN; i++) {
+		memset(&state, 0, sizeof(state));
+		state.st = st;
+		res = rgph_build_graph(st->g, d->flags,
+		    NULL, (*seed)++, &build_iter, &state);
+	}
+
+	if (res == RGPH_SUCCESS)
+		res = rgph_assign(st->g, d->flags);
+
+	return res;
+}
+
+/*
+ * Put entries changed during a failed rebuild back. The merged table is
+ * reserved first, the merge either fails before it moves any entry or
+ * succeeds.
+ */
+static int
+unfreeze(struct rgph_dynamic *d)
+{
+	struct overflow *ovf = &d->ovf, *frozen = &d->frozen;
+	struct ovf_entry *s, *t;
+	size_t i;
+
+	while (2 * (frozen->count + ovf->count) > frozen->size) {
+		if (ovf_grow(frozen) != RGPH_SUCCESS)
+			return RGPH_NOMEM;
+	}
+
+	for (i = 0; i < ovf->size; i++) {
+		s = &ovf->slots[i];
+		if (s->state == OVF_FREE)
+			continue;
+
+		t = ovf_find(frozen, s->hash, s->key, s->keylen);
+		if (t != NULL) {
+			free(t->key);
+			*t = *s;
+		} else {
+			ovf_place(frozen, s);
+			frozen->count++;
+		}
+
+		memset(s, 0, sizeof(*s));
+		ovf->count--;
+	}
+
+	ovf_free(ovf);
+	*ovf = *frozen;
+	memset(frozen, 0, sizeof(*frozen));
+	return RGPH_SUCCESS;
+}
+
+/*
+ * Entries changed during a rebuild are in the new overflow. Hide their
+ * keys in the new static part and drop deleted entries.
+ */
+static void
+install(struct rgph_dynamic *d, struct stable *st)
+{
+	struct overflow *ovf = &d->ovf;
+	size_t i, pos;
+
+	for (i = 0; i < ovf->size; ) {
+		struct ovf_entry *s = &ovf->slots[i];
+
+		if (s->state == OVF_FREE) {
+			i++;
+			continue;
+		}
+
+		pos = stable_find(st, s->key, s->keylen);
+		if (pos != SIZE_MAX)
+			set_dead(st, pos);
+
+		/* Removal shifts another entry to i, check it again. */
+		if (s->state == OVF_DELETED)
+			ovf_remove(ovf, s);
+		else
+			i++;
+	}
+}
+
+int
+rgph_dynamic_rebuild(struct rgph_dynamic *d)
+{
+	struct stable st, old;
+	unsigned long *olddead;
+	size_t nwords;
+	unsigned long seed;
+	int res;
+
+	pthread_mutex_lock(&d->rebuild_lock);
+	pthread_rwlock_wrlock(&d->lock);
+
+	/*
+	 * A previous rebuild couldn't merge overflows, its frozen
+	 * overflow is still searched. Merge it now.
+	 */
+	if (d->rebuilding) {
+		if (unfreeze(d) != RGPH_SUCCESS) {
+			pthread_rwlock_unlock(&d->lock);
+			pthread_mutex_unlock(&d->rebuild_lock);
+			errno = ENOMEM;
+			return RGPH_NOMEM;
+		}
+		d->rebuilding = 0;
+	}
+
+	if (d->ovf.count == 0 && d->st.ndead == 0) {
+		pthread_rwlock_unlock(&d->lock);
+		pthread_mutex_unlock(&d->rebuild_lock);
+		return RGPH_SUCCESS;
+	}
+
+	/* Tombstones change during the rebuild, copy them. */
+	nwords = d->st.n / WORD_BITS + 1;
+	olddead = malloc(nwords * sizeof(olddead[0]));
+	if (olddead == NULL) {
+		pthread_rwlock_unlock(&d->lock);
+		pthread_mutex_unlock(&d->rebuild_lock);
+		errno = ENOMEM;
+		return RGPH_NOMEM;
+	}
+
+	memcpy(olddead, d->st.dead, nwords * sizeof(olddead[0]));
+	d->frozen = d->ovf;
+	memset(&d->ovf, 0, sizeof(d->ovf));
+	d->rebuilding = 1;
+	old = d->st;
+	seed = d->seed;
+
+	pthread_rwlock_unlock(&d->lock);
+
+	/* Readers and writers only touch d->ovf and tombstones now. */
+	res = collect(&st, &old, olddead, &d->frozen);
+	if (res == RGPH_SUCCESS)
+		res = build_stable(d, &st, &seed);
+	free(olddead);
+
+	pthread_rwlock_wrlock(&d->lock);
+
+	d->seed = seed;
+	if (res == RGPH_SUCCESS) {
+		install(d, &st);
+		old = d->st;
+		d->st = st;
+		ovf_free(&d->frozen);
+		d->rebuilding = 0;
+	} else {
+		stable_free(&st);
+		memset(&old, 0, sizeof(old));
+		/* Keep searching the frozen overflow if it fails. */
+		if (unfreeze(d) == RGPH_SUCCESS)
+			d->rebuilding = 0;
+		else
+			res = RGPH_NOMEM;
+	}
+
+	pthread_rwlock_unlock(&d->lock);
+	pthread_mutex_unlock(&d->rebuild_lock);
+
+	stable_free(&old);
+
+	if (res == RGPH_NOMEM)
+		errno = ENOMEM;
+
+	return res;
+}
+
+static void *
+rebuild_thread(void *arg)
+{
+	struct rgph_dynamic *d = arg;
+
+	pthread_mutex_lock(&d->wake_lock);
+	while (!d->stop) {
+		if (!d->pending) {
+			pthread_cond_wait(&d->wake, &d->wake_lock);
+			continue;
+		}
+
+		d->pending = 0;
+		pthread_mutex_unlock(&d->wake_lock);
+		(void)rgph_dynamic_rebuild(d);
+		pthread_mutex_lock(&d->wake_lock);
+	}
+	pthread_mutex_unlock(&d->wake_lock);
+
+	return NULL;
+}
+
+struct rgph_dynamic *
+rgph_dynamic_create(int flags, size_t threshold)
+{
+	struct rgph_dynamic *d;
+	struct rgph_graph *g;
+
+	/* Rebuilds don't take a hash function. */
+	if ((flags & RGPH_HASH_MASK) >= RGPH_HASH_CUSTOM) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	/* Values are stored at implicit indices. */
+	flags = (flags & ~RGPH_ALGO_MASK) | RGPH_ALGO_CHM;
+
+	g = rgph_alloc_graph(1, flags);
+	if (g == NULL)
+		return NULL;
+	rgph_free_graph(g);
+
+	d = calloc(1, sizeof(*d));
+	if (d == NULL)
+		return NULL;
+
+	d->st.dead = calloc(1, sizeof(d->st.dead[0]));
+	d->st.off = calloc(1, sizeof(d->st.off[0]));
+	if (d->st.dead == NULL || d->st.off == NULL) {
+		stable_free(&d->st);
+		free(d);
+		return NULL;
+	}
+
+	d->flags = flags;
+	d->threshold = threshold;
+
+	pthread_rwlock_init(&d->lock, NULL);
+	pthread_mutex_init(&d->rebuild_lock, NULL);
+	pthread_mutex_init(&d->wake_lock, NULL);
+	pthread_cond_init(&d->wake, NULL);
+
+	if (threshold > 0) {
+		errno = pthread_create(&d->thread, NULL, &rebuild_thread, d);
+		if (errno != 0) {
+			rgph_dynamic_destroy(d);
+			return NULL;
+		}
+		d->has_thread = 1;
+	}
+
+	return d;
+}
+
+void
+rgph_dynamic_destroy(struct rgph_dynamic *d)
+{
+
+	if (d == NULL)
+		return;
+
+	if (d->has_thread) {
+		pthread_mutex_lock(&d->wake_lock);
+		d->stop = 1;
+		pthread_cond_signal(&d->wake);
+		pthread_mutex_unlock(&d->wake_lock);
+		pthread_join(d->thread, NULL);
+	}
+
+	pthread_cond_destroy(&d->wake);
+	pthread_mutex_destroy(&d->wake_lock);
+	pthread_mutex_destroy(&d->rebuild_lock);
+	pthread_rwlock_destroy(&d->lock);
+
+	ovf_free(&d->ovf);
+	ovf_free(&d->frozen);
+	stable_free(&d->st);
+	free(d);
+}
+
+size_t
+rgph_dynamic_entries(struct rgph_dynamic *d)
+{
+	size_t res;
+
+	pthread_rwlock_rdlock(&d->lock);
+	res = d->nentries;
+	pthread_rwlock_unlock(&d->lock);
+
+	return res;
+}
+
+size_t
+rgph_dynamic_changes(struct rgph_dynamic *d)
+{
+	size_t res;
+
+	pthread_rwlock_rdlock(&d->lock);
+	res = d->ovf.count + d->st.ndead;
+	pthread_rwlock_unlock(&d->lock);
+
+	return res;
+}
@@ -42,24 +42,47 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "rgph_defs.h"
 #include "rgph_bitops.h"
 #include "rgph_fastdiv.h"
 #include "rgph_graph.h"
 #include "rgph_hash.h"
+#include "rgph_cpu.h"
 
 // Max chm index values.
 #define INDEX_MAX UINT32_MAX
 #define BIG_INDEX_MAX UINT64_MAX
 
+// Keys are hashed in chunks and then added to the graph.
+#define INIT_CHUNK 1024
+
+// Resumable builds check their time budget every STEP_CHUNK keys or
+// vertices, see rgph_build_step() and rgph_build_finish().
+#define STEP_CHUNK 4096
+
+// Fixed width keys are collected in batches for batch hash functions.
+#define BATCH_SIZE 64
+
+// Keys of other lengths are hashed in small groups by interleaved hash
+// functions. Shorter keys are faster to hash one by one. Keys are copied
+// when a graph is built, longer keys are hashed one by one there.
+#define DATA_BATCH_SIZE 4
+#define DATA_BATCH_MINLEN 32
+#define DATA_BATCH_MAXLEN 256
+
 // Max nkeys values.
-#define MAX_NKEYS_R2_VEC 0x78787877u // Vector hashes.
-#define MAX_NKEYS_R2_S64 0x78787877u // Scalar 64 hashes.
-#define MAX_NKEYS_R2_S32 0x00007878u // Scalar 32 hashes.
-#define MAX_NKEYS_R3_VEC 0xcccccccau // Vector hashes.
-#define MAX_NKEYS_R3_S64 0x00266666u // Scalar 64 hashes.
-#define MAX_NKEYS_R3_S32 0x000004ccu // Scalar 32 hashes.
+#define MAX_NKEYS_R2_VEC 0x78787877u // Vector and built-in scalar 64 hashes.
+#define MAX_NKEYS_R2_S64 0x78787877u // Custom scalar 64 hashes.
+#define MAX_NKEYS_R2_S32 0x00007878u // Custom scalar 32 hashes.
+#define MAX_NKEYS_R3_VEC 0xcccccccau // Vector and built-in scalar 64 hashes.
+#define MAX_NKEYS_R3_S64 0x00266666u // Custom scalar 64 hashes.
+#define MAX_NKEYS_R3_S32 0x000004ccu // Custom scalar 32 hashes.
+
+// Vertices of built-in scalar 32 hashes are derived from 32 bits, more
+// keys would often collide on the whole hash value.
+#define MAX_NKEYS_DERIVED32 0x00010000u
 
 namespace {
 
@@ -68,7 +91,10 @@ enum {
 	BUILT    = 0x20000000, // Graph is built.
 	PEELED   = 0x10000000, // Peel order index is built.
 	ASSIGNED = 0x08000000, // Assignment step is done.
-	PUBLIC_FLAGS = 0xffff
+	STEPPING = 0x04000000, // Resumable build is in progress.
+	SCANNED  = 0x02000000, // Resumable peel has scanned all vertices.
+	PUSHING  = 0x01000000, // Keys are added by rgph_builder_add().
+	PUBLIC_FLAGS = 0x1ffff
 };
 
 typedef uint32_t vert_t;         // Vertex or key; V in templates.
@@ -128,37 +154,94 @@ struct entry_iterator {
 inline bool operator==(entry_iterator const &, entry_iterator const &);
 inline bool operator!=(entry_iterator const &, entry_iterator const &);
 
+// Iterator that ends early when a budget of keys or time runs out.
+// It never reads a key it isn't going to return.
+struct budget_iterator : entry_iterator {
+	size_t left;       // Keys to read.
+	uint64_t deadline; // now_ns() value, zero if unlimited.
+	bool exhausted;
+
+	inline budget_iterator();
+	inline budget_iterator(rgph_entry_iterator_t i, void *s,
+	    size_t maxkeys, uint64_t deadline);
+
+	inline void operator++();
+};
+
 // Vector hash initialises an array of R hash values.
 template<class V, int R, class H>
 struct vector_hash {
 	static bool constexpr zerocopy = sizeof(H) == sizeof(V);
 
 	typedef void (*func_t)(void const *, size_t, uintptr_t, H *);
+	typedef void (*batch32_t)(uint32_t const *, size_t, uintptr_t, H *);
+	typedef void (*batch64_t)(uint64_t const *, size_t, uintptr_t, H *);
+	typedef void (*data_batch_t)(void const * const *, size_t const *,
+	    size_t, uintptr_t, H *);
 
 	func_t const func;
+	batch32_t const batch32; // Optional, hashes 4 byte keys.
+	batch64_t const batch64; // Optional, hashes 8 byte keys.
+	data_batch_t const data_batch; // Optional, hashes other keys.
+	size_t const width;      // Number of H values per key.
 	uintptr_t const seed;
+	func_t fixed;            // Hashes keys of fixedlen bytes.
+	size_t fixedlen;
 	mutable V hashes[zerocopy ? 4 : R]; // Some hashes are x4.
 
 	inline vector_hash(func_t f, uintptr_t seed);
+	inline vector_hash(func_t f, batch32_t b32, batch64_t b64,
+	    data_batch_t db, size_t width, uintptr_t seed);
 
 	inline V const *operator()(void const *, size_t) const;
 
+	// Hash n <= BATCH_SIZE fixed width keys, store R hashes per key.
+	template<class T, class B>
+	inline void batch(B, T const *, size_t, V (*)[R]) const;
+
+	// Hash n <= DATA_BATCH_SIZE keys with data_batch.
+	inline void batch_data(void const * const *, size_t const *, size_t,
+	    V (*)[R]) const;
+
 	inline V const *impl(void const *, size_t, V (&)[4]) const;
 	inline V const *impl(void const *, size_t, V (&)[R]) const;
 };
 
-// Scalar hash splits a scalar hash of type H into R hashes of type V.
+// Scalar hash derives R hashes of type V from a scalar hash of type H.
+// Every derived hash is a full 32bit value, unlike bits of H split into
+// R narrow fields, so partitions aren't limited by a width of H.
 template<class V, int R, class H>
 struct scalar_hash {
 	typedef H (*func_t)(void const *, size_t, uintptr_t);
+	typedef void (*batch32_t)(uint32_t const *, size_t, uintptr_t, H *);
+	typedef void (*batch64_t)(uint64_t const *, size_t, uintptr_t, H *);
+	typedef void (*data_batch_t)(void const * const *, size_t const *,
+	    size_t, uintptr_t, H *);
 
 	func_t const func;
+	batch32_t const batch32; // Optional, hashes 4 byte keys.
+	batch64_t const batch64; // Optional, hashes 8 byte keys.
+	data_batch_t const data_batch; // Not implemented, always nullptr.
 	uintptr_t const seed;
+	func_t fixed;            // Hashes keys of fixedlen bytes.
+	size_t fixedlen;
 	mutable V hashes[R];
 
 	inline scalar_hash(func_t f, uintptr_t seed);
+	inline scalar_hash(func_t f, batch32_t b32, batch64_t b64,
+	    uintptr_t seed);
 
 	inline V const *operator()(void const *, size_t) const;
+
+	// Hash n <= BATCH_SIZE fixed width keys, store R hashes per key.
+	template<class T, class B>
+	inline void batch(B, T const *, size_t, V (*)[R]) const;
+
+	// Hash n <= DATA_BATCH_SIZE keys with data_batch.
+	inline void batch_data(void const * const *, size_t const *, size_t,
+	    V (*)[R]) const;
+
+	static inline void derive(H, V *);
 };
 
 // Partition a graph using fast_remainder32(3) from NetBSD.
@@ -195,6 +278,24 @@ struct chm_assigner {
 	inline X operator()(vert_t, size_t) const;
 };
 
+// Pick a vertex of an edge in rgph_lookup() of bdz graph.
+template<class V, int R>
+struct bdz_lookup {
+	uint8_t const *g;
+
+	inline uint64_t operator()(V const *) const;
+};
+
+// Recover an index of an edge in rgph_lookup() of chm graph.
+template<class X, class V, int R>
+struct chm_lookup {
+	X const *g;
+	big_index_t mod; // Zero if assignments wrap around 2^(32|64).
+	big_index_t min;
+
+	inline uint64_t operator()(V const *) const;
+};
+
 } // anon namespace
 
 struct rgph_graph {
@@ -213,10 +314,17 @@ struct rgph_graph {
 	size_t core_size; // R-core size.
 	size_t datalenmin;
 	size_t datalenmax;
+	size_t keylen;    // Length of the first key, see with_hash().
 	big_index_t indexmin;
 	big_index_t indexmax;
+	rgph_vector_hash_t hash; // Custom hash, saved for rgph_lookup().
 	uintptr_t seed;
+	size_t build_pos; // Edges added by rgph_build_step().
+	size_t peel_pos;  // Next vertex to scan or next order element to peel
+	size_t peel_top;  // and the top of order in rgph_build_finish().
 	unsigned int flags;
+	struct rgph_stats stats;
+	struct rgph_peel_stats peel_stats; // Only with RGPH_INSTRUMENT.
 };
 
 namespace {
@@ -277,6 +385,74 @@ add_edge(oedge<V,3> *oedges, V e, V const *verts)
 	add_remove_oedge(oedges, 1, e, verts[2], verts[0], verts[1]);
 }
 
+// Thread-safe add_edge() for rgph_builder_add(). Peeling starts after
+// all threads are done, relaxed ordering is enough.
+template<class V>
+inline void
+atomic_add_oedge(oedge<V,2> *oedges, V e, V v0, V v1)
+{
+
+	__atomic_fetch_xor(&oedges[v0].overts[0], v1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&oedges[v0].degree, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_xor(&oedges[v0].edge, e, __ATOMIC_RELAXED);
+}
+
+template<class V>
+inline void
+atomic_add_oedge(oedge<V,3> *oedges, V e, V v0, V v1, V v2)
+{
+
+	__atomic_fetch_xor(&oedges[v0].overts[v1 < v2 ? 0 : 1], v1,
+	    __ATOMIC_RELAXED);
+	__atomic_fetch_xor(&oedges[v0].overts[v1 < v2 ? 1 : 0], v2,
+	    __ATOMIC_RELAXED);
+	__atomic_fetch_add(&oedges[v0].degree, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_xor(&oedges[v0].edge, e, __ATOMIC_RELAXED);
+}
+
+template<class V>
+inline void
+atomic_add_edge(oedge<V,2> *oedges, V e, V const *verts)
+{
+
+	atomic_add_oedge(oedges, e, verts[0], verts[1]);
+	atomic_add_oedge(oedges, e, verts[1], verts[0]);
+}
+
+template<class V>
+inline void
+atomic_add_edge(oedge<V,3> *oedges, V e, V const *verts)
+{
+
+	atomic_add_oedge(oedges, e, verts[0], verts[1], verts[2]);
+	atomic_add_oedge(oedges, e, verts[1], verts[0], verts[2]);
+	atomic_add_oedge(oedges, e, verts[2], verts[0], verts[1]);
+}
+
+template<class T>
+inline void
+atomic_min(T *p, T val)
+{
+	T cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+
+	while (val < cur && !__atomic_compare_exchange_n(p, &cur, val,
+	    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		continue;
+	}
+}
+
+template<class T>
+inline void
+atomic_max(T *p, T val)
+{
+	T cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+
+	while (val > cur && !__atomic_compare_exchange_n(p, &cur, val,
+	    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		continue;
+	}
+}
+
 template<class V>
 inline size_t
 remove_vertex(oedge<V,2> *oedges, V v0, V *order, size_t top)
@@ -311,6 +487,15 @@ remove_vertex(oedge<V,3> *oedges, V v0, V *order, size_t top)
 	return top;
 }
 
+inline uint64_t
+now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return uint64_t(ts.tv_sec) * 1000000000u + ts.tv_nsec;
+}
+
 // fast_divide32(3) from NetBSD.
 inline uint32_t
 fastdiv(uint32_t val, uint64_t mul, uint8_t s2)
@@ -364,6 +549,37 @@ entry_iterator::operator*() const
 	return *cur;
 }
 
+inline budget_iterator::budget_iterator()
+	: left(0)
+	, deadline(0)
+	, exhausted(false)
+{}
+
+inline budget_iterator::budget_iterator(rgph_entry_iterator_t i, void *s,
+    size_t maxkeys, uint64_t d)
+	: left(maxkeys)
+	, deadline(d)
+	, exhausted(maxkeys == 0)
+{
+
+	iter = i;
+	state = s;
+	cur = exhausted ? nullptr : iter(state);
+}
+
+inline void
+budget_iterator::operator++()
+{
+
+	if (--left == 0 || (deadline != 0 && left % STEP_CHUNK == 0 &&
+	    now_ns() >= deadline)) {
+		cur = nullptr;
+		exhausted = true;
+	} else {
+		cur = iter(state);
+	}
+}
+
 inline bool
 operator==(entry_iterator const &a, entry_iterator const &b)
 {
@@ -382,7 +598,27 @@ template<class V, int R, class H>
 inline
 vector_hash<V,R,H>::vector_hash(func_t f, uintptr_t seed)
 	: func(f)
+	, batch32(nullptr)
+	, batch64(nullptr)
+	, data_batch(nullptr)
+	, width(4)
+	, seed(seed)
+	, fixed(f)
+	, fixedlen(0)
+{}
+
+template<class V, int R, class H>
+inline
+vector_hash<V,R,H>::vector_hash(func_t f, batch32_t b32, batch64_t b64,
+    data_batch_t db, size_t width, uintptr_t seed)
+	: func(f)
+	, batch32(b32)
+	, batch64(b64)
+	, data_batch(db)
+	, width(width)
 	, seed(seed)
+	, fixed(f)
+	, fixedlen(0)
 {}
 
 template<class V, int R, class H>
@@ -391,7 +627,7 @@ vector_hash<V,R,H>::impl(void const *key, size_t keylen, V (&hashes)[4]) const
 {
 	static_assert(zerocopy, "Type dispatch didn't work.");
 
-	func(key, keylen, seed, hashes);
+	(keylen == fixedlen ? fixed : func)(key, keylen, seed, hashes);
 	return hashes;
 }
 
@@ -403,7 +639,7 @@ vector_hash<V,R,H>::impl(void const *key, size_t keylen, V (&hashes)[R]) const
 
 	H h[4]; // Some hashes are x4.
 
-	func(key, keylen, seed, h);
+	(keylen == fixedlen ? fixed : func)(key, keylen, seed, h);
 	for (size_t i = 0; i < R; i++)
 		hashes[i] = h[i];
 	return hashes;
@@ -417,28 +653,113 @@ vector_hash<V,R,H>::operator()(void const *key, size_t keylen) const
 	return this->impl(key, keylen, hashes); // Type dispatch.
 }
 
+template<class V, int R, class H>
+template<class T, class B>
+inline void
+vector_hash<V,R,H>::batch(B b, T const *keys, size_t n, V (*verts)[R]) const
+{
+	H h[BATCH_SIZE * 4]; // Some hashes are x4.
+
+	assert(n <= BATCH_SIZE && width <= 4);
+
+	b(keys, n, seed, h);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t r = 0; r < R; r++)
+			verts[i][r] = h[i * width + r];
+	}
+}
+
+template<class V, int R, class H>
+inline void
+vector_hash<V,R,H>::batch_data(void const * const *keys,
+    size_t const *keylens, size_t n, V (*verts)[R]) const
+{
+	H h[DATA_BATCH_SIZE * 4]; // Some hashes are x4.
+
+	assert(n <= DATA_BATCH_SIZE && width <= 4);
+
+	data_batch(keys, keylens, n, seed, h);
+	for (size_t i = 0; i < n; i++) {
+		for (size_t r = 0; r < R; r++)
+			verts[i][r] = h[i * width + r];
+	}
+}
+
 template<class V, int R, class H>
 inline
 scalar_hash<V,R,H>::scalar_hash(func_t f, uintptr_t seed)
 	: func(f)
+	, batch32(nullptr)
+	, batch64(nullptr)
+	, data_batch(nullptr)
+	, seed(seed)
+	, fixed(f)
+	, fixedlen(0)
+{}
+
+template<class V, int R, class H>
+inline
+scalar_hash<V,R,H>::scalar_hash(func_t f, batch32_t b32, batch64_t b64,
+    uintptr_t seed)
+	: func(f)
+	, batch32(b32)
+	, batch64(b64)
+	, data_batch(nullptr)
 	, seed(seed)
+	, fixed(f)
+	, fixedlen(0)
 {}
 
+template<class V, int R, class H>
+inline void
+scalar_hash<V,R,H>::derive(H h, V *hashes)
+{
+
+	for (size_t r = 0; r < R; r++) {
+		uint64_t x = h + (r + 1) * RGPH_DERIVE_ADD;
+
+		x = (x ^ (x >> 32)) * RGPH_DERIVE_MUL;
+		hashes[r] = x ^ (x >> 32);
+	}
+}
+
 template<class V, int R, class H>
 inline V const *
 scalar_hash<V,R,H>::operator()(void const *key, size_t keylen) const
 {
-	size_t constexpr nbits = sizeof(H) * CHAR_BIT / R;
-	H constexpr mask = (H(1) << nbits) - 1;
-
-	H h = func(key, keylen, seed);
-	for (size_t i = 0; i < R-1; i++)
-		hashes[i] = (h >> i * nbits) & mask;
-	hashes[R-1] = h >> (sizeof(H) * CHAR_BIT - nbits);
 
+	derive((keylen == fixedlen ? fixed : func)(key, keylen, seed), hashes);
 	return hashes;
 }
 
+template<class V, int R, class H>
+template<class T, class B>
+inline void
+scalar_hash<V,R,H>::batch(B b, T const *keys, size_t n, V (*verts)[R]) const
+{
+	H h[BATCH_SIZE];
+
+	assert(n <= BATCH_SIZE);
+
+	b(keys, n, seed, h);
+	for (size_t i = 0; i < n; i++)
+		derive(h[i], verts[i]);
+}
+
+template<class V, int R, class H>
+inline void
+scalar_hash<V,R,H>::batch_data(void const * const *keys,
+    size_t const *keylens, size_t n, V (*verts)[R]) const
+{
+	H h[DATA_BATCH_SIZE];
+
+	assert(n <= DATA_BATCH_SIZE);
+
+	data_batch(keys, keylens, n, seed, h);
+	for (size_t i = 0; i < n; i++)
+		derive(h[i], verts[i]);
+}
+
 inline
 fastrem_partition::fastrem_partition(size_t nverts, size_t r)
 	: partsz(nverts / r)
@@ -490,6 +811,36 @@ chm_assigner<X>::operator()(vert_t e, size_t) const
 	return big || index != nullptr ? index[e] : e;
 }
 
+template<class V, int R>
+inline uint64_t
+bdz_lookup<V,R>::operator()(V const *verts) const
+{
+	unsigned int i = 0;
+
+	for (size_t r = 0; r < R; r++)
+		i += g[verts[r]];
+
+	return verts[i % R];
+}
+
+template<class X, class V, int R>
+inline uint64_t
+chm_lookup<X,V,R>::operator()(V const *verts) const
+{
+	big_index_t h = 0;
+
+	for (size_t r = 0; r < R; r++) {
+		big_index_t const a = g[verts[r]];
+
+		if (mod == 0)
+			h = static_cast<X>(h + a);
+		else
+			h = (a >= mod - h) ? a - (mod - h) : h + a;
+	}
+
+	return h + min;
+}
+
 template<class V, int R, class H>
 inline scalar_hash<V,R,H>
 make_hash(H (*func)(void const *, size_t, uintptr_t), uintptr_t seed)
@@ -506,6 +857,131 @@ make_hash(void (*func)(void const *, size_t, uintptr_t, H *), uintptr_t seed)
 	return vector_hash<V,R,H>(func, seed);
 }
 
+template<class V, int R, class H>
+inline scalar_hash<V,R,H>
+make_hash(H (*func)(void const *, size_t, uintptr_t),
+    void (*b32)(uint32_t const *, size_t, uintptr_t, H *),
+    void (*b64)(uint64_t const *, size_t, uintptr_t, H *), uintptr_t seed)
+{
+
+	return scalar_hash<V,R,H>(func, b32, b64, seed);
+}
+
+template<class V, int R, class H>
+inline vector_hash<V,R,H>
+make_hash(void (*func)(void const *, size_t, uintptr_t, H *),
+    void (*b32)(uint32_t const *, size_t, uintptr_t, H *),
+    void (*b64)(uint64_t const *, size_t, uintptr_t, H *),
+    size_t width, uintptr_t seed)
+{
+
+	return vector_hash<V,R,H>(func, b32, b64, nullptr, width, seed);
+}
+
+template<class V, int R, class H>
+inline vector_hash<V,R,H>
+make_hash(void (*func)(void const *, size_t, uintptr_t, H *),
+    void (*b32)(uint32_t const *, size_t, uintptr_t, H *),
+    void (*b64)(uint64_t const *, size_t, uintptr_t, H *),
+    void (*db)(void const * const *, size_t const *, size_t, uintptr_t, H *),
+    size_t width, uintptr_t seed)
+{
+
+	return vector_hash<V,R,H>(func, b32, b64, db, width, seed);
+}
+
+// Hash keys of len bytes with a function specialised for that length.
+template<class Hash>
+inline Hash
+with_fixed(Hash hash, typename Hash::func_t fixed, size_t len)
+{
+
+	hash.fixed = fixed;
+	hash.fixedlen = len;
+	return hash;
+}
+
+// Fixed width keys waiting to be hashed by a batch hash function.
+// P is a key position, e.g. an edge number.
+template<class T, class P>
+struct key_batch {
+	size_t n;
+	T keys[BATCH_SIZE];
+	P pos[BATCH_SIZE];
+
+	inline bool push(void const *key, P p)
+	{
+
+		memcpy(&keys[n], key, sizeof(T));
+		pos[n++] = p;
+		return n == BATCH_SIZE;
+	}
+};
+
+// Keys of any length waiting to be hashed by a data batch function.
+// Keys are copied to buf if the caller may overwrite them.
+template<class P>
+struct data_batch {
+	size_t n;
+	void const *keys[DATA_BATCH_SIZE];
+	size_t keylens[DATA_BATCH_SIZE];
+	P pos[DATA_BATCH_SIZE];
+
+	inline bool push(void const *key, size_t keylen, P p)
+	{
+
+		keys[n] = key;
+		keylens[n] = keylen;
+		pos[n++] = p;
+		return n == DATA_BATCH_SIZE;
+	}
+};
+
+template<class P>
+struct data_batch_copy : data_batch<P> {
+	uint8_t buf[DATA_BATCH_SIZE][DATA_BATCH_MAXLEN];
+
+	inline bool push(void const *key, size_t keylen, P p)
+	{
+
+		assert(keylen <= DATA_BATCH_MAXLEN);
+		memcpy(buf[this->n], key, keylen);
+		return data_batch<P>::push(buf[this->n], keylen, p);
+	}
+};
+
+template<class T, class B, class Hash, class Reduce, class V, int R>
+inline void
+flush_batch(key_batch<T,V> &b, B batch_func, Hash const &hash,
+    Reduce const &reduce, edge<V,R> *edges)
+{
+	V verts[BATCH_SIZE][R];
+
+	hash.batch(batch_func, b.keys, b.n, verts);
+	for (size_t i = 0; i < b.n; i++) {
+		for (V r = 0; r < R; ++r)
+			edges[b.pos[i]].verts[r] = reduce(verts[i], r);
+	}
+
+	b.n = 0;
+}
+
+template<class Hash, class Reduce, class V, int R>
+inline void
+flush_batch(data_batch<V> &b, Hash const &hash,
+    Reduce const &reduce, edge<V,R> *edges)
+{
+	V verts[DATA_BATCH_SIZE][R];
+
+	hash.batch_data(b.keys, b.keylens, b.n, verts);
+	for (size_t i = 0; i < b.n; i++) {
+		for (V r = 0; r < R; ++r)
+			edges[b.pos[i]].verts[r] = reduce(verts[i], r);
+	}
+
+	b.n = 0;
+}
+
 template<class X>
 inline void
 init_chm_index(X *index, size_t n)
@@ -525,6 +1001,14 @@ copy_chm_index(void *new_index, void *index, size_t n)
 		dst[i] = src[i];
 }
 
+inline size_t
+chm_index_size(size_t nkeys, big_index_t indexmax)
+{
+	bool const big = indexmax > INDEX_MAX;
+
+	return nkeys * (big ? sizeof(big_index_t) : sizeof(index_t));
+}
+
 void *
 realloc_chm_index(void *index, size_t nkeys, size_t e, big_index_t indexmax)
 {
@@ -560,62 +1044,117 @@ init_graph(Iter &keys, Iter const &keys_end,
     edge<V,R> *edges, size_t nkeys, oedge<V,R> *oedges,
     size_t *datalenmin, size_t *datalenmax,
     big_index_t *indexmin, big_index_t *indexmax,
-    V e, X *index)
+    struct rgph_stats *stats, V e, X *index)
 {
 	static_assert(sizeof(nullptr_index_t) < sizeof(index_t),
 	    "Impossible to detect nullptr index at compile-time.");
 
 	bool constexpr null_index = sizeof(X) == sizeof(nullptr_index_t);
+	bool stop = false;
+	key_batch<uint32_t,V> k32;
+	key_batch<uint64_t,V> k64;
+	data_batch_copy<V> kd;
+
+	k32.n = k64.n = kd.n = 0;
+
+	// Hash a chunk of keys first and then add its edges. This is
+	// to time the two loops separately.
+	while (!stop && e < nkeys && keys != keys_end) {
+		V const start = e;
+		V const end = nkeys - e > INIT_CHUNK ? e + INIT_CHUNK : nkeys;
+		uint64_t const t0 = now_ns();
+
+		for (; e < end && keys != keys_end; ++e, ++keys) {
+			rgph_entry const &ent = *keys;
+			big_index_t const i = ent.has_index ? ent.index : e;
+
+			if (i > *indexmax) {
+				*indexmax = i;
+
+				if (sizeof(X) == sizeof(index_t) &&
+				    i > INDEX_MAX) {
+					stop = true;
+					break;
+				}
+			}
 
-	for (; e < nkeys && keys != keys_end; ++e, ++keys) {
-		rgph_entry const &ent = *keys;
-		big_index_t const i = ent.has_index ? ent.index : e;
+			if (i < *indexmin)
+				*indexmin = i;
 
-		if (i > *indexmax) {
-			*indexmax = i;
+			if (!null_index) {
+				index[e] = i;
+			} else if (i != e) {
+				stop = true;
+				break;
+			}
 
-			if (sizeof(X) == sizeof(index_t) && i > INDEX_MAX)
-				return e;
-		}
+			if (ent.datalen > *datalenmax)
+				*datalenmax = ent.datalen;
+			if (ent.datalen < *datalenmin)
+				*datalenmin = ent.datalen;
 
-		if (i < *indexmin)
-			*indexmin = i;
+			if (ent.keylen == sizeof(uint32_t) &&
+			    hash.batch32 != nullptr) {
+				if (k32.push(ent.key, e)) {
+					flush_batch(k32, hash.batch32,
+					    hash, reduce, edges);
+				}
+			} else if (ent.keylen == sizeof(uint64_t) &&
+			    hash.batch64 != nullptr) {
+				if (k64.push(ent.key, e)) {
+					flush_batch(k64, hash.batch64,
+					    hash, reduce, edges);
+				}
+			} else if (ent.keylen >= DATA_BATCH_MINLEN &&
+			    ent.keylen <= DATA_BATCH_MAXLEN &&
+			    hash.data_batch != nullptr) {
+				if (kd.push(ent.key, ent.keylen, e))
+					flush_batch(kd, hash, reduce, edges);
+			} else {
+				V const *verts = hash(ent.key, ent.keylen);
+				for (V r = 0; r < R; ++r)
+					edges[e].verts[r] = reduce(verts, r);
+			}
+		}
 
-		if (!null_index)
-			index[e] = i;
-		else if (i != e)
-			return e;
+		if (k32.n > 0)
+			flush_batch(k32, hash.batch32, hash, reduce, edges);
+		if (k64.n > 0)
+			flush_batch(k64, hash.batch64, hash, reduce, edges);
+		if (kd.n > 0)
+			flush_batch(kd, hash, reduce, edges);
 
-		if (ent.datalen > *datalenmax)
-			*datalenmax = ent.datalen;
-		if (ent.datalen < *datalenmin)
-			*datalenmin = ent.datalen;
+		uint64_t const t1 = now_ns();
 
-		V const *verts = hash(ent.key, ent.keylen);
-		for (V r = 0; r < R; ++r)
-			edges[e].verts[r] = reduce(verts, r);
+		for (V f = start; f < e; ++f)
+			add_edge(oedges, f, edges[f].verts);
 
-		add_edge(oedges, e, edges[e].verts);
+		stats->hash_ns += t1 - t0;
+		stats->add_edge_ns += now_ns() - t1;
+		stats->nkeys += e - start;
 	}
 
 	return e;
 }
 
+// Add edges from *pos up to nkeys, *pos is updated on return.
 template<class Iter, class Reduce, class Hash, class V, int R>
 int
 init_graph(Iter &keys, Iter const &keys_end,
     Reduce const &reduce, Hash const &hash,
     edge<V,R> *edges, size_t nkeys, oedge<V,R> *oedges,
     size_t *datalenmin, size_t *datalenmax,
-    void **index, big_index_t *indexmin, big_index_t *indexmax)
+    void **index, big_index_t *indexmin, big_index_t *indexmax,
+    struct rgph_stats *stats, size_t *pos)
 {
-	V e = 0;
+	V e = *pos;
 
 	if (*index == nullptr) {
 		e = init_graph(keys, keys_end, reduce, hash,
 		    edges, nkeys, oedges, datalenmin, datalenmax,
 		    indexmin, indexmax,
-		    e, static_cast<nullptr_index_t *>(*index));
+		    stats, e, static_cast<nullptr_index_t *>(*index));
+		*pos = e;
 		if (e == nkeys)
 			return RGPH_SUCCESS;
 		else if (keys == keys_end)
@@ -624,6 +1163,9 @@ init_graph(Iter &keys, Iter const &keys_end,
 		*index = realloc_chm_index(*index, nkeys, e, *indexmax);
 		if (*index == nullptr)
 			return RGPH_NOMEM;
+
+		stats->index_reallocs++;
+		stats->allocated += chm_index_size(nkeys, *indexmax);
 	}
 
 	if (*indexmax <= INDEX_MAX) {
@@ -632,7 +1174,8 @@ init_graph(Iter &keys, Iter const &keys_end,
 		e = init_graph(keys, keys_end, reduce, hash,
 		    edges, nkeys, oedges, datalenmin, datalenmax,
 		    indexmin, indexmax,
-		    e, static_cast<index_t *>(*index));
+		    stats, e, static_cast<index_t *>(*index));
+		*pos = e;
 		if (e == nkeys)
 			return RGPH_SUCCESS;
 		else if (keys == keys_end)
@@ -642,6 +1185,10 @@ init_graph(Iter &keys, Iter const &keys_end,
 		if (big_index == nullptr)
 			return RGPH_NOMEM;
 		*index = big_index;
+
+		stats->index_reallocs++;
+		stats->allocated += chm_index_size(nkeys, *indexmax);
+		stats->allocated -= chm_index_size(nkeys, INDEX_MAX);
 	}
 
 	assert (*indexmax > INDEX_MAX);
@@ -649,65 +1196,201 @@ init_graph(Iter &keys, Iter const &keys_end,
 	e = init_graph(keys, keys_end, reduce, hash,
 	    edges, nkeys, oedges, datalenmin, datalenmax,
 	    indexmin, indexmax,
-	    e, static_cast<big_index_t *>(*index));
+	    stats, e, static_cast<big_index_t *>(*index));
+	*pos = e;
 
 	return e == nkeys ? RGPH_SUCCESS : RGPH_NOKEY;
 }
 
-template<class V, int R>
-size_t
-peel_graph(edge<V,R> const *edges, size_t nkeys,
-    oedge<V,R> *oedges, size_t nverts, V *order)
+template<class Hash>
+inline typename Hash::batch32_t
+int_batch(Hash const &hash, uint32_t const *)
 {
-	size_t top = nkeys;
-
-	for (V v0 = 0; v0 < nverts; ++v0)
-		top = remove_vertex(oedges, v0, order, top);
 
-	for (size_t i = nkeys; i > 0 && i > top; --i) {
-		edge<V,R> const &e = edges[order[i-1]];
-		for (size_t r = 0; r < R; ++r)
-			top = remove_vertex(oedges, e.verts[r], order, top);
-	}
-
-	return top;
+	return hash.batch32;
 }
 
-inline size_t
-edge_size(int rank)
+template<class Hash>
+inline typename Hash::batch64_t
+int_batch(Hash const &hash, uint64_t const *)
 {
 
-	switch (rank) {
-	case 2: return sizeof(edge<vert_t,2>);
-	case 3: return sizeof(edge<vert_t,3>);
-	default: return 0;
-	}
+	return hash.batch64;
 }
 
-inline size_t constexpr
-maxsize(size_t a, size_t b)
-{
+// Integer keys hash exactly like their in-memory representation
+// passed to rgph_build_graph() with keylen == sizeof(T). Indices
+// are implicit (a key's position in the array) and there is no data.
+template<class T, class Reduce, class Hash, class V, int R>
+int
+init_graph_ints(T const *keys, size_t nkeys,
+    Reduce const &reduce, Hash const &hash,
+    edge<V,R> *edges, oedge<V,R> *oedges,
+    size_t *datalenmin, void *index,
+    big_index_t *indexmin, big_index_t *indexmax,
+    struct rgph_stats *stats)
+{
+	auto const batch = int_batch(hash, keys);
+	V verts[BATCH_SIZE][R];
+
+	if (nkeys > 0 && nkeys - 1 > *indexmax)
+		*indexmax = nkeys - 1;
+	if (*indexmin > 0)
+		*indexmin = 0;
+	if (*datalenmin > 0)
+		*datalenmin = 0;
+
+	if (index != nullptr && *indexmax > INDEX_MAX)
+		init_chm_index(static_cast<big_index_t *>(index), nkeys);
+	else if (index != nullptr)
+		init_chm_index(static_cast<index_t *>(index), nkeys);
+
+	for (size_t start = 0; start < nkeys; start += INIT_CHUNK) {
+		size_t const end = nkeys - start > INIT_CHUNK ?
+		    start + INIT_CHUNK : nkeys;
+		uint64_t const t0 = now_ns();
+
+		for (size_t e = start; e < end && batch != nullptr;
+		    e += BATCH_SIZE) {
+			size_t const n = end - e > BATCH_SIZE ?
+			    BATCH_SIZE : end - e;
+
+			hash.batch(batch, &keys[e], n, verts);
+			for (size_t i = 0; i < n; i++) {
+				for (V r = 0; r < R; ++r) {
+					edges[e+i].verts[r] =
+					    reduce(verts[i], r);
+				}
+			}
+		}
 
-	return a > b ? a : b;
-}
+		for (size_t e = start; e < end && batch == nullptr; ++e) {
+			V const *h = hash(&keys[e], sizeof(T));
+			for (V r = 0; r < R; ++r)
+				edges[e].verts[r] = reduce(h, r);
+		}
 
-inline size_t constexpr
-maxsize(size_t a, size_t b, size_t c)
-{
+		uint64_t const t1 = now_ns();
 
-	return maxsize(maxsize(a, b), c);
+		for (V f = start; f < end; ++f)
+			add_edge(oedges, f, edges[f].verts);
+
+		stats->hash_ns += t1 - t0;
+		stats->add_edge_ns += now_ns() - t1;
+		stats->nkeys += end - start;
+	}
+
+	return RGPH_SUCCESS;
 }
 
+// Remove vertices [v0, vend) of degree one, return a new top.
 template<class V, int R>
 inline size_t
-duphash_size(size_t nverts)
+peel_scan(oedge<V,R> *oedges, size_t v0, size_t vend, V *order, size_t top)
 {
-	size_t const nelems = nverts / R;
 
-	assert((nverts % R) == 0);
+	for (V v = v0; v < vend; ++v)
+		top = remove_vertex(oedges, v, order, top);
 
-	if (nelems > SIZE_MAX / sizeof(duphash_entry_t))
-		return 0;
+	return top;
+}
+
+// Peel at most n edges of order[top, *pos) starting from the end,
+// return a new top.
+template<class V, int R>
+inline size_t
+peel_cascade(edge<V,R> const *edges, oedge<V,R> *oedges,
+    V *order, size_t *pos, size_t n, size_t top)
+{
+	size_t i = *pos;
+
+	for (; i > top && n > 0; --i, --n) {
+		edge<V,R> const &e = edges[order[i-1]];
+		for (size_t r = 0; r < R; ++r)
+			top = remove_vertex(oedges, e.verts[r], order, top);
+	}
+
+	*pos = i;
+	return top;
+}
+
+template<class V, int R>
+size_t
+peel_graph(edge<V,R> const *edges, size_t nkeys,
+    oedge<V,R> *oedges, size_t nverts, V *order, size_t *scan_top)
+{
+	size_t top = peel_scan(oedges, 0, nverts, order, nkeys);
+	size_t pos = nkeys;
+
+	*scan_top = top;
+	return peel_cascade(edges, oedges, order, &pos, SIZE_MAX, top);
+}
+
+template<class V, int R>
+void
+degree_histogram(oedge<V,R> const *oedges, size_t nverts,
+    size_t (&degree)[RGPH_DEGREE_BINS])
+{
+	size_t constexpr last = RGPH_DEGREE_BINS - 1;
+
+	for (size_t i = 0; i < RGPH_DEGREE_BINS; i++)
+		degree[i] = 0;
+
+	for (size_t v = 0; v < nverts; ++v) {
+		V const d = oedges[v].degree;
+		degree[d < last ? d : last]++;
+	}
+}
+
+template<class V, int R>
+size_t
+count_core_verts(oedge<V,R> const *oedges, size_t nverts)
+{
+	size_t res = 0;
+
+	for (size_t v = 0; v < nverts; ++v) {
+		if (oedges[v].degree != 0)
+			res++;
+	}
+
+	return res;
+}
+
+inline size_t
+edge_size(int rank)
+{
+
+	switch (rank) {
+	case 2: return sizeof(edge<vert_t,2>);
+	case 3: return sizeof(edge<vert_t,3>);
+	default: return 0;
+	}
+}
+
+inline size_t constexpr
+maxsize(size_t a, size_t b)
+{
+
+	return a > b ? a : b;
+}
+
+inline size_t constexpr
+maxsize(size_t a, size_t b, size_t c)
+{
+
+	return maxsize(maxsize(a, b), c);
+}
+
+template<class V, int R>
+inline size_t
+duphash_size(size_t nverts)
+{
+	size_t const nelems = nverts / R;
+
+	assert((nverts % R) == 0);
+
+	if (nelems > SIZE_MAX / sizeof(duphash_entry_t))
+		return 0;
 
 	// Round up to V's size because the hash table is followed by
 	// a peel index array. In practice, rounding doesn't make any
@@ -777,6 +1460,8 @@ hash_bits(unsigned int flags)
 	case RGPH_HASH_CUSTOM:
 		return 96;
 	case RGPH_HASH_MURMUR32V:
+	case RGPH_HASH_AES128V:
+	case RGPH_HASH_XXH128V:
 		return 128;
 	default:
 		assert(0 && "rgph_alloc_graph() should have caught it");
@@ -791,13 +1476,32 @@ graph_rank(unsigned int flags)
 	return (flags & RGPH_RANK_MASK) == RGPH_RANK2 ? 2 : 3;
 }
 
+// Total number of bits in vertex hashes before reduction to partitions.
+inline size_t
+vertex_bits(unsigned int flags)
+{
+
+	switch (flags & RGPH_HASH_MASK) {
+	case RGPH_HASH_MURMUR32S:
+	case RGPH_HASH_XXH32S:
+	case RGPH_HASH_XXH64S:
+	case RGPH_HASH_T1HA64S:
+		return 32 * graph_rank(flags); // See scalar_hash::derive().
+	default:
+		return hash_bits(flags);
+	}
+}
+
 inline size_t
 graph_max_keys(unsigned int flags)
 {
-	int const rank = graph_rank(flags);
+	size_t const rank = graph_rank(flags);
 	size_t const nbits = hash_bits(flags);
+	size_t const vbits = vertex_bits(flags);
 
-	if (nbits >= 96)
+	if (nbits == 32 && vbits > 32)
+		return MAX_NKEYS_DERIVED32;
+	else if (vbits >= 32 * rank)
 		return (rank == 2) ? MAX_NKEYS_R2_VEC : MAX_NKEYS_R3_VEC;
 	else if (nbits == 64)
 		return (rank == 2) ? MAX_NKEYS_R2_S64 : MAX_NKEYS_R3_S64;
@@ -946,237 +1650,688 @@ need_assigned_bitset(int flags, big_index_t indexmin, big_index_t indexmax)
 	return compact ? indexmax - indexmin == max : indexmax > max / 2;
 }
 
-template<class V, int R>
-int
-build_graph(struct rgph_graph *g, rgph_entry_iterator_t keys,
-    void *state, rgph_vector_hash_t hash, uintptr_t seed)
+/*
+ * Call f(reduce, hash) with the reduction and the hash function
+ * selected by flags. Build and lookup paths must agree on the pair,
+ * hence one switch for both. Keys of keylen bytes are hashed by
+ * kernels specialised for that length if there are any.
+ */
+template<class V, int R, class F>
+inline int
+with_hash(unsigned int flags, size_t nverts,
+    rgph_vector_hash_t hash, uintptr_t seed, size_t keylen, F const &f)
 {
-	typedef edge<V,R> edge_t;
-	typedef oedge<V,R> oedge_t;
-
-	auto order = static_cast<V *>(g->order);
-	auto edges = static_cast<edge_t *>(g->edges);
-	auto oedges = static_cast<oedge_t *>(g->shared.oedges);
-	size_t const nkeys = g->nkeys;
-	size_t const nverts = g->nverts;
-	unsigned int const flags = g->flags;
-	size_t const nbits = hash_bits(flags);
-	int res = RGPH_INVAL;
-
-	if ((flags & ZEROED) == 0) {
-		memset(order, 0, sizeof(V) * nkeys);
-		memset(edges, 0, sizeof(edge_t) * nkeys);
-		memset(oedges, 0, sizeof(oedge_t) * nverts);
-	}
-
-	// Unlike g->indexmin and g->indexmax which can't be reset
-	// because a state of g->index depends on their values,
-	// g->datalenmin and g->datalenmax can be reset.
-	// They aren't reset because it improves branch prediction
-	// if rgph_build_graph() is called multiple times.
-	//g->datalenmin = SIZE_MAX;
-	//g->datalenmax = 0;
-	g->core_size = nkeys;
-	g->seed = seed;
-	g->flags &= PUBLIC_FLAGS; // Reset internal flags.
+	size_t const nbits = vertex_bits(flags);
+	struct rgph_kernels const *k = rgph_kernels();
+	struct rgph_data_kernels const *x = rgph_fixed_kernels(k, keylen);
 
-	entry_iterator keys_start(keys, state), keys_end;
+	if (x == nullptr)
+		x = k->data;
 
 	switch (flags & (RGPH_HASH_MASK | RGPH_REDUCE_MASK)) {
 	case RGPH_HASH_JENKINS2V|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(&rgph_u32x3_jenkins2v_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->jenkins2v,
+		    k->batch->jenkins2v_u32, k->batch->jenkins2v_u64,
+		    k->data->jenkins2v_batch, 3, seed),
+		    x->jenkins2v, keylen));
 	case RGPH_HASH_MURMUR32V|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(&rgph_u32x4_murmur32v_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->murmur32v,
+		    k->batch->murmur32v_u32, k->batch->murmur32v_u64, 4, seed),
+		    x->murmur32v, keylen));
 	case RGPH_HASH_MURMUR32S|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(&rgph_u32_murmur32s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->murmur32s,
+		    k->batch->murmur32s_u32, k->batch->murmur32s_u64, seed),
+		    x->murmur32s, keylen));
 	case RGPH_HASH_XXH32S|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(&rgph_u32_xxh32s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->xxh32s,
+		    k->batch->xxh32s_u32, k->batch->xxh32s_u64, seed),
+		    x->xxh32s, keylen));
 	case RGPH_HASH_XXH64S|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(&rgph_u64_xxh64s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->xxh64s,
+		    k->batch->xxh64s_u32, k->batch->xxh64s_u64, seed),
+		    x->xxh64s, keylen));
 	case RGPH_HASH_T1HA64S|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(&rgph_u64_t1ha64s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->t1ha64s,
+		    k->batch->t1ha64s_u32, k->batch->t1ha64s_u64, seed),
+		    x->t1ha64s, keylen));
+	case RGPH_HASH_AES128V|RGPH_REDUCE_MOD:
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->aes128v, seed),
+		    x->aes128v, keylen));
+	case RGPH_HASH_XXH128V|RGPH_REDUCE_MOD:
+		return f(fastrem_partition(nverts, R), with_fixed(
+		    make_hash<V,R>(k->data->xxh128v, seed),
+		    x->xxh128v, keylen));
 	case RGPH_HASH_CUSTOM|RGPH_REDUCE_MOD:
 	case RGPH_HASH_CUSTOM32S|RGPH_REDUCE_MOD:
 	case RGPH_HASH_CUSTOM64S|RGPH_REDUCE_MOD:
-		res = init_graph(keys_start, keys_end,
-		    fastrem_partition(nverts, R),
-		    make_hash<V,R>(hash, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(fastrem_partition(nverts, R),
+		    make_hash<V,R>(hash, seed));
 	case RGPH_HASH_JENKINS2V|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(&rgph_u32x3_jenkins2v_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->jenkins2v,
+		    k->batch->jenkins2v_u32, k->batch->jenkins2v_u64,
+		    k->data->jenkins2v_batch, 3, seed),
+		    x->jenkins2v, keylen));
 	case RGPH_HASH_MURMUR32V|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(&rgph_u32x4_murmur32v_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->murmur32v,
+		    k->batch->murmur32v_u32, k->batch->murmur32v_u64, 4, seed),
+		    x->murmur32v, keylen));
 	case RGPH_HASH_MURMUR32S|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(&rgph_u32_murmur32s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->murmur32s,
+		    k->batch->murmur32s_u32, k->batch->murmur32s_u64, seed),
+		    x->murmur32s, keylen));
 	case RGPH_HASH_XXH32S|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(&rgph_u32_xxh32s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->xxh32s,
+		    k->batch->xxh32s_u32, k->batch->xxh32s_u64, seed),
+		    x->xxh32s, keylen));
 	case RGPH_HASH_XXH64S|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(&rgph_u64_xxh64s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->xxh64s,
+		    k->batch->xxh64s_u32, k->batch->xxh64s_u64, seed),
+		    x->xxh64s, keylen));
 	case RGPH_HASH_T1HA64S|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(&rgph_u64_t1ha64s_data, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->t1ha64s,
+		    k->batch->t1ha64s_u32, k->batch->t1ha64s_u64, seed),
+		    x->t1ha64s, keylen));
+	case RGPH_HASH_AES128V|RGPH_REDUCE_MUL:
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->aes128v, seed),
+		    x->aes128v, keylen));
+	case RGPH_HASH_XXH128V|RGPH_REDUCE_MUL:
+		return f(lemire_partition(nverts, R, nbits), with_fixed(
+		    make_hash<V,R>(k->data->xxh128v, seed),
+		    x->xxh128v, keylen));
 	case RGPH_HASH_CUSTOM|RGPH_REDUCE_MUL:
 	case RGPH_HASH_CUSTOM32S|RGPH_REDUCE_MUL:
 	case RGPH_HASH_CUSTOM64S|RGPH_REDUCE_MUL:
-		res = init_graph(keys_start, keys_end,
-		    lemire_partition(nverts, R, nbits),
-		    make_hash<V,R>(hash, seed),
-		    edges, nkeys, oedges,
-		    &g->datalenmin, &g->datalenmax,
-		    &g->index, &g->indexmin, &g->indexmax);
-		break;
+		return f(lemire_partition(nverts, R, nbits),
+		    make_hash<V,R>(hash, seed));
 	default:
 		assert(0 && "rgph_alloc_graph() should have caught it");
 		return RGPH_INVAL;
 	}
+}
 
-	if (res != RGPH_SUCCESS)
-		return res;
+// Functor for with_hash() in build_graph() and build_step().
+template<class V, int R, class Iter>
+struct init_graph_fn {
+	struct rgph_graph *g;
+	Iter &keys;
+	Iter const &keys_end;
 
-	g->core_size = peel_graph(edges, nkeys, oedges, nverts, order);
+	template<class Reduce, class Hash>
+	int operator()(Reduce const &reduce, Hash const &hash) const
+	{
 
-	g->flags |= BUILT;
-	return g->core_size == 0 ? RGPH_SUCCESS : RGPH_AGAIN;
-}
+		return init_graph(keys, keys_end, reduce, hash,
+		    static_cast<edge<V,R> *>(g->edges), g->nkeys,
+		    static_cast<oedge<V,R> *>(g->shared.oedges),
+		    &g->datalenmin, &g->datalenmax,
+		    &g->index, &g->indexmin, &g->indexmax, &g->stats,
+		    &g->build_pos);
+	}
+};
 
-template<class V, int R>
-V const *
-build_peel_index(struct rgph_graph *g)
-{
-	size_t const hash_sz = duphash_size<V,R>(g->nverts);
-	auto peel = reinterpret_cast<V *>(g->shared.bdz_assignments + hash_sz);
+// Functor for with_hash() in graph_lookup().
+template<class V, int R, class A>
+struct lookup_fn {
+	A const &assigned;
+	void const * const *keys;
+	size_t const *keylens;
+	size_t nkeys;
+	uint64_t *out;
+
+	template<class Reduce, class Hash>
+	int operator()(Reduce const &reduce, Hash const &hash) const
+	{
+		key_batch<uint32_t,size_t> k32;
+		key_batch<uint64_t,size_t> k64;
+		data_batch<size_t> kd;
+		bool const batched = nkeys > 1; // Don't slow down rgph_lookup().
+		V verts[R];
+
+		k32.n = k64.n = kd.n = 0;
+
+		for (size_t i = 0; i < nkeys; i++) {
+			if (batched && keylens[i] == sizeof(uint32_t) &&
+			    hash.batch32 != nullptr) {
+				if (k32.push(keys[i], i))
+					flush(k32, hash.batch32, reduce, hash);
+			} else if (batched && keylens[i] == sizeof(uint64_t) &&
+			    hash.batch64 != nullptr) {
+				if (k64.push(keys[i], i))
+					flush(k64, hash.batch64, reduce, hash);
+			} else if (batched && keylens[i] >= DATA_BATCH_MINLEN &&
+			    hash.data_batch != nullptr) {
+				if (kd.push(keys[i], keylens[i], i))
+					flush(kd, reduce, hash);
+			} else {
+				V const *h = hash(keys[i], keylens[i]);
+				for (size_t r = 0; r < R; r++)
+					verts[r] = reduce(h, r);
+				out[i] = assigned(verts);
+			}
+		}
 
-	assert(hash_sz != 0);
+		if (k32.n > 0)
+			flush(k32, hash.batch32, reduce, hash);
+		if (k64.n > 0)
+			flush(k64, hash.batch64, reduce, hash);
+		if (kd.n > 0)
+			flush(kd, reduce, hash);
 
-	if (!(g->flags & PEELED)) {
-		auto order = static_cast<V const *>(g->order);
+		return RGPH_SUCCESS;
+	}
 
-		g->flags |= PEELED;
-		g->flags &= ~ASSIGNED;
-		memset(peel, 0, sizeof(V) * g->nkeys);
+	template<class T, class B, class Reduce, class Hash>
+	void flush(key_batch<T,size_t> &b, B batch_func,
+	    Reduce const &reduce, Hash const &hash) const
+	{
+		V verts[BATCH_SIZE][R];
+
+		hash.batch(batch_func, b.keys, b.n, verts);
+		for (size_t i = 0; i < b.n; i++) {
+			for (size_t r = 0; r < R; r++)
+				verts[i][r] = reduce(verts[i], r);
+			out[b.pos[i]] = assigned(verts[i]);
+		}
 
-		for (size_t i = g->nkeys; i > g->core_size; i--) {
-			assert(peel[order[i-1]] == 0);
-			peel[order[i-1]] = g->nkeys - i + 1;
+		b.n = 0;
+	}
+
+	template<class Reduce, class Hash>
+	void flush(data_batch<size_t> &b,
+	    Reduce const &reduce, Hash const &hash) const
+	{
+		V verts[DATA_BATCH_SIZE][R];
+
+		hash.batch_data(b.keys, b.keylens, b.n, verts);
+		for (size_t i = 0; i < b.n; i++) {
+			for (size_t r = 0; r < R; r++)
+				verts[i][r] = reduce(verts[i], r);
+			out[b.pos[i]] = assigned(verts[i]);
 		}
+
+		b.n = 0;
 	}
+};
 
-	return peel;
+// Functor for with_hash() in graph_lookup() of integer keys.
+template<class V, int R, class A, class T>
+struct lookup_ints_fn {
+	A const &assigned;
+	T const *keys;
+	size_t nkeys;
+	uint64_t *out;
+
+	template<class Reduce, class Hash>
+	int operator()(Reduce const &reduce, Hash const &hash) const
+	{
+		auto const batch = int_batch(hash, keys);
+		V verts[BATCH_SIZE][R];
+
+		// Don't slow down rgph_lookup_u32() and rgph_lookup_u64().
+		if (nkeys == 1 || batch == nullptr) {
+			for (size_t i = 0; i < nkeys; i++) {
+				V const *h = hash(&keys[i], sizeof(T));
+				for (size_t r = 0; r < R; r++)
+					verts[0][r] = reduce(h, r);
+				out[i] = assigned(verts[0]);
+			}
+
+			return RGPH_SUCCESS;
+		}
+
+		for (size_t i = 0; i < nkeys; i += BATCH_SIZE) {
+			size_t const n = nkeys - i > BATCH_SIZE ?
+			    BATCH_SIZE : nkeys - i;
+
+			hash.batch(batch, &keys[i], n, verts);
+			for (size_t j = 0; j < n; j++) {
+				for (size_t r = 0; r < R; r++)
+					verts[j][r] = reduce(verts[j], r);
+				out[i+j] = assigned(verts[j]);
+			}
+		}
+
+		return RGPH_SUCCESS;
+	}
+};
+
+// Keys of rgph_lookup_batch().
+struct data_keys {
+	void const * const *keys;
+	size_t const *keylens;
+};
+
+template<class V, int R, class A>
+inline lookup_fn<V,R,A>
+make_lookup_fn(A const &assigned, data_keys const &keys,
+    size_t n, uint64_t *out)
+{
+
+	return lookup_fn<V,R,A>{ assigned, keys.keys, keys.keylens, n, out };
+}
+
+template<class V, int R, class A, class T>
+inline lookup_ints_fn<V,R,A,T>
+make_lookup_fn(A const &assigned, T const *keys, size_t n, uint64_t *out)
+{
+
+	return lookup_ints_fn<V,R,A,T>{ assigned, keys, n, out };
 }
 
+// Functor for with_hash() in build_graph_ints().
+template<class V, int R, class T>
+struct init_graph_ints_fn {
+	struct rgph_graph *g;
+	T const *keys;
+
+	template<class Reduce, class Hash>
+	int operator()(Reduce const &reduce, Hash const &hash) const
+	{
+
+		return init_graph_ints(keys, g->nkeys, reduce, hash,
+		    static_cast<edge<V,R> *>(g->edges),
+		    static_cast<oedge<V,R> *>(g->shared.oedges),
+		    &g->datalenmin, g->index, &g->indexmin, &g->indexmax,
+		    &g->stats);
+	}
+};
+
 template<class V, int R>
-int
-copy_edge(struct rgph_graph *g, size_t e, uint32_t *to, size_t *peel_order)
+void
+reset_graph(struct rgph_graph *g, rgph_vector_hash_t hash, uintptr_t seed)
 {
 	typedef edge<V,R> edge_t;
+	typedef oedge<V,R> oedge_t;
 
+	auto order = static_cast<V *>(g->order);
 	auto edges = static_cast<edge_t *>(g->edges);
+	auto oedges = static_cast<oedge_t *>(g->shared.oedges);
+	size_t const nkeys = g->nkeys;
+	size_t const nverts = g->nverts;
 
-	for (size_t r = 0; r < R; r++)
-		to[r] = edges[e].verts[r];
-
-	if (peel_order != nullptr) {
-		V const *peel = build_peel_index<V,R>(g);
-		*peel_order = peel[e];
+	if ((g->flags & ZEROED) == 0) {
+		memset(order, 0, sizeof(V) * nkeys);
+		memset(edges, 0, sizeof(edge_t) * nkeys);
+		memset(oedges, 0, sizeof(oedge_t) * nverts);
 	}
 
-	return RGPH_SUCCESS;
+	// Unlike g->indexmin and g->indexmax which can't be reset
+	// because a state of g->index depends on their values,
+	// g->datalenmin and g->datalenmax can be reset.
+	// They aren't reset because it improves branch prediction
+	// if rgph_build_graph() is called multiple times.
+	//g->datalenmin = SIZE_MAX;
+	//g->datalenmax = 0;
+	g->core_size = nkeys;
+	g->seed = seed;
+	g->hash = hash;
+	g->build_pos = 0;
+	g->flags &= PUBLIC_FLAGS; // Reset internal flags.
+	g->stats.nbuilds++;
 }
 
+// Called when peeling is done, top is the size of the R-core.
 template<class V, int R>
 int
-find_duplicates(struct rgph_graph *g,
-    rgph_entry_iterator_t iter, void *state, size_t *dup)
+peeled(struct rgph_graph *g, size_t scan_top, size_t top)
 {
-	typedef edge<V,R> edge_t;
+	auto oedges = static_cast<oedge<V,R> const *>(g->shared.oedges);
 
-	assert((g->nverts % R) == 0);
+	g->core_size = top;
 
-	size_t const hash_sz = g->nverts / R;
-	size_t const maxfill = g->nverts / 4; // Fill factor is 50% or 75%.
-	auto hash = g->shared.duphash;
+	if (g->flags & RGPH_INSTRUMENT) {
+		struct rgph_peel_stats *ps = &g->peel_stats;
 
-	for (size_t i = 0; i < hash_sz; i++)
-		hash[i] = nullptr;
+		ps->scan_peeled = g->nkeys - scan_top;
+		ps->cascade_peeled = scan_top - g->core_size;
+		ps->core_edges = g->core_size;
+		ps->core_verts = count_core_verts(oedges, g->nverts);
+	}
 
-	int res = RGPH_NOKEY;
-	V const *peel = build_peel_index<V,R>(g);
-	auto edges = static_cast<edge_t const *>(g->edges);
-	entry_iterator keys(iter, state), keys_end;
+	g->flags |= BUILT;
+	return g->core_size == 0 ? RGPH_SUCCESS : RGPH_AGAIN;
+}
+
+template<class V, int R, class Init>
+int
+build_graph(struct rgph_graph *g,
+    rgph_vector_hash_t hash, uintptr_t seed, Init const &init)
+{
+	typedef edge<V,R> edge_t;
+	typedef oedge<V,R> oedge_t;
+
+	auto order = static_cast<V *>(g->order);
+	auto edges = static_cast<edge_t *>(g->edges);
+	auto oedges = static_cast<oedge_t *>(g->shared.oedges);
+	size_t const nkeys = g->nkeys;
+	size_t const nverts = g->nverts;
+	unsigned int const flags = g->flags;
+	int res;
+
+	reset_graph<V,R>(g, hash, seed);
+
+	res = with_hash<V,R>(flags, nverts, hash, seed, g->keylen, init);
+
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	if (flags & RGPH_INSTRUMENT)
+		degree_histogram(oedges, nverts, g->peel_stats.degree);
+
+	size_t scan_top;
+	uint64_t const t0 = now_ns();
+	size_t const top = peel_graph(edges, nkeys, oedges,
+	    nverts, order, &scan_top);
+	g->stats.peel_ns += now_ns() - t0;
+
+	return peeled<V,R>(g, scan_top, top);
+}
+
+template<class V, int R>
+int
+build_graph(struct rgph_graph *g, rgph_entry_iterator_t keys,
+    void *state, rgph_vector_hash_t hash, uintptr_t seed)
+{
+	entry_iterator keys_start(keys, state), keys_end;
+	init_graph_fn<V,R,entry_iterator> const init =
+	    { g, keys_start, keys_end };
+
+	// Fixed length keys are common, guess from the first key.
+	if (keys_start != keys_end)
+		g->keylen = keys_start->keylen;
+
+	return build_graph<V,R>(g, hash, seed, init);
+}
+
+template<class V, int R, class T>
+int
+build_graph_ints(struct rgph_graph *g, T const *keys,
+    rgph_vector_hash_t hash, uintptr_t seed)
+{
+	init_graph_ints_fn<V,R,T> const init = { g, keys };
+
+	g->keylen = sizeof(T);
+	return build_graph<V,R>(g, hash, seed, init);
+}
+
+template<class V, int R>
+int
+build_step(struct rgph_graph *g, rgph_entry_iterator_t keys, void *state,
+    size_t maxkeys, uint64_t deadline)
+{
+	budget_iterator keys_start(keys, state, maxkeys, deadline), keys_end;
+	init_graph_fn<V,R,budget_iterator> const init =
+	    { g, keys_start, keys_end };
+	int res;
+
+	if (g->build_pos == 0 && keys_start != keys_end)
+		g->keylen = keys_start->keylen;
+
+	res = with_hash<V,R>(g->flags, g->nverts,
+	    g->hash, g->seed, g->keylen, init);
+
+	if (res == RGPH_NOKEY && keys_start.exhausted)
+		return RGPH_PARTIAL;
+
+	return res;
+}
+
+template<class V, int R>
+int
+build_finish(struct rgph_graph *g, size_t maxverts, uint64_t deadline)
+{
+	typedef edge<V,R> edge_t;
+	typedef oedge<V,R> oedge_t;
+
+	auto order = static_cast<V *>(g->order);
+	auto edges = static_cast<edge_t const *>(g->edges);
+	auto oedges = static_cast<oedge_t *>(g->shared.oedges);
+	size_t const nkeys = g->nkeys;
+	size_t const nverts = g->nverts;
+
+	if (!(g->flags & SCANNED) && g->peel_pos == 0) {
+		if (g->flags & RGPH_INSTRUMENT)
+			degree_histogram(oedges, nverts, g->peel_stats.degree);
+		g->peel_top = nkeys;
+	}
+
+	while (maxverts > 0) {
+		size_t const n = maxverts > STEP_CHUNK ? STEP_CHUNK : maxverts;
+		uint64_t const t0 = now_ns();
+
+		if (!(g->flags & SCANNED)) {
+			size_t const vend = nverts - g->peel_pos > n ?
+			    g->peel_pos + n : nverts;
+
+			g->peel_top = peel_scan(oedges,
+			    g->peel_pos, vend, order, g->peel_top);
+			g->peel_pos = vend;
+
+			if (vend == nverts) {
+				g->flags |= SCANNED;
+				g->peel_pos = nkeys;
+				g->peel_stats.scan_peeled = nkeys - g->peel_top;
+			}
+		} else {
+			g->peel_top = peel_cascade(edges, oedges,
+			    order, &g->peel_pos, n, g->peel_top);
+		}
+
+		uint64_t const t1 = now_ns();
+		g->stats.peel_ns += t1 - t0;
+
+		if ((g->flags & SCANNED) && g->peel_pos <= g->peel_top) {
+			size_t const scan_top =
+			    nkeys - g->peel_stats.scan_peeled;
+
+			g->flags &= ~(STEPPING|SCANNED);
+			return peeled<V,R>(g, scan_top, g->peel_top);
+		}
+
+		if (deadline != 0 && t1 >= deadline)
+			break;
+
+		maxverts -= n;
+	}
+
+	return RGPH_PARTIAL;
+}
+
+// Functor for with_hash() in rgph_builder_add(). Entries are added
+// as edges [e, e + n) reserved by the caller, other threads may add
+// their edges at the same time.
+template<class V, int R>
+struct add_entries_fn {
+	struct rgph_graph *g;
+	struct rgph_entry const *ents;
+	size_t n;
+	V e;
+
+	template<class Reduce, class Hash>
+	int operator()(Reduce const &reduce, Hash const &hash) const
+	{
+		auto edges = static_cast<edge<V,R> *>(g->edges);
+		auto oedges = static_cast<oedge<V,R> *>(g->shared.oedges);
+		auto index = static_cast<big_index_t *>(g->index);
+		big_index_t indexmin = BIG_INDEX_MAX, indexmax = 0;
+		size_t datalenmin = SIZE_MAX, datalenmax = 0;
+		key_batch<uint32_t,V> k32;
+		key_batch<uint64_t,V> k64;
+		data_batch<V> kd;
+		uint64_t const t0 = now_ns();
+
+		k32.n = k64.n = kd.n = 0;
+
+		for (size_t i = 0; i < n; i++) {
+			rgph_entry const &ent = ents[i];
+			V const f = e + i;
+			big_index_t const x = ent.has_index ? ent.index : f;
+
+			if (x > indexmax)
+				indexmax = x;
+			if (x < indexmin)
+				indexmin = x;
+			if (index != nullptr)
+				index[f] = x;
+
+			if (ent.datalen > datalenmax)
+				datalenmax = ent.datalen;
+			if (ent.datalen < datalenmin)
+				datalenmin = ent.datalen;
+
+			if (ent.keylen == sizeof(uint32_t) &&
+			    hash.batch32 != nullptr) {
+				if (k32.push(ent.key, f)) {
+					flush_batch(k32, hash.batch32,
+					    hash, reduce, edges);
+				}
+			} else if (ent.keylen == sizeof(uint64_t) &&
+			    hash.batch64 != nullptr) {
+				if (k64.push(ent.key, f)) {
+					flush_batch(k64, hash.batch64,
+					    hash, reduce, edges);
+				}
+			} else if (ent.keylen >= DATA_BATCH_MINLEN &&
+			    hash.data_batch != nullptr) {
+				if (kd.push(ent.key, ent.keylen, f))
+					flush_batch(kd, hash, reduce, edges);
+			} else {
+				V const *verts = hash(ent.key, ent.keylen);
+				for (V r = 0; r < R; ++r)
+					edges[f].verts[r] = reduce(verts, r);
+			}
+		}
+
+		if (k32.n > 0)
+			flush_batch(k32, hash.batch32, hash, reduce, edges);
+		if (k64.n > 0)
+			flush_batch(k64, hash.batch64, hash, reduce, edges);
+		if (kd.n > 0)
+			flush_batch(kd, hash, reduce, edges);
+
+		uint64_t const t1 = now_ns();
+
+		for (V f = e; f < e + n; ++f)
+			atomic_add_edge(oedges, f, edges[f].verts);
+
+		atomic_min(&g->indexmin, indexmin);
+		atomic_max(&g->indexmax, indexmax);
+		atomic_min(&g->datalenmin, datalenmin);
+		atomic_max(&g->datalenmax, datalenmax);
+
+		__atomic_fetch_add(&g->stats.hash_ns, t1 - t0,
+		    __ATOMIC_RELAXED);
+		__atomic_fetch_add(&g->stats.add_edge_ns, now_ns() - t1,
+		    __ATOMIC_RELAXED);
+		__atomic_fetch_add(&g->stats.nkeys, n, __ATOMIC_RELAXED);
+
+		return RGPH_SUCCESS;
+	}
+};
+
+// rgph_builder_begin() allocates a big index, switch to index_t
+// if all indices fit.
+inline void
+narrow_chm_index(struct rgph_graph *g)
+{
+	auto src = static_cast<big_index_t const *>(g->index);
+	auto dst = static_cast<index_t *>(g->index);
+	void *index;
+
+	assert(g->indexmax <= INDEX_MAX);
+
+	for (size_t i = 0; i < g->nkeys; i++)
+		dst[i] = src[i];
+
+	index = realloc(g->index, chm_index_size(g->nkeys, g->indexmax));
+	if (index != nullptr)
+		g->index = index;
+
+	g->stats.allocated -= g->nkeys * sizeof(big_index_t);
+	g->stats.allocated += chm_index_size(g->nkeys, g->indexmax);
+}
+
+template<class V, int R>
+V const *
+build_peel_index(struct rgph_graph *g)
+{
+	size_t const hash_sz = duphash_size<V,R>(g->nverts);
+	auto peel = reinterpret_cast<V *>(g->shared.bdz_assignments + hash_sz);
+
+	assert(hash_sz != 0);
+
+	if (!(g->flags & PEELED)) {
+		auto order = static_cast<V const *>(g->order);
+		uint64_t const t0 = now_ns();
+
+		g->flags |= PEELED;
+		g->flags &= ~ASSIGNED;
+		memset(peel, 0, sizeof(V) * g->nkeys);
+
+		for (size_t i = g->nkeys; i > g->core_size; i--) {
+			assert(peel[order[i-1]] == 0);
+			peel[order[i-1]] = g->nkeys - i + 1;
+		}
+
+		g->stats.peel_index_ns += now_ns() - t0;
+	}
+
+	return peel;
+}
+
+template<class V, int R>
+int
+copy_edge(struct rgph_graph *g, size_t e, uint32_t *to, size_t *peel_order)
+{
+	typedef edge<V,R> edge_t;
+
+	auto edges = static_cast<edge_t *>(g->edges);
+
+	for (size_t r = 0; r < R; r++)
+		to[r] = edges[e].verts[r];
+
+	if (peel_order != nullptr) {
+		V const *peel = build_peel_index<V,R>(g);
+		*peel_order = peel[e];
+	}
+
+	return RGPH_SUCCESS;
+}
+
+template<class V, int R>
+int
+find_duplicates(struct rgph_graph *g,
+    rgph_entry_iterator_t iter, void *state, size_t *dup)
+{
+	typedef edge<V,R> edge_t;
+
+	assert((g->nverts % R) == 0);
+
+	size_t const hash_sz = g->nverts / R;
+	size_t const maxfill = g->nverts / 4; // Fill factor is 50% or 75%.
+	auto hash = g->shared.duphash;
+
+	for (size_t i = 0; i < hash_sz; i++)
+		hash[i] = nullptr;
+
+	int res = RGPH_NOKEY;
+	V const *peel = build_peel_index<V,R>(g);
+	auto edges = static_cast<edge_t const *>(g->edges);
+	entry_iterator keys(iter, state), keys_end;
 
 	size_t hashed = 0;
 	for (size_t e = 0; e < g->nkeys; ++e, ++keys) {
@@ -1297,6 +2452,7 @@ graph_assign_chm(struct rgph_graph *g)
 			g->assigned = (unsigned long *)malloc(wsize * nwords);
 			if (g->assigned == nullptr)
 				return RGPH_NOMEM;
+			g->stats.allocated += wsize * nwords;
 		}
 		assign(edges, order, g->nkeys, assigner,
 		    assignments, g->nverts, g->assigned);
@@ -1335,6 +2491,68 @@ graph_assign(struct rgph_graph *g)
 	}
 }
 
+template<class V, int R, class A, class K>
+inline int
+lookup(struct rgph_graph const *g, A const &assigned,
+    K const &keys, size_t n, uint64_t *out)
+{
+	auto const f = make_lookup_fn<V,R>(assigned, keys, n, out);
+
+	return with_hash<V,R>(g->flags, g->nverts,
+	    g->hash, g->seed, g->keylen, f);
+}
+
+// Modulo and offset of index sums in chm_lookup.
+inline void
+chm_index_params(struct rgph_graph const *g,
+    big_index_t *mod, big_index_t *min)
+{
+
+	if (need_assigned_bitset(g->flags, g->indexmin, g->indexmax)) {
+		*mod = 0;
+		*min = 0;
+	} else if (g->flags & RGPH_INDEX_COMPACT) {
+		*mod = g->indexmax - g->indexmin + 1;
+		*min = g->indexmin;
+	} else {
+		*mod = big_index_t(1) << fls64(g->indexmax);
+		*min = 0;
+	}
+}
+
+template<class V, int R, class X, class K>
+inline int
+lookup_chm(struct rgph_graph const *g,
+    K const &keys, size_t n, uint64_t *out)
+{
+	chm_lookup<X,V,R> a = {
+		static_cast<X const *>(g->shared.chm_assignments), 0, 0
+	};
+
+	chm_index_params(g, &a.mod, &a.min);
+	return lookup<V,R>(g, a, keys, n, out);
+}
+
+template<class V, int R, class K>
+int
+graph_lookup(struct rgph_graph const *g,
+    K const &keys, size_t n, uint64_t *out)
+{
+	bdz_lookup<V,R> const bdz = { g->shared.bdz_assignments };
+
+	switch (g->flags & RGPH_ALGO_MASK) {
+	case RGPH_ALGO_BDZ:
+		return lookup<V,R>(g, bdz, keys, n, out);
+	case RGPH_ALGO_CHM:
+		return (g->indexmax > INDEX_MAX)
+		    ? lookup_chm<V,R,big_index_t>(g, keys, n, out)
+		    : lookup_chm<V,R,index_t>(g, keys, n, out);
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
 inline bool
 set_default_flags(int *flags)
 {
@@ -1430,6 +2648,11 @@ update_flags_for_build(unsigned int *flags, int new_flags, size_t nkeys)
 		*flags |= new_flags & RGPH_INDEX_MASK;
 	}
 
+	// Every build decides, later builds without the flag don't pay
+	// for peel stats.
+	*flags &= ~RGPH_INSTRUMENT;
+	*flags |= new_flags & RGPH_INSTRUMENT;
+
 	return RGPH_SUCCESS;
 }
 
@@ -1491,7 +2714,8 @@ rgph_alloc_graph(size_t nkeys, int flags)
 	int save_errno;
 	int r;
 
-	if (!set_default_flags(&flags)) {
+	// RGPH_INSTRUMENT is a build flag, see update_flags_for_build().
+	if (!set_default_flags(&flags) || (flags & RGPH_INSTRUMENT)) {
 		errno = EINVAL;
 		return nullptr;
 	}
@@ -1540,15 +2764,23 @@ rgph_alloc_graph(size_t nkeys, int flags)
 		goto err;
 
 	g->seed       = 0;
+	g->hash       = nullptr;
 	g->nkeys      = nkeys;
 	g->nverts     = nverts;
 	g->core_size  = nkeys;
 	g->datalenmin = SIZE_MAX;
 	g->datalenmax = 0;
+	g->keylen     = 0;
+	g->build_pos  = 0;
+	g->peel_pos   = 0;
+	g->peel_top   = 0;
 	g->indexmin = BIG_INDEX_MAX;
 	g->indexmax = 0;
 	g->flags      = flags | ZEROED; // calloc
 
+	g->stats.allocated = sizeof(*g) + sizeof(vert_t) * nkeys +
+	    esz * nkeys + osz;
+
 	return g;
 err:
 	save_errno = errno;
@@ -1589,6 +2821,14 @@ rgph_vertices(struct rgph_graph const *g)
 	return g->nverts;
 }
 
+extern "C"
+size_t
+rgph_keylen(struct rgph_graph const *g)
+{
+
+	return g->keylen;
+}
+
 extern "C"
 size_t
 rgph_datalen_min(struct rgph_graph const *g)
@@ -1684,6 +2924,253 @@ rgph_build_graph(struct rgph_graph *g, int flags, rgph_vector_hash_t hash,
 	}
 }
 
+template<class T>
+inline int
+build_ints(struct rgph_graph *g, int flags, rgph_vector_hash_t hash,
+    uintptr_t seed, T const *keys, size_t nkeys)
+{
+	int res;
+
+	// Fail before update_flags_for_build() changes g->flags.
+	if (nkeys != g->nkeys)
+		return RGPH_INVAL;
+
+	res = update_flags_for_build(&g->flags, flags, g->nkeys);
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		return build_graph_ints<vert_t,2>(g, keys, hash, seed);
+	case 3:
+		return build_graph_ints<vert_t,3>(g, keys, hash, seed);
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
+extern "C"
+int
+rgph_build_graph_u32(struct rgph_graph *g, int flags, rgph_vector_hash_t hash,
+    uintptr_t seed, const uint32_t *keys, size_t nkeys)
+{
+
+	return build_ints(g, flags, hash, seed, keys, nkeys);
+}
+
+extern "C"
+int
+rgph_build_graph_u64(struct rgph_graph *g, int flags, rgph_vector_hash_t hash,
+    uintptr_t seed, const uint64_t *keys, size_t nkeys)
+{
+
+	return build_ints(g, flags, hash, seed, keys, nkeys);
+}
+
+extern "C"
+int
+rgph_build_begin(struct rgph_graph *g, int flags,
+    rgph_vector_hash_t hash, uintptr_t seed)
+{
+	int res = update_flags_for_build(&g->flags, flags, g->nkeys);
+
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		reset_graph<vert_t,2>(g, hash, seed);
+		break;
+	case 3:
+		reset_graph<vert_t,3>(g, hash, seed);
+		break;
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+
+	g->peel_pos = 0;
+	g->peel_top = 0;
+	g->flags |= STEPPING;
+
+	return RGPH_SUCCESS;
+}
+
+// Zero budgets are unlimited, maxns is converted to a deadline.
+inline uint64_t
+step_deadline(uint64_t maxns)
+{
+
+	return maxns == 0 ? 0 : now_ns() + maxns;
+}
+
+extern "C"
+int
+rgph_build_step(struct rgph_graph *g, rgph_entry_iterator_t keys,
+    void *state, size_t maxkeys, uint64_t maxns)
+{
+	uint64_t const deadline = step_deadline(maxns);
+
+	if (!(g->flags & STEPPING) || (g->flags & PUSHING))
+		return RGPH_INVAL;
+
+	if (g->build_pos == g->nkeys)
+		return RGPH_SUCCESS;
+
+	if (maxkeys == 0)
+		maxkeys = SIZE_MAX;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		return build_step<vert_t,2>(g, keys, state, maxkeys, deadline);
+	case 3:
+		return build_step<vert_t,3>(g, keys, state, maxkeys, deadline);
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
+extern "C"
+size_t
+rgph_build_position(struct rgph_graph const *g)
+{
+
+	return g->build_pos;
+}
+
+extern "C"
+int
+rgph_build_finish(struct rgph_graph *g, size_t maxverts, uint64_t maxns)
+{
+	uint64_t const deadline = step_deadline(maxns);
+
+	if (!(g->flags & STEPPING) || (g->flags & PUSHING) ||
+	    g->build_pos != g->nkeys) {
+		return RGPH_INVAL;
+	}
+
+	if (maxverts == 0)
+		maxverts = SIZE_MAX;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		return build_finish<vert_t,2>(g, maxverts, deadline);
+	case 3:
+		return build_finish<vert_t,3>(g, maxverts, deadline);
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
+extern "C"
+int
+rgph_builder_begin(struct rgph_graph *g, int flags,
+    rgph_vector_hash_t hash, uintptr_t seed)
+{
+	int res = rgph_build_begin(g, flags, hash, seed);
+	void *index = nullptr;
+
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	// Indices can't be implicit because keys arrive in any order.
+	// Their range isn't known either, start with a big index.
+	if ((g->flags & RGPH_ALGO_MASK) == RGPH_ALGO_CHM) {
+		index = malloc(sizeof(big_index_t) * g->nkeys);
+		if (index == nullptr) {
+			g->flags &= ~STEPPING;
+			return RGPH_NOMEM;
+		}
+	}
+
+	if (g->index != nullptr) {
+		g->stats.allocated -= chm_index_size(g->nkeys, g->indexmax);
+		free(g->index);
+	}
+
+	g->index = index;
+	g->stats.allocated += index ? sizeof(big_index_t) * g->nkeys : 0;
+	g->indexmin = BIG_INDEX_MAX;
+	g->indexmax = 0;
+	g->keylen = 0; // Lookups don't know key lengths of producers.
+	g->flags |= PUSHING;
+
+	return RGPH_SUCCESS;
+}
+
+extern "C"
+int
+rgph_builder_add(struct rgph_graph *g, const struct rgph_entry *ents, size_t n)
+{
+	size_t e;
+
+	if (!(g->flags & PUSHING))
+		return RGPH_INVAL;
+
+	if (n > g->nkeys)
+		return RGPH_RANGE;
+
+	e = __atomic_fetch_add(&g->build_pos, n, __ATOMIC_RELAXED);
+	if (e > g->nkeys || n > g->nkeys - e)
+		return RGPH_RANGE;
+
+	switch (graph_rank(g->flags)) {
+	case 2: {
+		add_entries_fn<vert_t,2> const add = { g, ents, n, vert_t(e) };
+		return with_hash<vert_t,2>(g->flags, g->nverts,
+		    g->hash, g->seed, g->keylen, add);
+	}
+	case 3: {
+		add_entries_fn<vert_t,3> const add = { g, ents, n, vert_t(e) };
+		return with_hash<vert_t,3>(g->flags, g->nverts,
+		    g->hash, g->seed, g->keylen, add);
+	}
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
+extern "C"
+int
+rgph_builder_finish(struct rgph_graph *g, int flags)
+{
+	int res;
+
+	if (!(g->flags & PUSHING))
+		return RGPH_INVAL;
+
+	if (g->build_pos < g->nkeys)
+		return RGPH_NOKEY;
+	else if (g->build_pos > g->nkeys)
+		return RGPH_RANGE;
+
+	if (g->index != nullptr && g->indexmax <= INDEX_MAX)
+		narrow_chm_index(g);
+
+	g->flags &= ~PUSHING;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		res = build_finish<vert_t,2>(g, SIZE_MAX, 0);
+		break;
+	case 3:
+		res = build_finish<vert_t,3>(g, SIZE_MAX, 0);
+		break;
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	return rgph_assign(g, flags);
+}
+
 extern "C"
 int
 rgph_copy_edge(struct rgph_graph *g,
@@ -1712,19 +3199,28 @@ int
 rgph_find_duplicates(struct rgph_graph *g,
     rgph_entry_iterator_t keys, void *state, size_t *dup)
 {
+	uint64_t t0;
+	int res;
 
 	if (!(g->flags & BUILT))
 		return RGPH_INVAL;
 
+	t0 = now_ns();
+
 	switch (graph_rank(g->flags)) {
 	case 2:
-		return find_duplicates<vert_t,2>(g, keys, state, dup);
+		res = find_duplicates<vert_t,2>(g, keys, state, dup);
+		break;
 	case 3:
-		return find_duplicates<vert_t,3>(g, keys, state, dup);
+		res = find_duplicates<vert_t,3>(g, keys, state, dup);
+		break;
 	default:
 		assert(0 && "rgph_alloc_graph() should have caught it");
 		return RGPH_INVAL;
 	}
+
+	g->stats.duplicates_ns += now_ns() - t0;
+	return res;
 }
 
 extern "C"
@@ -1739,15 +3235,22 @@ rgph_assign(struct rgph_graph *g, int flags)
 	if (g->core_size != 0)
 		return RGPH_AGAIN;
 
+	uint64_t const t0 = now_ns();
+
 	switch (graph_rank(g->flags)) {
 	case 2:
-		return graph_assign<vert_t,2>(g);
+		res = graph_assign<vert_t,2>(g);
+		break;
 	case 3:
-		return graph_assign<vert_t,3>(g);
+		res = graph_assign<vert_t,3>(g);
+		break;
 	default:
 		assert(0 && "rgph_alloc_graph() should have caught it");
 		return RGPH_INVAL;
 	}
+
+	g->stats.assign_ns += now_ns() - t0;
+	return res;
 }
 
 extern "C"
@@ -1796,6 +3299,148 @@ rgph_copy_assignment(struct rgph_graph const *g, size_t n, uint64_t *to)
 	}
 }
 
+extern "C"
+int
+rgph_get_lookup_params(struct rgph_graph const *g,
+    struct rgph_lookup_params *p)
+{
+	int const rank = graph_rank(g->flags);
+	size_t const nbits = vertex_bits(g->flags);
+	bool const assigned = (g->flags & ASSIGNED) != 0;
+
+	if (!assigned)
+		return RGPH_INVAL;
+
+	fastrem_partition const mod(g->nverts, rank);
+	lemire_partition const mul(g->nverts, rank, nbits);
+	size_t width = 0;
+
+	p->assignments = rgph_assignments(g, &width);
+	p->width = width;
+	p->hash = g->hash;
+	p->seed = g->seed;
+	p->index_mod = 0;
+	p->index_base = 0;
+	p->unassigned = 0; // See assign().
+	p->nverts = g->nverts;
+	p->partsz = mod.partsz;
+	p->fastdiv_mul = mod.mul;
+	p->fastdiv_s2 = mod.s2;
+	p->lemire_shift = mul.shift;
+	p->partition_bits = nbits / rank;
+	p->rank = rank;
+	p->flags = g->flags & PUBLIC_FLAGS;
+
+	if ((g->flags & RGPH_ALGO_MASK) == RGPH_ALGO_CHM)
+		chm_index_params(g, &p->index_mod, &p->index_base);
+
+	return RGPH_SUCCESS;
+}
+
+extern "C"
+void
+rgph_get_stats(struct rgph_graph const *g, struct rgph_stats *stats)
+{
+
+	*stats = g->stats;
+}
+
+extern "C"
+int
+rgph_get_peel_stats(struct rgph_graph const *g, struct rgph_peel_stats *stats)
+{
+
+	if (!(g->flags & BUILT) || !(g->flags & RGPH_INSTRUMENT))
+		return RGPH_INVAL;
+
+	*stats = g->peel_stats;
+	return RGPH_SUCCESS;
+}
+
+extern "C"
+int
+rgph_lookup(struct rgph_graph const *g,
+    void const *key, size_t keylen, uint64_t *out)
+{
+
+	return rgph_lookup_batch(g, &key, &keylen, 1, out);
+}
+
+extern "C"
+int
+rgph_lookup_batch(struct rgph_graph const *g, void const * const *keys,
+    size_t const *keylens, size_t n, uint64_t *out)
+{
+
+	data_keys const k = { keys, keylens };
+
+	if (!(g->flags & ASSIGNED))
+		return RGPH_INVAL;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		return graph_lookup<vert_t,2>(g, k, n, out);
+	case 3:
+		return graph_lookup<vert_t,3>(g, k, n, out);
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
+template<class T>
+inline int
+lookup_ints(struct rgph_graph const *g, T const *keys, size_t n, uint64_t *out)
+{
+
+	if (!(g->flags & ASSIGNED))
+		return RGPH_INVAL;
+
+	switch (graph_rank(g->flags)) {
+	case 2:
+		return graph_lookup<vert_t,2>(g, keys, n, out);
+	case 3:
+		return graph_lookup<vert_t,3>(g, keys, n, out);
+	default:
+		assert(0 && "rgph_alloc_graph() should have caught it");
+		return RGPH_INVAL;
+	}
+}
+
+extern "C"
+int
+rgph_lookup_u32(struct rgph_graph const *g, uint32_t key, uint64_t *out)
+{
+
+	return lookup_ints(g, &key, 1, out);
+}
+
+extern "C"
+int
+rgph_lookup_u64(struct rgph_graph const *g, uint64_t key, uint64_t *out)
+{
+
+	return lookup_ints(g, &key, 1, out);
+}
+
+extern "C"
+int
+rgph_lookup_batch_u32(struct rgph_graph const *g,
+    const uint32_t *keys, size_t n, uint64_t *out)
+{
+
+	return lookup_ints(g, keys, n, out);
+}
+
+extern "C"
+int
+rgph_lookup_batch_u64(struct rgph_graph const *g,
+    const uint64_t *keys, size_t n, uint64_t *out)
+{
+
+	return lookup_ints(g, keys, n, out);
+}
+
 extern "C"
 size_t
 rgph_count_keys(rgph_entry_iterator_t iter, void *state)
@@ -0,0 +1,207 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rgph_defs.h"
+#include "rgph_graph.h"
+#include "rgph_handle.h"
+
+/*
+ * Readers increment a counter of the current epoch parity before they
+ * load the graph pointer. A publisher stores the new pointer, flips the
+ * parity and waits until counters of the old parity drop to zero, then
+ * does it again for readers that read the parity before the first flip.
+ * Readers that increment a counter after the publisher checked it see
+ * the new pointer. Counters are striped by thread to avoid bouncing
+ * a single cache line between readers.
+ */
+#define NSTRIPES   32
+#define CACHE_LINE 64
+
+struct stripe {
+	unsigned long count[2];
+	char pad[CACHE_LINE - 2 * sizeof(unsigned long)];
+};
+
+struct rgph_handle {
+	struct stripe readers[NSTRIPES];
+	struct rgph_graph *graph;
+	unsigned long epoch;
+	pthread_mutex_t publish_lock;
+};
+
+static unsigned next_stripe;
+static __thread unsigned thread_stripe; /* Plus one, 0 if not set. */
+
+static unsigned
+current_stripe(void)
+{
+
+	if (thread_stripe == 0) {
+		thread_stripe = 1 + __atomic_fetch_add(&next_stripe, 1,
+		    __ATOMIC_RELAXED) % NSTRIPES;
+	}
+
+	return thread_stripe - 1;
+}
+
+/* Unlike rgph_is_assigned(), doesn't assert on graphs with a core. */
+static int
+is_assigned(const struct rgph_graph *g)
+{
+
+	return rgph_assignments(g, NULL) != NULL;
+}
+
+struct rgph_handle *
+rgph_handle_create(struct rgph_graph *g)
+{
+	struct rgph_handle *h;
+	void *mem;
+
+	if (g != NULL && !is_assigned(g)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	/* Stripes shouldn't share cache lines with other objects. */
+	if (posix_memalign(&mem, CACHE_LINE, sizeof(*h)) != 0) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	h = memset(mem, 0, sizeof(*h));
+	h->graph = g;
+	pthread_mutex_init(&h->publish_lock, NULL);
+
+	return h;
+}
+
+void
+rgph_handle_destroy(struct rgph_handle *h)
+{
+
+	if (h == NULL)
+		return;
+
+	pthread_mutex_destroy(&h->publish_lock);
+	rgph_free_graph(h->graph);
+	free(h);
+}
+
+const struct rgph_graph *
+rgph_handle_enter(struct rgph_handle *h, unsigned *token)
+{
+	unsigned const s = current_stripe();
+	unsigned const p = __atomic_load_n(&h->epoch, __ATOMIC_RELAXED) & 1;
+
+	__atomic_fetch_add(&h->readers[s].count[p], 1, __ATOMIC_SEQ_CST);
+	*token = s << 1 | p;
+	return __atomic_load_n(&h->graph, __ATOMIC_SEQ_CST);
+}
+
+void
+rgph_handle_leave(struct rgph_handle *h, unsigned token)
+{
+
+	__atomic_fetch_sub(&h->readers[token >> 1].count[token & 1], 1,
+	    __ATOMIC_RELEASE);
+}
+
+static void
+wait_readers(struct rgph_handle *h, unsigned p)
+{
+	unsigned long n;
+	size_t i;
+
+	do {
+		n = 0;
+		for (i = 0; i < NSTRIPES; i++) {
+			n += __atomic_load_n(&h->readers[i].count[p],
+			    __ATOMIC_SEQ_CST);
+		}
+		if (n > 0)
+			sched_yield();
+	} while (n > 0);
+}
+
+int
+rgph_handle_publish(struct rgph_handle *h, struct rgph_graph *g)
+{
+	struct rgph_graph *old;
+	unsigned long e;
+	int i;
+
+	if (g != NULL && !is_assigned(g))
+		return RGPH_INVAL;
+
+	pthread_mutex_lock(&h->publish_lock);
+
+	old = __atomic_exchange_n(&h->graph, g, __ATOMIC_SEQ_CST);
+
+	for (i = 0; i < 2; i++) {
+		e = __atomic_fetch_add(&h->epoch, 1, __ATOMIC_SEQ_CST);
+		wait_readers(h, e & 1);
+	}
+
+	pthread_mutex_unlock(&h->publish_lock);
+
+	rgph_free_graph(old);
+	return RGPH_SUCCESS;
+}
+
+int
+rgph_handle_lookup(struct rgph_handle *h,
+    const void *key, size_t keylen, uint64_t *out)
+{
+
+	return rgph_handle_lookup_batch(h, &key, &keylen, 1, out);
+}
+
+int
+rgph_handle_lookup_batch(struct rgph_handle *h, const void * const *keys,
+    const size_t *keylens, size_t n, uint64_t *out)
+{
+	const struct rgph_graph *g;
+	unsigned token;
+	int res = RGPH_NOKEY;
+
+	g = rgph_handle_enter(h, &token);
+	if (g != NULL)
+		res = rgph_lookup_batch(g, keys, keylens, n, out);
+	rgph_handle_leave(h, token);
+
+	return res;
+}
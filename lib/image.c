@@ -0,0 +1,351 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rgph_defs.h"
+#include "rgph_fastdiv.h"
+#include "rgph_graph.h"
+#include "rgph_image.h"
+#include "rgph_lookup.h"
+
+#define IMAGE_MAGIC      "RGPHIMG1"
+#define IMAGE_BYTE_ORDER UINT32_C(0x01020304)
+#define IMAGE_ALIGN      128 /* Offset of assignments. */
+
+/*
+ * On-disk header, followed by padding to IMAGE_ALIGN and
+ * assignments. All fields are in native byte order.
+ */
+struct image_header {
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t header_size;
+	uint64_t nkeys;
+	uint64_t nverts;
+	uint64_t seed;
+	uint64_t index_mod;
+	uint64_t index_base;
+	uint64_t unassigned;
+	uint32_t partsz;
+	uint32_t fastdiv_mul;
+	uint8_t fastdiv_s2;
+	uint8_t lemire_shift;
+	uint8_t partition_bits;
+	uint8_t width;
+	int32_t rank;
+	int32_t flags;
+	uint32_t pad;
+};
+
+/* Fail to compile if the header doesn't fit. */
+typedef char image_header_fits[
+    sizeof(struct image_header) <= IMAGE_ALIGN ? 1 : -1];
+
+struct rgph_image {
+	struct rgph_lookup_params params;
+	void *map;
+	size_t mapsize;
+	size_t nkeys;
+};
+
+static int
+write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1)
+			return -1;
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int
+is_builtin_hash(int flags)
+{
+	const int hash = flags & RGPH_HASH_MASK;
+
+	return hash >= RGPH_HASH_JENKINS2V && hash <= RGPH_HASH_LAST;
+}
+
+/*
+ * Write to a temporary file and rename it to path, processes
+ * opening the image never see a partially written file.
+ */
+int
+rgph_save_image(struct rgph_graph const *g, const char *path)
+{
+	static const char zeroes[IMAGE_ALIGN];
+	struct rgph_lookup_params p;
+	struct image_header h;
+	char tmp[PATH_MAX];
+	int fd, res, saved_errno;
+
+	res = rgph_get_lookup_params(g, &p);
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	if (!is_builtin_hash(p.flags))
+		return RGPH_INVAL;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, IMAGE_MAGIC, sizeof(h.magic));
+	h.byte_order = IMAGE_BYTE_ORDER;
+	h.header_size = sizeof(h);
+	h.nkeys = rgph_entries(g);
+	h.nverts = p.nverts;
+	h.seed = p.seed;
+	h.index_mod = p.index_mod;
+	h.index_base = p.index_base;
+	h.unassigned = p.unassigned;
+	h.partsz = p.partsz;
+	h.fastdiv_mul = p.fastdiv_mul;
+	h.fastdiv_s2 = p.fastdiv_s2;
+	h.lemire_shift = p.lemire_shift;
+	h.partition_bits = p.partition_bits;
+	h.width = p.width;
+	h.rank = p.rank;
+	h.flags = p.flags;
+
+	if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp))
+		return RGPH_RANGE;
+
+	fd = mkstemp(tmp);
+	if (fd == -1)
+		return RGPH_IO;
+
+	if (write_all(fd, &h, sizeof(h)) == -1 ||
+	    write_all(fd, zeroes, IMAGE_ALIGN - sizeof(h)) == -1 ||
+	    write_all(fd, p.assignments, p.nverts * p.width) == -1 ||
+	    fchmod(fd, 0644) == -1) {
+		saved_errno = errno;
+		close(fd);
+		unlink(tmp);
+		errno = saved_errno;
+		return RGPH_IO;
+	}
+
+	if (close(fd) == -1 || rename(tmp, path) == -1) {
+		saved_errno = errno;
+		unlink(tmp);
+		errno = saved_errno;
+		return RGPH_IO;
+	}
+
+	return RGPH_SUCCESS;
+}
+
+/* Bits of vertex hashes, see vertex_bits() in graph.cc. */
+static unsigned int
+vertex_bits(int flags, int rank)
+{
+
+	switch (flags & RGPH_HASH_MASK) {
+	case RGPH_HASH_JENKINS2V:
+		return 96;
+	case RGPH_HASH_MURMUR32V:
+	case RGPH_HASH_AES128V:
+	case RGPH_HASH_XXH128V:
+		return 128;
+	default:
+		return 32 * rank;
+	}
+}
+
+/*
+ * Lookups trust the header to keep vertices below nverts,
+ * recompute everything that can be derived from other fields.
+ */
+static int
+valid_params(const struct image_header *h)
+{
+	const int public_flags = RGPH_HASH_MASK | RGPH_RANK_MASK |
+	    RGPH_ALGO_MASK | RGPH_REDUCE_MASK | RGPH_INDEX_MASK |
+	    RGPH_INSTRUMENT;
+	const int rank_flag = h->rank == 2 ? RGPH_RANK2 : RGPH_RANK3;
+	const int bdz = (h->flags & RGPH_ALGO_MASK) == RGPH_ALGO_BDZ;
+	uint32_t mul;
+	uint8_t s1, s2;
+
+	if ((h->flags & ~public_flags) != 0 ||
+	    (h->flags & RGPH_RANK_MASK) != rank_flag ||
+	    (h->flags & RGPH_ALGO_MASK) == 0 ||
+	    (h->flags & RGPH_ALGO_MASK) == RGPH_ALGO_MASK ||
+	    (h->flags & RGPH_REDUCE_MASK) == 0 ||
+	    (h->flags & RGPH_REDUCE_MASK) == RGPH_REDUCE_MASK ||
+	    (h->flags & RGPH_INDEX_MASK) == RGPH_INDEX_MASK) {
+		return 0;
+	}
+
+	if (bdz != (h->width == 1))
+		return 0;
+
+	rgph_fastdiv_prepare(h->partsz, &mul, &s1, &s2, 1);
+
+	return s1 == 1 && h->fastdiv_mul == mul && h->fastdiv_s2 == s2 &&
+	    h->lemire_shift == 32 &&
+	    h->partition_bits == vertex_bits(h->flags, h->rank) / h->rank;
+}
+
+static int
+valid_header(const struct image_header *h, size_t mapsize)
+{
+
+	return memcmp(h->magic, IMAGE_MAGIC, sizeof(h->magic)) == 0 &&
+	    h->byte_order == IMAGE_BYTE_ORDER &&
+	    h->header_size == sizeof(*h) &&
+	    is_builtin_hash(h->flags) &&
+	    (h->rank == 2 || h->rank == 3) &&
+	    (h->width == 1 || h->width == 4 || h->width == 8) &&
+	    h->partsz > 1 && h->nverts == (uint64_t)h->partsz * h->rank &&
+	    h->nverts <= (mapsize - IMAGE_ALIGN) / h->width &&
+	    valid_params(h);
+}
+
+struct rgph_image *
+rgph_open_image(const char *path)
+{
+	struct rgph_image *img;
+	const struct image_header *h;
+	struct stat st;
+	void *map;
+	int fd, saved_errno;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	if (fstat(fd, &st) == -1) {
+		saved_errno = errno;
+		close(fd);
+		errno = saved_errno;
+		return NULL;
+	}
+
+	if (st.st_size < IMAGE_ALIGN || (uintmax_t)st.st_size > SIZE_MAX) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	saved_errno = errno;
+	close(fd);
+	if (map == MAP_FAILED) {
+		errno = saved_errno;
+		return NULL;
+	}
+
+	h = map;
+	if (!valid_header(h, st.st_size)) {
+		munmap(map, st.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	img = malloc(sizeof(*img));
+	if (img == NULL) {
+		munmap(map, st.st_size);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	img->map = map;
+	img->mapsize = st.st_size;
+	img->nkeys = h->nkeys;
+	img->params.assignments = (const char *)map + IMAGE_ALIGN;
+	img->params.hash = NULL;
+	img->params.seed = h->seed;
+	img->params.index_mod = h->index_mod;
+	img->params.index_base = h->index_base;
+	img->params.unassigned = h->unassigned;
+	img->params.nverts = h->nverts;
+	img->params.partsz = h->partsz;
+	img->params.fastdiv_mul = h->fastdiv_mul;
+	img->params.fastdiv_s2 = h->fastdiv_s2;
+	img->params.lemire_shift = h->lemire_shift;
+	img->params.partition_bits = h->partition_bits;
+	img->params.width = h->width;
+	img->params.rank = h->rank;
+	img->params.flags = h->flags;
+
+	return img;
+}
+
+void
+rgph_close_image(struct rgph_image *img)
+{
+
+	if (img == NULL)
+		return;
+
+	munmap(img->map, img->mapsize);
+	free(img);
+}
+
+size_t
+rgph_image_entries(struct rgph_image const *img)
+{
+
+	return img->nkeys;
+}
+
+const struct rgph_lookup_params *
+rgph_image_params(struct rgph_image const *img)
+{
+
+	return &img->params;
+}
+
+int
+rgph_image_lookup(struct rgph_image const *img,
+    const void *key, size_t keylen, uint64_t *out)
+{
+
+	*out = rgph_inline_lookup(&img->params, key, keylen);
+	return RGPH_SUCCESS;
+}
@@ -34,12 +34,13 @@
  */
 #include "rgph_hash_impl.h"
 #include "rgph_hash.h"
+#include "rgph_cpu.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
 
-void
+inline void
 rgph_u32x3_jenkins2v_data(const void *data,
     size_t len, uintptr_t seed, uint32_t * restrict h)
 {
@@ -109,3 +110,153 @@ rgph_u32x3_jenkins2v_data(const void *data,
 		rgph_jenkins2_mix(h);
 	}
 }
+
+/*
+ * Read 32bit and 64bit words from any pointer in little-endian order.
+ */
+static inline uint32_t
+read32(const uint8_t *ptr)
+{
+	uint32_t w;
+
+	memcpy(&w, ptr, sizeof(w));
+	return htole32(w);
+}
+
+static inline uint64_t
+read64(const uint8_t *ptr)
+{
+	uint64_t w;
+
+	memcpy(&w, ptr, sizeof(w));
+	return htole64(w);
+}
+
+/*
+ * Add a 12 byte block and mix.
+ */
+static inline void
+jenkins2v_block(const uint8_t *key, uint32_t *h)
+{
+
+	h[0] += read32(&key[0]);
+	h[1] += read32(&key[4]);
+	h[2] += read32(&key[8]);
+	rgph_jenkins2_mix(h);
+}
+
+/*
+ * The last 0 to 11 bytes of a key are added as a zero padded block,
+ * this is what rgph_u32x3_jenkins2v_data() does word by word. They're
+ * read with a single load of the last 12 bytes, the key must be 12
+ * bytes or longer.
+ */
+static inline void
+jenkins2v_last(const uint8_t *key, size_t len, uint32_t *h)
+{
+	const unsigned int shift = (12 - len % 12) * CHAR_BIT;
+	const unsigned int s = shift & 63;
+	uint64_t lo, hi;
+
+	lo = read64(&key[len - 12]);
+	hi = read32(&key[len - 4]);
+
+	/* Shift the 96bit hi:lo right by 8 to 96 bits without branches. */
+	lo = shift >= 64 ? hi >> s : (lo >> s) | (hi << (63 - s) << 1);
+	hi = shift >= 64 ? 0 : hi >> s;
+
+	h[0] += (uint32_t)lo;
+	h[1] += (uint32_t)(lo >> 32);
+	h[2] += (uint32_t)hi;
+	h[2] += len;
+	rgph_jenkins2_mix(h);
+}
+
+/*
+ * Hash four keys of 12 bytes or longer. Blocks of different keys are
+ * processed round-robin while every key has a full block. Independent
+ * mix chains keep more execution units busy than a single key does.
+ */
+static inline void
+jenkins2v_x4(const uint8_t * const key[4], const size_t len[4],
+    uintptr_t seed, uint32_t h[4][3])
+{
+	uint32_t h0[3], h1[3], h2[3], h3[3];
+	size_t end[4], i, off, minend;
+
+	/* Bytes in full blocks, the last block is always partial. */
+	for (i = 0; i < 4; i++)
+		end[i] = len[i] - len[i] % 12;
+
+	minend = end[0];
+	for (i = 1; i < 4; i++) {
+		if (end[i] < minend)
+			minend = end[i];
+	}
+
+	h0[0] = h1[0] = h2[0] = h3[0] = RGPH_JENKINS2V_SEED1;
+	h0[1] = h1[1] = h2[1] = h3[1] = RGPH_JENKINS2V_SEED2;
+	h0[2] = h1[2] = h2[2] = h3[2] = seed;
+
+	for (off = 0; off < minend; off += 12) {
+		jenkins2v_block(&key[0][off], h0);
+		jenkins2v_block(&key[1][off], h1);
+		jenkins2v_block(&key[2][off], h2);
+		jenkins2v_block(&key[3][off], h3);
+	}
+
+	/* Longer keys catch up one by one. */
+	for (i = off; i < end[0]; i += 12)
+		jenkins2v_block(&key[0][i], h0);
+	for (i = off; i < end[1]; i += 12)
+		jenkins2v_block(&key[1][i], h1);
+	for (i = off; i < end[2]; i += 12)
+		jenkins2v_block(&key[2][i], h2);
+	for (i = off; i < end[3]; i += 12)
+		jenkins2v_block(&key[3][i], h3);
+
+	jenkins2v_last(key[0], len[0], h0);
+	jenkins2v_last(key[1], len[1], h1);
+	jenkins2v_last(key[2], len[2], h2);
+	jenkins2v_last(key[3], len[3], h3);
+
+	memcpy(h[0], h0, sizeof(h0));
+	memcpy(h[1], h1, sizeof(h1));
+	memcpy(h[2], h2, sizeof(h2));
+	memcpy(h[3], h3, sizeof(h3));
+}
+
+void
+rgph_u32x3_jenkins2v_data_batch(const void * const *data,
+    const size_t *len, size_t nkeys, uintptr_t seed, uint32_t *out)
+{
+	const uint8_t *key[4];
+	size_t keylen[4];
+	uint32_t h[4][3];
+	size_t i, j, n;
+
+	for (i = 0; i < nkeys; i += n) {
+		n = nkeys - i < 4 ? nkeys - i : 4;
+
+		/* Pad a short group with copies of its first key. */
+		for (j = 0; j < 4; j++) {
+			key[j] = data[i + (j < n ? j : 0)];
+			keylen[j] = len[i + (j < n ? j : 0)];
+		}
+
+		if (n == 1 || keylen[0] < 12 || keylen[1] < 12 ||
+		    keylen[2] < 12 || keylen[3] < 12) {
+			for (j = 0; j < n; j++) {
+				rgph_u32x3_jenkins2v_data(key[j], keylen[j],
+				    seed, &out[(i + j) * 3]);
+			}
+			continue;
+		}
+
+		jenkins2v_x4(key, keylen, seed, h);
+		for (j = 0; j < n; j++)
+			memcpy(&out[(i + j) * 3], h[j], sizeof(h[j]));
+	}
+}
+
+RGPH_FIXED_VECTOR(rgph_u32x3_jenkins2v_data, uint32_t)
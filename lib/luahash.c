@@ -27,20 +27,392 @@
  * SUCH DAMAGE.
  */
 
+/*
+ * Lua bindings of rgph_hash.h. Every family F has these functions:
+ *
+ *     F(str, seed)             -- hash of a string
+ *     F_u8(value, seed) ...    -- u8, u16, u32, u64, f32 and f64 values
+ *     F_u8a(packed, seed) ...  -- a packed array of values as one key
+ *     F_u32_batch(keys, seed)  -- hashes of many u32 keys
+ *     F_u64_batch(keys, seed)  -- hashes of many u64 keys
+ *
+ * Single hashes are returned as 32bit words, 64bit hashes as low and
+ * high words. Batch functions take an array of integers or a packed
+ * string of keys in native byte order and return a packed string of
+ * hashes, each hash is nwords 32bit words in native byte order.
+ */
+
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <lua.h>
 #include <lauxlib.h>
 
 #include "rgph_hash.h"
 
+typedef void (*data_hash_t)(const void *, size_t, uintptr_t, uint32_t *);
+typedef void (*value_hash_t)(uint64_t, double, int, uintptr_t, uint32_t *);
+typedef void (*array_hash_t)(const void *, size_t, int, uintptr_t, uint32_t *);
+typedef void (*batch32_hash_t)(const uint32_t *, size_t, uintptr_t, void *);
+typedef void (*batch64_hash_t)(const uint64_t *, size_t, uintptr_t, void *);
+
+struct hash_family {
+	const char *name;
+	int nwords;              /* Hash width in 32bit words. */
+	data_hash_t data;
+	value_hash_t value;
+	array_hash_t array;
+	batch32_hash_t batch32;  /* NULL if not implemented. */
+	batch64_hash_t batch64;
+};
+
+/* Types of values, see F_u8(), F_u8a() etc. */
+enum {
+	TYPE_U8, TYPE_U16, TYPE_U32, TYPE_U64, TYPE_F32, TYPE_F64, NTYPES
+};
+
+static const struct {
+	const char *name;
+	size_t width;
+} types[NTYPES] = {
+	{ "u8", 1 }, { "u16", 2 }, { "u32", 4 }, { "u64", 8 },
+	{ "f32", 4 }, { "f64", 8 }
+};
+
+#define STORE_U32(h, v) ((h)[0] = (v))
+#define STORE_U64(h, v) do {		\
+	const uint64_t v_ = (v);		\
+	(h)[0] = v_ & UINT32_MAX;		\
+	(h)[1] = v_ >> 32;			\
+} while (0)
+
+/* Wrappers of scalar hashes with a uniform signature. */
+#define SCALAR_HASH(f, prefix, STORE)					\
+static void								\
+f##_data(const void *key, size_t len, uintptr_t seed, uint32_t *h)	\
+{									\
+									\
+	STORE(h, prefix##_data(key, len, seed));			\
+}									\
+									\
+static void								\
+f##_value(uint64_t u, double d, int t, uintptr_t seed, uint32_t *h)	\
+{									\
+									\
+	switch (t) {							\
+	case TYPE_U8:  STORE(h, prefix##_u8(u, seed));  break;		\
+	case TYPE_U16: STORE(h, prefix##_u16(u, seed)); break;		\
+	case TYPE_U32: STORE(h, prefix##_u32(u, seed)); break;		\
+	case TYPE_U64: STORE(h, prefix##_u64(u, seed)); break;		\
+	case TYPE_F32: STORE(h, prefix##_f32(d, seed)); break;		\
+	case TYPE_F64: STORE(h, prefix##_f64(d, seed)); break;		\
+	}								\
+}									\
+									\
+static void								\
+f##_array(const void *a, size_t n, int t, uintptr_t seed, uint32_t *h)	\
+{									\
+									\
+	switch (t) {							\
+	case TYPE_U8:  STORE(h, prefix##_u8a(a, n, seed));  break;	\
+	case TYPE_U16: STORE(h, prefix##_u16a(a, n, seed)); break;	\
+	case TYPE_U32: STORE(h, prefix##_u32a(a, n, seed)); break;	\
+	case TYPE_U64: STORE(h, prefix##_u64a(a, n, seed)); break;	\
+	case TYPE_F32: STORE(h, prefix##_f32a(a, n, seed)); break;	\
+	case TYPE_F64: STORE(h, prefix##_f64a(a, n, seed)); break;	\
+	}								\
+}
+
+/* Wrappers of vector hashes with a uniform signature. */
+#define VECTOR_HASH(f, prefix)						\
+static void								\
+f##_value(uint64_t u, double d, int t, uintptr_t seed, uint32_t *h)	\
+{									\
+									\
+	switch (t) {							\
+	case TYPE_U8:  prefix##_u8(u, seed, h);  break;			\
+	case TYPE_U16: prefix##_u16(u, seed, h); break;			\
+	case TYPE_U32: prefix##_u32(u, seed, h); break;			\
+	case TYPE_U64: prefix##_u64(u, seed, h); break;			\
+	case TYPE_F32: prefix##_f32(d, seed, h); break;			\
+	case TYPE_F64: prefix##_f64(d, seed, h); break;			\
+	}								\
+}									\
+									\
+static void								\
+f##_array(const void *a, size_t n, int t, uintptr_t seed, uint32_t *h)	\
+{									\
+									\
+	switch (t) {							\
+	case TYPE_U8:  prefix##_u8a(a, n, seed, h);  break;		\
+	case TYPE_U16: prefix##_u16a(a, n, seed, h); break;		\
+	case TYPE_U32: prefix##_u32a(a, n, seed, h); break;		\
+	case TYPE_U64: prefix##_u64a(a, n, seed, h); break;		\
+	case TYPE_F32: prefix##_f32a(a, n, seed, h); break;		\
+	case TYPE_F64: prefix##_f64a(a, n, seed, h); break;		\
+	}								\
+}
+
+VECTOR_HASH(jenkins2v, rgph_u32x3_jenkins2v)
+VECTOR_HASH(murmur32v, rgph_u32x4_murmur32v)
+SCALAR_HASH(murmur32s, rgph_u32_murmur32s, STORE_U32)
+SCALAR_HASH(xxh32s, rgph_u32_xxh32s, STORE_U32)
+SCALAR_HASH(xxh64s, rgph_u64_xxh64s, STORE_U64)
+SCALAR_HASH(t1ha64s, rgph_u64_t1ha64s, STORE_U64)
+VECTOR_HASH(aes128v, rgph_u32x4_aes128v)
+VECTOR_HASH(xxh128v, rgph_u32x4_xxh128v)
+
+/* Wrappers of batch hashes with a uniform signature. */
+#define BATCH_HASH(f, prefix, T)					\
+static void								\
+f##_batch32(const uint32_t *keys, size_t n, uintptr_t seed, void *h)	\
+{									\
+									\
+	prefix##_u32_batch(keys, n, seed, (T *)h);			\
+}									\
+									\
+static void								\
+f##_batch64(const uint64_t *keys, size_t n, uintptr_t seed, void *h)	\
+{									\
+									\
+	prefix##_u64_batch(keys, n, seed, (T *)h);			\
+}
+
+BATCH_HASH(jenkins2v, rgph_u32x3_jenkins2v, uint32_t)
+BATCH_HASH(murmur32v, rgph_u32x4_murmur32v, uint32_t)
+BATCH_HASH(murmur32s, rgph_u32_murmur32s, uint32_t)
+BATCH_HASH(xxh32s, rgph_u32_xxh32s, uint32_t)
+BATCH_HASH(xxh64s, rgph_u64_xxh64s, uint64_t)
+BATCH_HASH(t1ha64s, rgph_u64_t1ha64s, uint64_t)
+
+static const struct hash_family families[] = {
+	{ "jenkins2v", 3, &rgph_u32x3_jenkins2v_data,
+	  &jenkins2v_value, &jenkins2v_array,
+	  &jenkins2v_batch32, &jenkins2v_batch64 },
+	{ "murmur32v", 4, &rgph_u32x4_murmur32v_data,
+	  &murmur32v_value, &murmur32v_array,
+	  &murmur32v_batch32, &murmur32v_batch64 },
+	{ "murmur32s", 1, &murmur32s_data,
+	  &murmur32s_value, &murmur32s_array,
+	  &murmur32s_batch32, &murmur32s_batch64 },
+	{ "xxh32s", 1, &xxh32s_data,
+	  &xxh32s_value, &xxh32s_array,
+	  &xxh32s_batch32, &xxh32s_batch64 },
+	{ "xxh64s", 2, &xxh64s_data,
+	  &xxh64s_value, &xxh64s_array,
+	  &xxh64s_batch32, &xxh64s_batch64 },
+	{ "t1ha64s", 2, &t1ha64s_data,
+	  &t1ha64s_value, &t1ha64s_array,
+	  &t1ha64s_batch32, &t1ha64s_batch64 },
+	{ "aes128v", 4, &rgph_u32x4_aes128v_data,
+	  &aes128v_value, &aes128v_array, NULL, NULL },
+	{ "xxh128v", 4, &rgph_u32x4_xxh128v_data,
+	  &xxh128v_value, &xxh128v_array, NULL, NULL },
+};
+
+static int
+push_hash(lua_State *L, const struct hash_family *f, const uint32_t *h)
+{
+	int i;
+
+	for (i = 0; i < f->nwords; i++)
+		lua_pushinteger(L, h[i]);
+
+	return f->nwords;
+}
+
+/* F(str, seed) */
+static int
+hash_data(lua_State *L)
+{
+	const struct hash_family *f = lua_touserdata(L, lua_upvalueindex(1));
+	uint32_t h[4];
+	lua_Integer seed;
+	const char *str;
+	size_t len;
+
+	str = luaL_checklstring(L, 1, &len);
+	seed = luaL_checkinteger(L, 2);
+
+	f->data(str, len, seed, h);
+	return push_hash(L, f, h);
+}
+
+/* F_u8(value, seed) etc. */
+static int
+hash_value(lua_State *L)
+{
+	const struct hash_family *f = lua_touserdata(L, lua_upvalueindex(1));
+	const int t = lua_tointeger(L, lua_upvalueindex(2));
+	uint32_t h[4];
+	lua_Integer seed;
+	lua_Number d;
+
+	d = luaL_checknumber(L, 1);
+	seed = luaL_checkinteger(L, 2);
+
+	f->value(lua_tointeger(L, 1), d, t, seed, h);
+	return push_hash(L, f, h);
+}
+
+/* F_u8a(packed, seed) etc. */
+static int
+hash_array(lua_State *L)
+{
+	const struct hash_family *f = lua_touserdata(L, lua_upvalueindex(1));
+	const int t = lua_tointeger(L, lua_upvalueindex(2));
+	const size_t width = types[t].width;
+	uint32_t h[4];
+	lua_Integer seed;
+	const char *str;
+	size_t len;
+
+	str = luaL_checklstring(L, 1, &len);
+	seed = luaL_checkinteger(L, 2);
+
+	if (len % width != 0)
+		return luaL_argerror(L, 1, "length is not a multiple of width");
+
+	f->array(str, len / width, t, seed, h);
+	return push_hash(L, f, h);
+}
+
+/*
+ * Keys of a batch from an array table or a packed string at arg,
+ * copied to userdata when converted from a table.
+ */
+static const void *
+check_batch_keys(lua_State *L, int arg, size_t width, size_t *nkeys)
+{
+	uint32_t *keys32;
+	uint64_t *keys64;
+	const char *str;
+	size_t i, len;
+
+	if (lua_type(L, arg) == LUA_TSTRING) {
+		str = lua_tolstring(L, arg, &len);
+		if (len % width != 0) {
+			luaL_argerror(L, arg,
+			    "length is not a multiple of width");
+		}
+		*nkeys = len / width;
+		return str;
+	}
+
+	luaL_checktype(L, arg, LUA_TTABLE);
+
+#if LUA_VERSION_NUM <= 501
+	*nkeys = lua_objlen(L, arg);
+#else
+	*nkeys = lua_rawlen(L, arg);
+#endif
+
+	keys32 = lua_newuserdata(L, width * (*nkeys + 1));
+	keys64 = (uint64_t *)keys32;
+
+	for (i = 0; i < *nkeys; i++) {
+		lua_rawgeti(L, arg, i + 1);
+		if (lua_type(L, -1) != LUA_TNUMBER)
+			luaL_argerror(L, arg, "integer key expected");
+		if (width == sizeof(uint32_t))
+			keys32[i] = lua_tointeger(L, -1);
+		else
+			keys64[i] = lua_tointeger(L, -1);
+		lua_pop(L, 1);
+	}
+
+	return keys32;
+}
+
+/* F_u32_batch(keys, seed) and F_u64_batch(keys, seed) */
+static int
+hash_batch(lua_State *L)
+{
+	const struct hash_family *f = lua_touserdata(L, lua_upvalueindex(1));
+	const int t = lua_tointeger(L, lua_upvalueindex(2));
+	const size_t width = types[t].width;
+	const size_t hsize = f->nwords * sizeof(uint32_t);
+	const void *keys;
+	uint32_t *out;
+	lua_Integer seed;
+	size_t i, nkeys;
+
+	keys = check_batch_keys(L, 1, width, &nkeys);
+	seed = luaL_checkinteger(L, 2);
+
+	out = lua_newuserdata(L, hsize * (nkeys + 1));
+
+	if (t == TYPE_U32 && f->batch32 != NULL) {
+		f->batch32(keys, nkeys, seed, out);
+	} else if (t == TYPE_U64 && f->batch64 != NULL) {
+		f->batch64(keys, nkeys, seed, out);
+	} else {
+		for (i = 0; i < nkeys; i++) {
+			f->value(t == TYPE_U32 ? ((const uint32_t *)keys)[i] :
+			    ((const uint64_t *)keys)[i], 0, t, seed,
+			    out + i * f->nwords);
+		}
+	}
+
+	lua_pushlstring(L, (const char *)out, hsize * nkeys);
+	return 1;
+}
+
+static void
+register_family(lua_State *L, const struct hash_family *f)
+{
+	char name[32];
+	int t;
+
+	lua_pushlightuserdata(L, (void *)f);
+	lua_pushcclosure(L, &hash_data, 1);
+	lua_setfield(L, -2, f->name);
+
+	for (t = 0; t < NTYPES; t++) {
+		snprintf(name, sizeof(name), "%s_%s", f->name, types[t].name);
+		lua_pushlightuserdata(L, (void *)f);
+		lua_pushinteger(L, t);
+		lua_pushcclosure(L, &hash_value, 2);
+		lua_setfield(L, -2, name);
+
+		snprintf(name, sizeof(name), "%s_%sa", f->name, types[t].name);
+		lua_pushlightuserdata(L, (void *)f);
+		lua_pushinteger(L, t);
+		lua_pushcclosure(L, &hash_array, 2);
+		lua_setfield(L, -2, name);
+
+		if (t != TYPE_U32 && t != TYPE_U64)
+			continue;
+
+		snprintf(name, sizeof(name), "%s_%s_batch",
+		    f->name, types[t].name);
+		lua_pushlightuserdata(L, (void *)f);
+		lua_pushinteger(L, t);
+		lua_pushcclosure(L, &hash_batch, 2);
+		lua_setfield(L, -2, name);
+	}
+}
+
+static int
+kernels_fn(lua_State *L)
+{
+
+	lua_pushstring(L, rgph_hash_kernels());
+	return 1;
+}
+
 static const luaL_Reg hash_fn[] = {
+	{ "kernels", kernels_fn },
 	{ NULL, NULL }
 };
 
 int
 luaopen_rgph_hash(lua_State *L)
 {
+	const size_t nfamilies = sizeof(families) / sizeof(families[0]);
+	size_t i;
 
 #if LUA_VERSION_NUM <= 501
 	luaL_register(L, "rgph.hash", hash_fn);
@@ -48,5 +420,8 @@ luaopen_rgph_hash(lua_State *L)
 	luaL_newlib(L, hash_fn);
 #endif
 
+	for (i = 0; i < nfamilies; i++)
+		register_family(L, &families[i]);
+
 	return 1;
 }
@@ -41,6 +41,7 @@
 
 #define GRAPH_MT  "rgph.graph"
 #define ASSIGN_MT "rgph.assign"
+#define IMAGE_MT  "rgph.image"
 
 /* rgph.edges("peel,key", iter) => EDGES_PEEL + (EDGES_KEY << EDGES_SHIFT). */
 #define EDGES_PEEL  1 /* 001, iter is optional */
@@ -56,6 +57,18 @@ struct build_iter_state {
 	int top;  /* Index of an iterator state on the stack. */
 };
 
+/* Array tables of keys, data and indices, see graph_build_array(). */
+struct array_iter_state {
+	struct rgph_entry ent;
+	lua_State *L;
+	int top;   /* Stack top before reading an entry. */
+	int keys;  /* Stack indices of the tables, data and index */
+	int data;  /* are zero if not passed.                     */
+	int index;
+	size_t n;
+	size_t i;
+};
+
 struct flag_str {
 	int flag;
 	int mask;
@@ -69,6 +82,8 @@ static const struct flag_str flag_strings[] = {
 	{ RGPH_HASH_XXH32S,    RGPH_HASH_MASK,   "xxh32s"    },
 	{ RGPH_HASH_XXH64S,    RGPH_HASH_MASK,   "xxh64s"    },
 	{ RGPH_HASH_T1HA64S,   RGPH_HASH_MASK,   "t1ha64s"   },
+	{ RGPH_HASH_AES128V,   RGPH_HASH_MASK,   "aes128v"   },
+	{ RGPH_HASH_XXH128V,   RGPH_HASH_MASK,   "xxh128v"   },
 	{ RGPH_RANK2,          RGPH_RANK_MASK,   "rank2"     },
 	{ RGPH_RANK3,          RGPH_RANK_MASK,   "rank3"     },
 	{ RGPH_ALGO_CHM,       RGPH_ALGO_MASK,   "chm"       },
@@ -77,6 +92,7 @@ static const struct flag_str flag_strings[] = {
 	{ RGPH_REDUCE_MUL,     RGPH_REDUCE_MASK, "mul"       },
 	{ RGPH_INDEX_COMPACT,  RGPH_INDEX_MASK,  "compact"   },
 	{ RGPH_INDEX_SPARSE,   RGPH_INDEX_MASK,  "sparse"    },
+	{ RGPH_INSTRUMENT,     RGPH_INSTRUMENT,  "instrument" },
 };
 
 
@@ -286,6 +302,19 @@ graph_vertices(lua_State *L)
 	return 1;
 }
 
+static int
+graph_keylen(lua_State *L)
+{
+	struct rgph_graph **pg;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	lua_pushinteger(L, rgph_keylen(*pg));
+	return 1;
+}
+
 static int
 graph_datalen_min(lua_State *L)
 {
@@ -428,6 +457,45 @@ graph_seed(lua_State *L)
 	return 1;
 }
 
+static int
+graph_peel_stats(lua_State *L)
+{
+	struct rgph_peel_stats stats;
+	struct rgph_graph **pg;
+	size_t i;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	if (rgph_get_peel_stats(*pg, &stats) != RGPH_SUCCESS) {
+		lua_pushnil(L);
+		lua_pushstring(L, "not built with instrument flag");
+		return 2;
+	}
+
+	lua_newtable(L);
+
+	/* Keys are degrees, starting from 0. */
+	lua_newtable(L);
+	for (i = 0; i < RGPH_DEGREE_BINS; i++) {
+		lua_pushinteger(L, stats.degree[i]);
+		lua_rawseti(L, -2, i);
+	}
+	lua_setfield(L, -2, "degree");
+
+	lua_pushinteger(L, stats.scan_peeled);
+	lua_setfield(L, -2, "scan_peeled");
+	lua_pushinteger(L, stats.cascade_peeled);
+	lua_setfield(L, -2, "cascade_peeled");
+	lua_pushinteger(L, stats.core_edges);
+	lua_setfield(L, -2, "core_edges");
+	lua_pushinteger(L, stats.core_verts);
+	lua_setfield(L, -2, "core_verts");
+
+	return 1;
+}
+
 static const struct rgph_entry *
 graph_build_iter(void *raw_state)
 {
@@ -454,6 +522,52 @@ graph_build_iter(void *raw_state)
 	return state->ent.key == NULL ? NULL : &state->ent;
 }
 
+static const struct rgph_entry *
+graph_build_array_iter(void *raw_state)
+{
+	struct array_iter_state *state = (struct array_iter_state *)raw_state;
+	lua_State *L = state->L;
+
+	lua_settop(L, state->top); /* GC strings from the previous entry. */
+
+	if (state->i == state->n)
+		return NULL;
+
+	state->i++;
+
+	lua_rawgeti(L, state->keys, state->i);
+	state->ent.key = lua_tolstring(L, -1, &state->ent.keylen);
+
+	state->ent.data = NULL;
+	state->ent.datalen = 0;
+	if (state->data != 0) {
+		lua_rawgeti(L, state->data, state->i);
+		state->ent.data = lua_tolstring(L, -1, &state->ent.datalen);
+	}
+
+	state->ent.has_index = 0;
+	state->ent.index = 0;
+	if (state->index != 0) {
+		lua_rawgeti(L, state->index, state->i);
+		state->ent.has_index = !lua_isnil(L, -1);
+		state->ent.index = state->ent.has_index ?
+		    lua_tointeger(L, -1) : 0;
+	}
+
+	return state->ent.key == NULL ? NULL : &state->ent;
+}
+
+static size_t
+array_length(lua_State *L, int index)
+{
+
+#if LUA_VERSION_NUM <= 501
+	return lua_objlen(L, index);
+#else
+	return lua_rawlen(L, index);
+#endif
+}
+
 static int
 count_keys_fn(lua_State *L)
 {
@@ -532,6 +646,48 @@ murmur32v_fn(lua_State *L)
 	return 4;
 }
 
+static int
+aes128v_fn(lua_State *L)
+{
+	uint32_t h[4];
+	lua_Integer seed;
+	const char *str;
+	size_t len;
+
+	str = luaL_checklstring(L, 1, &len);
+	seed = luaL_checkinteger(L, 2);
+
+	rgph_u32x4_aes128v_data(str, len, seed, h);
+
+	lua_pushinteger(L, h[0]);
+	lua_pushinteger(L, h[1]);
+	lua_pushinteger(L, h[2]);
+	lua_pushinteger(L, h[3]);
+
+	return 4;
+}
+
+static int
+xxh128v_fn(lua_State *L)
+{
+	uint32_t h[4];
+	lua_Integer seed;
+	const char *str;
+	size_t len;
+
+	str = luaL_checklstring(L, 1, &len);
+	seed = luaL_checkinteger(L, 2);
+
+	rgph_u32x4_xxh128v_data(str, len, seed, h);
+
+	lua_pushinteger(L, h[0]);
+	lua_pushinteger(L, h[1]);
+	lua_pushinteger(L, h[2]);
+	lua_pushinteger(L, h[3]);
+
+	return 4;
+}
+
 static int
 murmur32s_fn(lua_State *L)
 {
@@ -581,6 +737,30 @@ xxh64s_fn(lua_State *L)
 	return 2;
 }
 
+static int
+push_build_result(lua_State *L, int res)
+{
+
+	lua_pushboolean(L, res == RGPH_SUCCESS);
+	switch (res) {
+	case RGPH_AGAIN:
+	case RGPH_SUCCESS:
+		return 1;
+	case RGPH_INVAL:
+		lua_pushstring(L, "invalid value");
+		return 2;
+	case RGPH_NOKEY:
+		lua_pushstring(L, "iterator returned no key");
+		return 2;
+	case RGPH_RANGE:
+		lua_pushstring(L, "out of range");
+		return 2;
+	default:
+		lua_pushfstring(L, "unknown error %d", res);
+		return 2;
+	}
+}
+
 static int
 graph_build(lua_State *L)
 {
@@ -605,24 +785,192 @@ graph_build(lua_State *L)
 	res = rgph_build_graph(*pg, flags,
 	    NULL, seed, &graph_build_iter, &state);
 
-	lua_pushboolean(L, res == RGPH_SUCCESS);
-	switch (res) {
-	case RGPH_AGAIN:
-	case RGPH_SUCCESS:
+	return push_build_result(L, res);
+}
+
+/* g:build_array(flags, seed, keys [, data [, index]]) */
+static int
+graph_build_array(lua_State *L)
+{
+	struct array_iter_state state;
+	struct rgph_graph **pg;
+	lua_Integer seed;
+	int flags, res;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	flags = parse_flags(L, 2);
+	seed = luaL_checkinteger(L, 3);
+	luaL_checktype(L, 4, LUA_TTABLE);
+	if (!lua_isnoneornil(L, 5))
+		luaL_checktype(L, 5, LUA_TTABLE);
+	if (!lua_isnoneornil(L, 6))
+		luaL_checktype(L, 6, LUA_TTABLE);
+
+	state.L = L;
+	state.top = 6;
+	state.keys = 4;
+	state.data = lua_isnoneornil(L, 5) ? 0 : 5;
+	state.index = lua_isnoneornil(L, 6) ? 0 : 6;
+	state.n = array_length(L, 4);
+	state.i = 0;
+
+	lua_settop(L, state.top);
+	res = rgph_build_graph(*pg, flags,
+	    NULL, seed, &graph_build_array_iter, &state);
+
+	return push_build_result(L, res);
+}
+
+/* Like push_build_result() but nil means that a budget ran out. */
+static int
+push_step_result(lua_State *L, int res)
+{
+
+	if (res == RGPH_PARTIAL) {
+		lua_pushnil(L);
 		return 1;
-	case RGPH_INVAL:
-		lua_pushstring(L, "invalid value");
-		return 2;
-	case RGPH_NOKEY:
-		lua_pushstring(L, "iterator returned no key");
-		return 2;
-	case RGPH_RANGE:
-		lua_pushstring(L, "out of range");
-		return 2;
-	default:
-		lua_pushfstring(L, "unknown error %d", res);
-		return 2;
 	}
+
+	return push_build_result(L, res);
+}
+
+static int
+graph_build_begin(lua_State *L)
+{
+	struct rgph_graph **pg;
+	lua_Integer seed;
+	int flags, res;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	flags = parse_flags(L, 2);
+	seed = luaL_checkinteger(L, 3);
+
+	res = rgph_build_begin(*pg, flags, NULL, seed);
+	return push_build_result(L, res);
+}
+
+/* g:build_step(maxkeys, keys [, data [, index]]) resumes at a position. */
+static int
+graph_build_step(lua_State *L)
+{
+	struct array_iter_state state;
+	struct rgph_graph **pg;
+	lua_Integer maxkeys;
+	int res;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	maxkeys = luaL_checkinteger(L, 2);
+	if (maxkeys < 0)
+		return luaL_argerror(L, 2, "out of range");
+	luaL_checktype(L, 3, LUA_TTABLE);
+	if (!lua_isnoneornil(L, 4))
+		luaL_checktype(L, 4, LUA_TTABLE);
+	if (!lua_isnoneornil(L, 5))
+		luaL_checktype(L, 5, LUA_TTABLE);
+
+	state.L = L;
+	state.top = 5;
+	state.keys = 3;
+	state.data = lua_isnoneornil(L, 4) ? 0 : 4;
+	state.index = lua_isnoneornil(L, 5) ? 0 : 5;
+	state.n = array_length(L, 3);
+	state.i = rgph_build_position(*pg);
+	if (state.i > state.n)
+		state.i = state.n;
+
+	lua_settop(L, state.top);
+	res = rgph_build_step(*pg, &graph_build_array_iter, &state, maxkeys, 0);
+
+	return push_step_result(L, res);
+}
+
+static int
+graph_build_finish(lua_State *L)
+{
+	struct rgph_graph **pg;
+	lua_Integer maxverts;
+	int res;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	maxverts = luaL_optinteger(L, 2, 0);
+	if (maxverts < 0)
+		return luaL_argerror(L, 2, "out of range");
+
+	res = rgph_build_finish(*pg, maxverts, 0);
+	return push_step_result(L, res);
+}
+
+/*
+ * g:build_u32(flags, seed, keys) and g:build_u64(flags, seed, keys)
+ * hash integers in the keys array like rgph_build_graph_u32() and
+ * rgph_build_graph_u64(), a position of a key is its index.
+ */
+static int
+build_ints(lua_State *L, size_t width)
+{
+	struct rgph_graph **pg;
+	uint32_t *keys32;
+	uint64_t *keys64;
+	lua_Integer seed;
+	size_t i, nkeys;
+	int flags, res;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	flags = parse_flags(L, 2);
+	seed = luaL_checkinteger(L, 3);
+	luaL_checktype(L, 4, LUA_TTABLE);
+
+	nkeys = array_length(L, 4);
+
+	/* Garbage collected if lua_rawgeti() or a check below throws. */
+	keys32 = (uint32_t *)lua_newuserdata(L, width * (nkeys + 1));
+	keys64 = (uint64_t *)keys32;
+
+	for (i = 0; i < nkeys; i++) {
+		lua_rawgeti(L, 4, i + 1);
+		if (lua_type(L, -1) != LUA_TNUMBER)
+			return luaL_argerror(L, 4, "integer key expected");
+		if (width == sizeof(uint32_t))
+			keys32[i] = lua_tointeger(L, -1);
+		else
+			keys64[i] = lua_tointeger(L, -1);
+		lua_pop(L, 1);
+	}
+
+	res = (width == sizeof(uint32_t))
+	    ? rgph_build_graph_u32(*pg, flags, NULL, seed, keys32, nkeys)
+	    : rgph_build_graph_u64(*pg, flags, NULL, seed, keys64, nkeys);
+
+	return push_build_result(L, res);
+}
+
+static int
+graph_build_u32(lua_State *L)
+{
+
+	return build_ints(L, sizeof(uint32_t));
+}
+
+static int
+graph_build_u64(lua_State *L)
+{
+
+	return build_ints(L, sizeof(uint64_t));
 }
 
 static int
@@ -729,6 +1077,15 @@ assign_get(lua_State *L)
 	if (*pg == NULL)
 		return luaL_argerror(L, 1, "dead object");
 
+	/* a["5"] is still assignment 5. */
+	if (lua_type(L, 2) == LUA_TSTRING && !lua_isnumber(L, 2)) {
+		/* a:lookup(key) */
+		luaL_getmetafield(L, 1, "methods");
+		lua_pushvalue(L, 2);
+		lua_rawget(L, -2);
+		return 1;
+	}
+
 	res = rgph_copy_assignment(*pg, luaL_checkinteger(L, 2), &val);
 
 	switch (res) {
@@ -744,6 +1101,300 @@ assign_get(lua_State *L)
 	}
 }
 
+/* Graph or assignment userdata at arg, both point to a graph. */
+static struct rgph_graph *
+check_lookup_graph(lua_State *L, int arg)
+{
+	struct rgph_graph **pg;
+	int found = 0;
+
+	pg = (struct rgph_graph **)lua_touserdata(L, arg);
+	if (pg != NULL && lua_getmetatable(L, arg)) {
+		luaL_getmetatable(L, GRAPH_MT);
+		luaL_getmetatable(L, ASSIGN_MT);
+		found = lua_rawequal(L, -3, -2) || lua_rawequal(L, -3, -1);
+		lua_pop(L, 3);
+	}
+
+	if (!found)
+		luaL_argerror(L, arg, GRAPH_MT " or " ASSIGN_MT " expected");
+	if (*pg == NULL)
+		luaL_argerror(L, arg, "dead object");
+
+	return *pg;
+}
+
+static int
+push_lookup_result(lua_State *L, int res, uint64_t val)
+{
+
+	switch (res) {
+	case RGPH_SUCCESS:
+		lua_pushinteger(L, val);
+		return 1;
+	case RGPH_INVAL:
+		return luaL_argerror(L, 1, "unassigned");
+	default:
+		return luaL_error(L, "unknown error %d", res);
+	}
+}
+
+static int
+graph_lookup(lua_State *L)
+{
+	struct rgph_graph *g;
+	const char *key;
+	size_t keylen;
+	uint64_t val;
+	int res;
+
+	g = check_lookup_graph(L, 1);
+	key = luaL_checklstring(L, 2, &keylen);
+
+	res = rgph_lookup(g, key, keylen, &val);
+	return push_lookup_result(L, res, val);
+}
+
+static int
+graph_lookup_u32(lua_State *L)
+{
+	struct rgph_graph *g;
+	uint64_t val;
+	int res;
+
+	g = check_lookup_graph(L, 1);
+	res = rgph_lookup_u32(g, luaL_checkinteger(L, 2), &val);
+	return push_lookup_result(L, res, val);
+}
+
+static int
+graph_lookup_u64(lua_State *L)
+{
+	struct rgph_graph *g;
+	uint64_t val;
+	int res;
+
+	g = check_lookup_graph(L, 1);
+	res = rgph_lookup_u64(g, luaL_checkinteger(L, 2), &val);
+	return push_lookup_result(L, res, val);
+}
+
+#define LOOKUP_BATCH 64
+
+static int
+graph_lookup_many(lua_State *L)
+{
+	const void *keys[LOOKUP_BATCH];
+	size_t keylens[LOOKUP_BATCH];
+	uint64_t vals[LOOKUP_BATCH];
+	struct rgph_graph *g;
+	size_t i, j, n, nkeys;
+	int res, top;
+
+	g = check_lookup_graph(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	luaL_checkstack(L, LOOKUP_BATCH, "too many keys");
+
+	nkeys = array_length(L, 2);
+	lua_createtable(L, nkeys, 0);
+	top = lua_gettop(L);
+
+	for (i = 0; i < nkeys; i += n) {
+		n = nkeys - i < LOOKUP_BATCH ? nkeys - i : LOOKUP_BATCH;
+
+		/* Keep keys on the stack while they're hashed. */
+		for (j = 0; j < n; j++) {
+			lua_rawgeti(L, 2, i + j + 1);
+			keys[j] = lua_tolstring(L, -1, &keylens[j]);
+			if (keys[j] == NULL)
+				return luaL_argerror(L, 2, "key must be string");
+		}
+
+		res = rgph_lookup_batch(g, keys, keylens, n, vals);
+
+		switch (res) {
+		case RGPH_SUCCESS:
+			break;
+		case RGPH_INVAL:
+			return luaL_argerror(L, 1, "unassigned");
+		default:
+			return luaL_error(L, "unknown error %d", res);
+		}
+
+		lua_settop(L, top);
+		for (j = 0; j < n; j++) {
+			lua_pushinteger(L, vals[j]);
+			lua_rawseti(L, top, i + j + 1);
+		}
+	}
+
+	return 1;
+}
+
+static int
+graph_save_image(lua_State *L)
+{
+	struct rgph_graph **pg;
+	const char *path;
+	int res;
+
+	pg = (struct rgph_graph **)luaL_checkudata(L, 1, GRAPH_MT);
+	if (*pg == NULL)
+		return luaL_argerror(L, 1, "dead object");
+
+	path = luaL_checkstring(L, 2);
+	res = rgph_save_image(*pg, path);
+
+	lua_pushboolean(L, res == RGPH_SUCCESS);
+	switch (res) {
+	case RGPH_SUCCESS:
+		return 1;
+	case RGPH_INVAL:
+		lua_pushstring(L, "invalid value");
+		return 2;
+	case RGPH_IO:
+		lua_pushfstring(L, "%s: %s", path, strerror(errno));
+		return 2;
+	default:
+		lua_pushfstring(L, "unknown error %d", res);
+		return 2;
+	}
+}
+
+static int
+open_image_fn(lua_State *L)
+{
+	struct rgph_image **pimg;
+	const char *path;
+
+	path = luaL_checkstring(L, 1);
+
+	pimg = (struct rgph_image **)lua_newuserdata(L, sizeof(pimg));
+	*pimg = NULL;
+	luaL_getmetatable(L, IMAGE_MT);
+	lua_setmetatable(L, -2);
+
+	*pimg = rgph_open_image(path);
+	if (*pimg == NULL) {
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", path, strerror(errno));
+		return 2;
+	}
+
+	return 1;
+}
+
+static struct rgph_image *
+check_image(lua_State *L, int arg)
+{
+	struct rgph_image **pimg;
+
+	pimg = (struct rgph_image **)luaL_checkudata(L, arg, IMAGE_MT);
+	if (*pimg == NULL)
+		luaL_argerror(L, arg, "dead object");
+
+	return *pimg;
+}
+
+static int
+image_gc(lua_State *L)
+{
+	struct rgph_image **pimg;
+
+	pimg = (struct rgph_image **)luaL_checkudata(L, 1, IMAGE_MT);
+	if (*pimg != NULL)
+		rgph_close_image(*pimg);
+	*pimg = NULL;
+	return 0;
+}
+
+static int
+image_entries(lua_State *L)
+{
+
+	lua_pushinteger(L, rgph_image_entries(check_image(L, 1)));
+	return 1;
+}
+
+static int
+image_lookup(lua_State *L)
+{
+	struct rgph_image *img;
+	const char *key;
+	size_t keylen;
+	uint64_t val;
+	int res;
+
+	img = check_image(L, 1);
+	key = luaL_checklstring(L, 2, &keylen);
+
+	res = rgph_image_lookup(img, key, keylen, &val);
+	return push_lookup_result(L, res, val);
+}
+
+/* Integer keys are hashed in memory like in rgph_lookup_u32(). */
+static int
+image_lookup_u32(lua_State *L)
+{
+	struct rgph_image *img;
+	uint32_t key;
+	uint64_t val;
+	int res;
+
+	img = check_image(L, 1);
+	key = luaL_checkinteger(L, 2);
+
+	res = rgph_image_lookup(img, &key, sizeof(key), &val);
+	return push_lookup_result(L, res, val);
+}
+
+static int
+image_lookup_u64(lua_State *L)
+{
+	struct rgph_image *img;
+	uint64_t key, val;
+	int res;
+
+	img = check_image(L, 1);
+	key = luaL_checkinteger(L, 2);
+
+	res = rgph_image_lookup(img, &key, sizeof(key), &val);
+	return push_lookup_result(L, res, val);
+}
+
+static int
+image_lookup_many(lua_State *L)
+{
+	struct rgph_image *img;
+	const char *key;
+	size_t i, nkeys, keylen;
+	uint64_t val;
+	int res;
+
+	img = check_image(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	nkeys = array_length(L, 2);
+	lua_createtable(L, nkeys, 0);
+
+	for (i = 1; i <= nkeys; i++) {
+		lua_rawgeti(L, 2, i);
+		key = lua_tolstring(L, -1, &keylen);
+		if (key == NULL)
+			return luaL_argerror(L, 2, "key must be string");
+
+		res = rgph_image_lookup(img, key, keylen, &val);
+		if (res != RGPH_SUCCESS)
+			return luaL_error(L, "unknown error %d", res);
+
+		lua_pop(L, 1);
+		lua_pushinteger(L, val);
+		lua_rawseti(L, -2, i);
+	}
+
+	return 1;
+}
+
 /* "peel,key" => EDGES_PEEL + (EDGES_KEY<<EDGES_SHIFT). */
 static int
 parse_edges_arg(lua_State *L, int n)
@@ -942,6 +1593,7 @@ graph_edge(lua_State *L)
 
 static const luaL_Reg rgph_fn[] = {
 	{ "new_graph", new_graph_fn },
+	{ "open_image", open_image_fn },
 	{ "count_keys", count_keys_fn },
 	{ "fastdiv_prepare", fastdiv_prepare_fn },
 	{ "jenkins2v", jenkins2v_fn },
@@ -949,6 +1601,8 @@ static const luaL_Reg rgph_fn[] = {
 	{ "murmur32s", murmur32s_fn },
 	{ "xxh32s", xxh32s_fn },
 	{ "xxh64s", xxh64s_fn },
+	{ "aes128v", aes128v_fn },
+	{ "xxh128v", xxh128v_fn },
 	{ NULL, NULL }
 };
 
@@ -960,6 +1614,7 @@ static const luaL_Reg graph_fn[] = {
 	{ "hash_bits", graph_hash_bits },
 	{ "entries", graph_entries },
 	{ "vertices", graph_vertices },
+	{ "keylen", graph_keylen },
 	{ "datalen_min", graph_datalen_min },
 	{ "datalen_max", graph_datalen_max },
 	{ "index_min", graph_index_min },
@@ -968,11 +1623,23 @@ static const luaL_Reg graph_fn[] = {
 	{ "flags", graph_flags },
 	{ "reduction", graph_reduction },
 	{ "build", graph_build },
+	{ "build_array", graph_build_array },
+	{ "build_u32", graph_build_u32 },
+	{ "build_u64", graph_build_u64 },
+	{ "build_begin", graph_build_begin },
+	{ "build_step", graph_build_step },
+	{ "build_finish", graph_build_finish },
 	{ "find_duplicates", graph_find_duplicates },
 	{ "assign", graph_assign },
 	{ "seed", graph_seed },
+	{ "peel_stats", graph_peel_stats },
 	{ "edge", graph_edge },
 	{ "edges", graph_edges },
+	{ "lookup", graph_lookup },
+	{ "lookup_many", graph_lookup_many },
+	{ "lookup_u32", graph_lookup_u32 },
+	{ "lookup_u64", graph_lookup_u64 },
+	{ "save_image", graph_save_image },
 	{ NULL, NULL }
 };
 
@@ -986,6 +1653,28 @@ static const luaL_Reg assign_index[] = {
 	{ NULL, NULL }
 };
 
+static const luaL_Reg assign_fn[] = {
+	{ "lookup", graph_lookup },
+	{ "lookup_many", graph_lookup_many },
+	{ "lookup_u32", graph_lookup_u32 },
+	{ "lookup_u64", graph_lookup_u64 },
+	{ NULL, NULL }
+};
+
+static const luaL_Reg image_mt[] = {
+	{ "__gc", image_gc },
+	{ NULL, NULL }
+};
+
+static const luaL_Reg image_fn[] = {
+	{ "entries", image_entries },
+	{ "lookup", image_lookup },
+	{ "lookup_many", image_lookup_many },
+	{ "lookup_u32", image_lookup_u32 },
+	{ "lookup_u64", image_lookup_u64 },
+	{ NULL, NULL }
+};
+
 static void
 register_udata(lua_State *L, int arg, const char *tname,
     const luaL_Reg *metafunctions, const luaL_Reg *methods)
@@ -1143,6 +1832,107 @@ push_xxh64s_constants(lua_State *L)
 	lua_setfield(L, -2, "prime5");
 }
 
+static void
+set_u64_field(lua_State *L, uint64_t value, const char *name)
+{
+
+	lua_createtable(L, 2, 0);
+	lua_pushinteger(L, value & 0xffffffffu);
+	lua_rawseti(L, -2, 1);
+	lua_pushinteger(L, value >> 32);
+	lua_rawseti(L, -2, 2);
+	lua_setfield(L, -2, name);
+}
+
+static void
+set_block_field(lua_State *L, const uint32_t *w, const char *name)
+{
+	int i;
+
+	lua_createtable(L, 4, 0);
+	for (i = 0; i < 4; i++) {
+		lua_pushinteger(L, w[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, name);
+}
+
+static void
+push_t1ha64s_constants(lua_State *L)
+{
+
+	lua_newtable(L);
+	set_u64_field(L, RGPH_T1HA64S_PRIME0, "prime0");
+	set_u64_field(L, RGPH_T1HA64S_PRIME1, "prime1");
+	set_u64_field(L, RGPH_T1HA64S_PRIME2, "prime2");
+	set_u64_field(L, RGPH_T1HA64S_PRIME3, "prime3");
+	set_u64_field(L, RGPH_T1HA64S_PRIME4, "prime4");
+	set_u64_field(L, RGPH_T1HA64S_PRIME5, "prime5");
+	set_u64_field(L, RGPH_T1HA64S_PRIME6, "prime6");
+	lua_pushinteger(L, RGPH_T1HA64S_ROT0);
+	lua_setfield(L, -2, "rot0");
+	lua_pushinteger(L, RGPH_T1HA64S_ROT1);
+	lua_setfield(L, -2, "rot1");
+	lua_pushinteger(L, RGPH_T1HA64S_ROT2);
+	lua_setfield(L, -2, "rot2");
+}
+
+static void
+push_aes128v_constants(lua_State *L)
+{
+	const uint32_t k0[4] = { RGPH_AES128V_K0 };
+	const uint32_t k1[4] = { RGPH_AES128V_K1 };
+	const uint32_t k2[4] = { RGPH_AES128V_K2 };
+	const uint32_t k3[4] = { RGPH_AES128V_K3 };
+
+	lua_newtable(L);
+	set_block_field(L, k0, "k0");
+	set_block_field(L, k1, "k1");
+	set_block_field(L, k2, "k2");
+	set_block_field(L, k3, "k3");
+}
+
+static void
+push_xxh128v_constants(lua_State *L)
+{
+
+	lua_newtable(L);
+	lua_pushinteger(L, RGPH_XXH128V_PRIME32_1);
+	lua_setfield(L, -2, "prime32_1");
+	lua_pushinteger(L, RGPH_XXH128V_PRIME32_2);
+	lua_setfield(L, -2, "prime32_2");
+	lua_pushinteger(L, RGPH_XXH128V_PRIME32_3);
+	lua_setfield(L, -2, "prime32_3");
+	set_u64_field(L, RGPH_XXH128V_PRIME64_1, "prime64_1");
+	set_u64_field(L, RGPH_XXH128V_PRIME64_2, "prime64_2");
+	set_u64_field(L, RGPH_XXH128V_PRIME64_3, "prime64_3");
+	set_u64_field(L, RGPH_XXH128V_PRIME64_4, "prime64_4");
+	set_u64_field(L, RGPH_XXH128V_PRIME64_5, "prime64_5");
+	set_u64_field(L, RGPH_XXH128V_PRIME_MX1, "prime_mx1");
+	set_u64_field(L, RGPH_XXH128V_PRIME_MX2, "prime_mx2");
+}
+
+static void
+push_derive_constants(lua_State *L)
+{
+
+	lua_newtable(L);
+
+	lua_createtable(L, 2, 0);
+	lua_pushinteger(L, RGPH_DERIVE_ADD & 0xffffffffu);
+	lua_rawseti(L, -2, 1);
+	lua_pushinteger(L, RGPH_DERIVE_ADD >> 32);
+	lua_rawseti(L, -2, 2);
+	lua_setfield(L, -2, "add");
+
+	lua_createtable(L, 2, 0);
+	lua_pushinteger(L, RGPH_DERIVE_MUL & 0xffffffffu);
+	lua_rawseti(L, -2, 1);
+	lua_pushinteger(L, RGPH_DERIVE_MUL >> 32);
+	lua_rawseti(L, -2, 2);
+	lua_setfield(L, -2, "mul");
+}
+
 int
 luaopen_rgph(lua_State *L)
 {
@@ -1161,6 +1951,29 @@ luaopen_rgph(lua_State *L)
 #else
 	luaL_setfuncs(L, assign_index, 0);
 #endif
+	lua_newtable(L); /* Methods, see assign_get(). */
+#if LUA_VERSION_NUM <= 501
+	luaL_register(L, NULL, assign_fn);
+#else
+	luaL_setfuncs(L, assign_fn, 0);
+#endif
+	lua_setfield(L, -2, "methods");
+	lua_pop(L, 1);
+
+	/* Not registered as rgph functions, they'd clash with graph's. */
+	luaL_newmetatable(L, IMAGE_MT);
+#if LUA_VERSION_NUM <= 501
+	luaL_register(L, NULL, image_mt);
+#else
+	luaL_setfuncs(L, image_mt, 0);
+#endif
+	lua_newtable(L);
+#if LUA_VERSION_NUM <= 501
+	luaL_register(L, NULL, image_fn);
+#else
+	luaL_setfuncs(L, image_fn, 0);
+#endif
+	lua_setfield(L, -2, "__index");
 	lua_pop(L, 1);
 
 	lua_newtable(L); /* rgph.const */
@@ -1174,6 +1987,14 @@ luaopen_rgph(lua_State *L)
 	lua_setfield(L, -2, "xxh32s");
 	push_xxh64s_constants(L);
 	lua_setfield(L, -2, "xxh64s");
+	push_t1ha64s_constants(L);
+	lua_setfield(L, -2, "t1ha64s");
+	push_aes128v_constants(L);
+	lua_setfield(L, -2, "aes128v");
+	push_xxh128v_constants(L);
+	lua_setfield(L, -2, "xxh128v");
+	push_derive_constants(L);
+	lua_setfield(L, -2, "derive");
 
 	lua_setfield(L, -2, "const");
 
@@ -32,12 +32,13 @@
 
 #include "rgph_hash_impl.h"
 #include "rgph_hash.h"
+#include "rgph_cpu.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
 
-uint32_t
+inline uint32_t
 rgph_u32_murmur32s_data(const void *data, size_t len, uintptr_t seed)
 {
 	const uint8_t *key = data;
@@ -78,3 +79,5 @@ rgph_u32_murmur32s_data(const void *data, size_t len, uintptr_t seed)
 
 	return h[0];
 }
+
+RGPH_FIXED_SCALAR(rgph_u32_murmur32s_data, uint32_t)
@@ -32,12 +32,13 @@
 
 #include "rgph_hash_impl.h"
 #include "rgph_hash.h"
+#include "rgph_cpu.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
 
-void
+inline void
 rgph_u32x4_murmur32v_data(const void *data,
     size_t len, uintptr_t seed, uint32_t * restrict h)
 {
@@ -100,3 +101,5 @@ rgph_u32x4_murmur32v_data(const void *data,
 	         rgph_murmur32_finalise(len, h);
 	}
 }
+
+RGPH_FIXED_VECTOR(rgph_u32x4_murmur32v_data, uint32_t)
@@ -30,8 +30,12 @@
 #define RGPH_H_INCLUDED
 
 #include <rgph_defs.h>
+#include <rgph_dynamic.h>
 #include <rgph_fastdiv.h>
 #include <rgph_graph.h>
+#include <rgph_handle.h>
 #include <rgph_hash.h>
+#include <rgph_image.h>
+#include <rgph_lookup.h>
 
 #endif /* !RGPH_H_INCLUDED */
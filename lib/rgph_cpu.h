@@ -0,0 +1,205 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef FILE_RGPH_CPU_H_INCLUDED
+#define FILE_RGPH_CPU_H_INCLUDED
+
+/*
+ * Hash kernels selected at runtime. Not a public interface.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* x86 kernels need target attributes and __builtin_cpu_supports(). */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RGPH_X86_KERNELS
+#endif
+
+/* Platforms where unaligned reads are safe and fast. */
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+#define RGPH_UNALIGNED_KERNELS
+#endif
+
+/*
+ * Append _<isa> to a name, e.g. rgph_batch_kernels_avx2.
+ */
+#define RGPH_ISA_NAME(name, isa) RGPH_ISA_NAME_(name, isa)
+#define RGPH_ISA_NAME_(name, isa) name##_##isa
+
+/*
+ * Define name_fixedN copies of a generic hash function for common key
+ * lengths N. The function must be declared inline in the same file.
+ * Copies ignore their len argument and hash N bytes. Unlike
+ * RGPH_ISA_NAME(), name is expanded first to pick up renamed kernels.
+ */
+#if defined(__GNUC__)
+#define RGPH_FLATTEN __attribute__((flatten))
+#else
+#define RGPH_FLATTEN
+#endif
+
+#define RGPH_FIXED_LENGTHS(def, name, type) \
+	def(name, type, 4)  \
+	def(name, type, 8)  \
+	def(name, type, 12) \
+	def(name, type, 16) \
+	def(name, type, 20) \
+	def(name, type, 32)
+
+#define RGPH_FIXED_VECTOR_(name, type, n) \
+RGPH_FLATTEN void \
+name##_fixed##n(const void *data, size_t len, uintptr_t seed, type *h) \
+{ \
+	(void)len; \
+	name(data, n, seed, h); \
+}
+
+#define RGPH_FIXED_SCALAR_(name, type, n) \
+RGPH_FLATTEN type \
+name##_fixed##n(const void *data, size_t len, uintptr_t seed) \
+{ \
+	(void)len; \
+	return name(data, n, seed); \
+}
+
+#define RGPH_FIXED_VECTOR(name, type) \
+	RGPH_FIXED_LENGTHS(RGPH_FIXED_VECTOR_, name, type)
+#define RGPH_FIXED_SCALAR(name, type) \
+	RGPH_FIXED_LENGTHS(RGPH_FIXED_SCALAR_, name, type)
+
+/* Generic hashes for any data. */
+struct rgph_data_kernels {
+	void (*jenkins2v)(const void *, size_t, uintptr_t, uint32_t *);
+	void (*murmur32v)(const void *, size_t, uintptr_t, uint32_t *);
+	uint32_t (*murmur32s)(const void *, size_t, uintptr_t);
+	uint32_t (*xxh32s)(const void *, size_t, uintptr_t);
+	uint64_t (*xxh64s)(const void *, size_t, uintptr_t);
+	uint64_t (*t1ha64s)(const void *, size_t, uintptr_t);
+	void (*aes128v)(const void *, size_t, uintptr_t, uint32_t *);
+	void (*xxh128v)(const void *, size_t, uintptr_t, uint32_t *);
+	void (*jenkins2v_batch)(const void * const *, const size_t *,
+	    size_t, uintptr_t, uint32_t *);
+};
+
+/* Hashes for batches of fixed width keys. */
+struct rgph_batch_kernels {
+	void (*jenkins2v_u32)(const uint32_t *, size_t, uintptr_t, uint32_t *);
+	void (*jenkins2v_u64)(const uint64_t *, size_t, uintptr_t, uint32_t *);
+	void (*murmur32v_u32)(const uint32_t *, size_t, uintptr_t, uint32_t *);
+	void (*murmur32v_u64)(const uint64_t *, size_t, uintptr_t, uint32_t *);
+	void (*murmur32s_u32)(const uint32_t *, size_t, uintptr_t, uint32_t *);
+	void (*murmur32s_u64)(const uint64_t *, size_t, uintptr_t, uint32_t *);
+	void (*xxh32s_u32)(const uint32_t *, size_t, uintptr_t, uint32_t *);
+	void (*xxh32s_u64)(const uint64_t *, size_t, uintptr_t, uint32_t *);
+	void (*xxh64s_u32)(const uint32_t *, size_t, uintptr_t, uint64_t *);
+	void (*xxh64s_u64)(const uint64_t *, size_t, uintptr_t, uint64_t *);
+	void (*t1ha64s_u32)(const uint32_t *, size_t, uintptr_t, uint64_t *);
+	void (*t1ha64s_u64)(const uint64_t *, size_t, uintptr_t, uint64_t *);
+};
+
+/*
+ * Data kernels specialised for key lengths 4, 8, 12, 16, 20 and 32.
+ * Their jenkins2v_batch members are NULL.
+ */
+#define RGPH_FIXED_NLENS 6
+
+struct rgph_kernels {
+	const char *name;
+	const struct rgph_data_kernels *data;
+	const struct rgph_batch_kernels *batch;
+	const struct rgph_data_kernels *fixed; /* [RGPH_FIXED_NLENS] */
+};
+
+/*
+ * Kernels for the current CPU. The RGPH_KERNELS environment variable
+ * overrides the choice if the named kernels are supported.
+ */
+const struct rgph_kernels *rgph_kernels(void);
+
+/*
+ * Kernels that hash only keylen bytes or NULL if there are
+ * no kernels specialised for keylen.
+ */
+const struct rgph_data_kernels *rgph_fixed_kernels(
+    const struct rgph_kernels *, size_t keylen);
+
+/* Defined in batch.c and its copies compiled for other targets. */
+extern const struct rgph_batch_kernels rgph_batch_kernels_generic;
+extern const struct rgph_batch_kernels rgph_batch_kernels_sse42;
+extern const struct rgph_batch_kernels rgph_batch_kernels_avx2;
+extern const struct rgph_batch_kernels rgph_batch_kernels_avx512;
+
+/* Defined in unaligned.c. */
+extern const struct rgph_data_kernels rgph_data_kernels_unaligned;
+extern const struct rgph_data_kernels rgph_data_kernels_aesni;
+extern const struct rgph_data_kernels rgph_fixed_kernels_unaligned[];
+extern const struct rgph_data_kernels rgph_fixed_kernels_aesni[];
+
+/* Defined in aes128v.c and aes128v-aesni.c. */
+void rgph_u32x4_aes128v_data_generic(const void *, size_t, uintptr_t,
+    uint32_t *);
+void rgph_u32x4_aes128v_data_aesni(const void *, size_t, uintptr_t,
+    uint32_t *);
+
+/* Defined by RGPH_FIXED_VECTOR() and RGPH_FIXED_SCALAR(). */
+#define RGPH_FIXED_PROTO_(name, type, n) \
+	type name##_fixed##n(const void *, size_t, uintptr_t);
+#define RGPH_FIXED_PROTOS(name, type) \
+	RGPH_FIXED_LENGTHS(RGPH_FIXED_PROTO_, name, type)
+#define RGPH_FIXED_VPROTO_(name, type, n) \
+	void name##_fixed##n(const void *, size_t, uintptr_t, type *);
+#define RGPH_FIXED_VPROTOS(name, type) \
+	RGPH_FIXED_LENGTHS(RGPH_FIXED_VPROTO_, name, type)
+
+RGPH_FIXED_VPROTOS(rgph_u32x3_jenkins2v_data, uint32_t)
+RGPH_FIXED_VPROTOS(rgph_u32x4_murmur32v_data, uint32_t)
+RGPH_FIXED_PROTOS(rgph_u32_murmur32s_data, uint32_t)
+RGPH_FIXED_PROTOS(rgph_u32_xxh32s_data, uint32_t)
+RGPH_FIXED_PROTOS(rgph_u64_xxh64s_data, uint64_t)
+RGPH_FIXED_PROTOS(rgph_u64_t1ha64s_data, uint64_t)
+RGPH_FIXED_VPROTOS(rgph_u32x4_aes128v_data_generic, uint32_t)
+RGPH_FIXED_VPROTOS(rgph_u32x4_aes128v_data_aesni, uint32_t)
+RGPH_FIXED_VPROTOS(rgph_u32x4_xxh128v_data, uint32_t)
+
+RGPH_FIXED_VPROTOS(rgph_u32x3_jenkins2v_data_unaligned, uint32_t)
+RGPH_FIXED_VPROTOS(rgph_u32x4_murmur32v_data_unaligned, uint32_t)
+RGPH_FIXED_PROTOS(rgph_u32_murmur32s_data_unaligned, uint32_t)
+RGPH_FIXED_PROTOS(rgph_u32_xxh32s_data_unaligned, uint32_t)
+RGPH_FIXED_PROTOS(rgph_u64_xxh64s_data_unaligned, uint64_t)
+RGPH_FIXED_PROTOS(rgph_u64_t1ha64s_data_unaligned, uint64_t)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !FILE_RGPH_CPU_H_INCLUDED */
@@ -36,6 +36,8 @@
 #define RGPH_NOMEM  -3 /* ENOMEM. */
 #define RGPH_AGAIN  -4 /* Graph has a cycle or rgph_find_duplicates() failed. */
 #define RGPH_NOKEY  -5 /* Iterator returned no key. */
+#define RGPH_IO     -6 /* System call failed, see errno. */
+#define RGPH_PARTIAL -7 /* Budget of a resumable build step ran out. */
 
 /*
  * RGPH_DEFAULT == (RGPH_HASH_DEFAULT | RGPH_RANK_DEFAULT |
@@ -51,7 +53,9 @@
 #define	RGPH_HASH_XXH32S       4
 #define	RGPH_HASH_XXH64S       5
 #define	RGPH_HASH_T1HA64S      6
-#define	RGPH_HASH_LAST         6
+#define	RGPH_HASH_AES128V      7
+#define	RGPH_HASH_XXH128V      8
+#define	RGPH_HASH_LAST         8
 #define	RGPH_HASH_CUSTOM       0xfd
 #define	RGPH_HASH_CUSTOM32S    0xfe
 #define	RGPH_HASH_CUSTOM64S    0xff
@@ -76,4 +80,10 @@
 #define	RGPH_INDEX_COMPACT 0x4000
 #define	RGPH_INDEX_SPARSE  0x8000
 
+/*
+ * Record struct rgph_peel_stats, see rgph_get_peel_stats(). Only build
+ * functions accept it, rgph_alloc_graph() fails with EINVAL.
+ */
+#define	RGPH_INSTRUMENT    0x10000
+
 #endif /* !RGPH_DEFS_H_INCLUDED */
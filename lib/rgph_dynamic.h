@@ -0,0 +1,67 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef RGPH_DYNAMIC_H_INCLUDED
+#define RGPH_DYNAMIC_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Dynamic table of keys and 64-bit values. Most keys live in a static
+ * part, an assigned CHM graph over a copy of keys. Inserts go to a small
+ * overflow hash table and deletes of static keys set tombstone bits.
+ * When the number of overflow entries and tombstones reaches threshold,
+ * a background thread rebuilds the static part while the table stays
+ * available. Zero threshold disables the thread, rebuild manually.
+ * All functions can be called from any thread.
+ */
+struct rgph_dynamic;
+
+struct rgph_dynamic *rgph_dynamic_create(int, size_t);
+void rgph_dynamic_destroy(struct rgph_dynamic *);
+
+int rgph_dynamic_insert(struct rgph_dynamic *,
+    const void *, size_t, uint64_t);
+int rgph_dynamic_delete(struct rgph_dynamic *, const void *, size_t);
+int rgph_dynamic_lookup(struct rgph_dynamic *,
+    const void *, size_t, uint64_t *);
+int rgph_dynamic_rebuild(struct rgph_dynamic *);
+
+size_t rgph_dynamic_entries(struct rgph_dynamic *);
+size_t rgph_dynamic_changes(struct rgph_dynamic *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !RGPH_DYNAMIC_H_INCLUDED */
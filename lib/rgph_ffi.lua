@@ -0,0 +1,297 @@
+-- LuaJIT FFI binding of librgph.
+--
+-- Unlike the rgph module, calls don't go through the classic Lua C API,
+-- so loops calling lookups can be compiled by LuaJIT. Keys and results
+-- are cdata buffers:
+--
+--     local rgph = require "rgph_ffi"
+--     local keys = ffi.new("uint32_t[?]", n)
+--     local out = ffi.new("uint64_t[?]", n)
+--     local g = rgph.new_graph(n, "chm")
+--     assert(g:build_u32("chm", seed, keys, n))
+--     assert(g:assign())
+--     g:lookup_batch_u32(keys, n, out)
+--
+-- Methods return true or false and an error string like the rgph module.
+-- Lookups of a single key return a number.
+
+local ffi = require "ffi"
+local bit = require "bit"
+
+ffi.cdef[[
+struct rgph_graph;
+
+struct rgph_entry {
+	const void *key;
+	const void *data;
+	size_t keylen;
+	size_t datalen;
+	uint64_t index;
+	uint8_t has_index;
+};
+
+struct rgph_stats {
+	uint64_t hash_ns;
+	uint64_t add_edge_ns;
+	uint64_t peel_ns;
+	uint64_t peel_index_ns;
+	uint64_t assign_ns;
+	uint64_t duplicates_ns;
+	uint64_t nkeys;
+	uint64_t nbuilds;
+	uint64_t index_reallocs;
+	size_t allocated;
+};
+
+typedef const struct rgph_entry * (*rgph_entry_iterator_t)(void *);
+typedef void (*rgph_vector_hash_t)(void const *, size_t, uintptr_t, uint32_t *);
+
+struct rgph_lookup_params {
+	const void *assignments;
+	rgph_vector_hash_t hash;
+	uintptr_t seed;
+	uint64_t index_mod;
+	uint64_t index_base;
+	uint64_t unassigned;
+	size_t nverts;
+	uint32_t partsz;
+	uint32_t fastdiv_mul;
+	uint8_t fastdiv_s2;
+	uint8_t lemire_shift;
+	uint8_t partition_bits;
+	uint8_t width;
+	int rank;
+	int flags;
+};
+
+struct rgph_graph *rgph_alloc_graph(size_t, int);
+void rgph_free_graph(struct rgph_graph *);
+
+int rgph_flags(struct rgph_graph const *);
+int rgph_rank(struct rgph_graph const *);
+size_t rgph_entries(struct rgph_graph const *);
+size_t rgph_vertices(struct rgph_graph const *);
+uint64_t rgph_index_min(struct rgph_graph const *);
+uint64_t rgph_index_max(struct rgph_graph const *);
+size_t rgph_core_size(struct rgph_graph const *);
+uintptr_t rgph_seed(struct rgph_graph const *);
+size_t rgph_hash_bits(struct rgph_graph const *);
+
+int rgph_build_graph(struct rgph_graph *, int,
+    rgph_vector_hash_t hash, uintptr_t, rgph_entry_iterator_t, void *);
+int rgph_build_graph_u32(struct rgph_graph *, int,
+    rgph_vector_hash_t hash, uintptr_t, const uint32_t *, size_t);
+int rgph_build_graph_u64(struct rgph_graph *, int,
+    rgph_vector_hash_t hash, uintptr_t, const uint64_t *, size_t);
+int rgph_is_built(struct rgph_graph const *);
+
+int rgph_build_begin(struct rgph_graph *, int, rgph_vector_hash_t, uintptr_t);
+int rgph_build_step(struct rgph_graph *,
+    rgph_entry_iterator_t, void *, size_t, uint64_t);
+int rgph_build_finish(struct rgph_graph *, size_t, uint64_t);
+size_t rgph_build_position(struct rgph_graph const *);
+
+int rgph_assign(struct rgph_graph *, int);
+int rgph_is_assigned(struct rgph_graph const *);
+const void *rgph_assignments(struct rgph_graph const *, size_t *);
+int rgph_get_lookup_params(struct rgph_graph const *,
+    struct rgph_lookup_params *);
+
+void rgph_get_stats(struct rgph_graph const *, struct rgph_stats *);
+
+int rgph_lookup(struct rgph_graph const *, const void *, size_t, uint64_t *);
+int rgph_lookup_batch(struct rgph_graph const *,
+    const void * const *, const size_t *, size_t, uint64_t *);
+int rgph_lookup_u32(struct rgph_graph const *, uint32_t, uint64_t *);
+int rgph_lookup_u64(struct rgph_graph const *, uint64_t, uint64_t *);
+int rgph_lookup_batch_u32(struct rgph_graph const *,
+    const uint32_t *, size_t, uint64_t *);
+int rgph_lookup_batch_u64(struct rgph_graph const *,
+    const uint64_t *, size_t, uint64_t *);
+]]
+
+local C = ffi.load("rgph")
+
+local _M = { C = C }
+
+-- See rgph_defs.h.
+local flag_values = {
+	jenkins2v = 1, murmur32v = 2, murmur32s = 3, xxh32s = 4,
+	xxh64s = 5, t1ha64s = 6, aes128v = 7, xxh128v = 8,
+	rank2 = 0x100, rank3 = 0x200,
+	chm = 0x400, bdz = 0x800,
+	mod = 0x1000, mul = 0x2000,
+	compact = 0x4000, sparse = 0x8000,
+	instrument = 0x10000,
+}
+
+local errors = {
+	[-1] = "invalid value",
+	[-2] = "out of range",
+	[-3] = "not enough memory",
+	[-4] = "try again",
+	[-5] = "iterator returned no key",
+	[-6] = "system call failed",
+}
+
+-- "chm,rank3" => RGPH_ALGO_CHM | RGPH_RANK3, numbers are passed as is.
+local function parse_flags(flags)
+	if flags == nil then
+		return 0
+	elseif type(flags) == "number" then
+		return flags
+	end
+
+	local res = 0
+	for name in flags:gmatch("[^,]+") do
+		local f = flag_values[name]
+		if not f then
+			error("invalid flag " .. name, 3)
+		end
+		res = bit.bor(res, f)
+	end
+	return res
+end
+
+_M.parse_flags = parse_flags
+
+local function result(res)
+	if res == 0 then
+		return true
+	elseif res == -4 then
+		return false
+	end
+	return false, errors[res] or "unknown error " .. res
+end
+
+local function lookup_result(res, out)
+	if res ~= 0 then
+		error(errors[res] or "unknown error " .. res, 3)
+	end
+	return tonumber(out[0])
+end
+
+local out1 = ffi.new("uint64_t[1]")
+
+local Graph = {}
+
+function Graph:rank() return C.rgph_rank(self) end
+function Graph:flags() return C.rgph_flags(self) end
+function Graph:entries() return tonumber(C.rgph_entries(self)) end
+function Graph:vertices() return tonumber(C.rgph_vertices(self)) end
+function Graph:index_min() return tonumber(C.rgph_index_min(self)) end
+function Graph:index_max() return tonumber(C.rgph_index_max(self)) end
+function Graph:core_size() return tonumber(C.rgph_core_size(self)) end
+function Graph:seed() return tonumber(C.rgph_seed(self)) end
+function Graph:hash_bits() return tonumber(C.rgph_hash_bits(self)) end
+
+-- Build from a cdata array of n struct rgph_entry.
+function Graph:build(flags, seed, entries, n)
+	local i = 0
+	local iter = ffi.cast("rgph_entry_iterator_t", function()
+		if i == n then
+			return nil
+		end
+		i = i + 1
+		return entries + (i - 1)
+	end)
+	local res = C.rgph_build_graph(self, parse_flags(flags),
+	    nil, seed, iter, nil)
+	iter:free()
+	return result(res)
+end
+
+function Graph:build_u32(flags, seed, keys, n)
+	return result(C.rgph_build_graph_u32(self, parse_flags(flags),
+	    nil, seed, keys, n))
+end
+
+function Graph:build_u64(flags, seed, keys, n)
+	return result(C.rgph_build_graph_u64(self, parse_flags(flags),
+	    nil, seed, keys, n))
+end
+
+-- Resumable build, step and finish return nil when a budget runs out.
+-- Steps read entries[position] to entries[n - 1].
+local function step_result(res)
+	if res == -7 then
+		return nil
+	end
+	return result(res)
+end
+
+function Graph:build_begin(flags, seed)
+	return result(C.rgph_build_begin(self, parse_flags(flags), nil, seed))
+end
+
+function Graph:build_step(entries, n, maxkeys, maxns)
+	local i = tonumber(C.rgph_build_position(self))
+	local iter = ffi.cast("rgph_entry_iterator_t", function()
+		if i >= n then
+			return nil
+		end
+		i = i + 1
+		return entries + (i - 1)
+	end)
+	local res = C.rgph_build_step(self, iter, nil, maxkeys or 0, maxns or 0)
+	iter:free()
+	return step_result(res)
+end
+
+function Graph:build_finish(maxverts, maxns)
+	return step_result(C.rgph_build_finish(self, maxverts or 0, maxns or 0))
+end
+
+function Graph:assign(flags)
+	return result(C.rgph_assign(self, parse_flags(flags)))
+end
+
+function Graph:lookup_params()
+	local p = ffi.new("struct rgph_lookup_params")
+	local res = C.rgph_get_lookup_params(self, p)
+	if res ~= 0 then
+		return nil, errors[res]
+	end
+	return p
+end
+
+-- Key is a string or a pointer to keylen bytes.
+function Graph:lookup(key, keylen)
+	local res = C.rgph_lookup(self, key, keylen or #key, out1)
+	return lookup_result(res, out1)
+end
+
+function Graph:lookup_u32(key)
+	return lookup_result(C.rgph_lookup_u32(self, key, out1), out1)
+end
+
+function Graph:lookup_u64(key)
+	return lookup_result(C.rgph_lookup_u64(self, key, out1), out1)
+end
+
+-- Results are stored in a cdata array out of n uint64_t.
+function Graph:lookup_batch(keys, keylens, n, out)
+	return result(C.rgph_lookup_batch(self, keys, keylens, n, out))
+end
+
+function Graph:lookup_batch_u32(keys, n, out)
+	return result(C.rgph_lookup_batch_u32(self, keys, n, out))
+end
+
+function Graph:lookup_batch_u64(keys, n, out)
+	return result(C.rgph_lookup_batch_u64(self, keys, n, out))
+end
+
+ffi.metatype("struct rgph_graph", { __index = Graph })
+
+function _M.new_graph(nkeys, flags)
+	local g = C.rgph_alloc_graph(nkeys, parse_flags(flags))
+	if g == nil then
+		local ENOMEM = 12
+		return nil, ffi.errno() == ENOMEM
+		    and "not enough memory" or "invalid value"
+	end
+	return ffi.gc(g, C.rgph_free_graph)
+end
+
+return _M
@@ -47,9 +47,72 @@ struct rgph_entry {
 	uint8_t has_index;
 };
 
+/*
+ * Counters are cumulative since rgph_alloc_graph(), they include
+ * all failed builds.
+ */
+struct rgph_stats {
+	uint64_t hash_ns;        /* Key iteration and hashing. */
+	uint64_t add_edge_ns;    /* Adding edges to the graph. */
+	uint64_t peel_ns;        /* Peeling. */
+	uint64_t peel_index_ns;  /* Peel order index. */
+	uint64_t assign_ns;      /* Assignment step. */
+	uint64_t duplicates_ns;  /* Duplicates search. */
+	uint64_t nkeys;          /* Keys processed by all builds. */
+	uint64_t nbuilds;        /* Number of builds. */
+	uint64_t index_reallocs; /* Reallocations of chm index. */
+	size_t allocated;        /* Bytes currently allocated by the graph. */
+};
+
+#define RGPH_DEGREE_BINS 16
+
+/*
+ * Recorded by builds with RGPH_INSTRUMENT flag.
+ * The last bin of the degree histogram counts vertices of degree
+ * RGPH_DEGREE_BINS-1 or higher.
+ */
+struct rgph_peel_stats {
+	size_t degree[RGPH_DEGREE_BINS]; /* Degrees after adding all edges. */
+	size_t scan_peeled;    /* Edges peeled by the initial scan. */
+	size_t cascade_peeled; /* Edges peeled by the cascade. */
+	size_t core_edges;     /* Edges in the 2-core. */
+	size_t core_verts;     /* Vertices in the 2-core. */
+};
+
+/*
+ * Built-in scalar hashes don't split a hash value h into narrow vertex
+ * hashes. Instead, vertex hash r of an edge is x ^ (x >> 32) truncated
+ * to 32 bits where x = (y ^ (y >> 32)) * RGPH_DERIVE_MUL and
+ * y = h + (r + 1) * RGPH_DERIVE_ADD.
+ */
+#define RGPH_DERIVE_ADD UINT64_C(0x9e3779b97f4a7c15)
+#define RGPH_DERIVE_MUL UINT64_C(0xd6e8feb86659fd93)
+
 typedef const struct rgph_entry * (*rgph_entry_iterator_t)(void *);
 typedef void (*rgph_vector_hash_t)(void const *, size_t, uintptr_t, uint32_t *);
 
+/*
+ * Constants of an assigned graph for lookups outside of the library,
+ * see rgph_lookup.h.
+ */
+struct rgph_lookup_params {
+	const void *assignments; /* Array of nverts elements of width bytes. */
+	rgph_vector_hash_t hash; /* Custom hash or NULL. */
+	uintptr_t seed;
+	uint64_t index_mod;      /* CHM modulo of index sums, 0 wraps. */
+	uint64_t index_base;     /* CHM offset added to index sums. */
+	uint64_t unassigned;     /* Assignment of vertices without edges. */
+	size_t nverts;
+	uint32_t partsz;         /* Partition size, nverts / rank. */
+	uint32_t fastdiv_mul;    /* RGPH_REDUCE_MOD constants. */
+	uint8_t fastdiv_s2;
+	uint8_t lemire_shift;    /* RGPH_REDUCE_MUL shift. */
+	uint8_t partition_bits;  /* Bits of a vertex hash per partition. */
+	uint8_t width;           /* 1 for BDZ, 4 or 8 for CHM. */
+	int rank;
+	int flags;
+};
+
 struct rgph_graph *rgph_alloc_graph(size_t, int);
 void rgph_free_graph(struct rgph_graph *);
 
@@ -57,6 +120,7 @@ int rgph_flags(struct rgph_graph const *);
 int rgph_rank(struct rgph_graph const *);
 size_t rgph_entries(struct rgph_graph const *);
 size_t rgph_vertices(struct rgph_graph const *);
+size_t rgph_keylen(struct rgph_graph const *);
 size_t rgph_datalen_min(struct rgph_graph const *);
 size_t rgph_datalen_max(struct rgph_graph const *);
 uint64_t rgph_index_min(struct rgph_graph const *);
@@ -67,8 +131,42 @@ size_t rgph_hash_bits(struct rgph_graph const *);
 
 int rgph_build_graph(struct rgph_graph *, int,
     rgph_vector_hash_t hash, uintptr_t, rgph_entry_iterator_t, void *);
+int rgph_build_graph_u32(struct rgph_graph *, int,
+    rgph_vector_hash_t hash, uintptr_t, const uint32_t *, size_t);
+int rgph_build_graph_u64(struct rgph_graph *, int,
+    rgph_vector_hash_t hash, uintptr_t, const uint64_t *, size_t);
 int rgph_is_built(struct rgph_graph const *);
 
+/*
+ * Resumable build. rgph_build_begin() starts a build without reading
+ * keys. rgph_build_step() adds up to maxkeys keys from the iterator
+ * and rgph_build_finish() peels up to maxverts vertices or edges, both
+ * stop after about maxns nanoseconds. Zero budgets are unlimited.
+ * They return RGPH_PARTIAL when a budget runs out, call them again
+ * with the same iterator state. When all keys are added, the step
+ * returns RGPH_SUCCESS and the finish returns what rgph_build_graph()
+ * would return.
+ */
+int rgph_build_begin(struct rgph_graph *, int, rgph_vector_hash_t, uintptr_t);
+int rgph_build_step(struct rgph_graph *,
+    rgph_entry_iterator_t, void *, size_t, uint64_t);
+int rgph_build_finish(struct rgph_graph *, size_t, uint64_t);
+size_t rgph_build_position(struct rgph_graph const *);
+
+/*
+ * Push-based build. After rgph_builder_begin(), any number of threads
+ * can call rgph_builder_add() at the same time, each call adds a batch
+ * of entries. Keys without an index get the next free edge number,
+ * use explicit indices with the CHM algorithm if the order matters.
+ * rgph_builder_finish() peels and assigns once all rgph_builder_add()
+ * calls have returned, RGPH_AGAIN means that all keys should be added
+ * again with a new seed. rgph_find_duplicates() can't replay keys
+ * in the order they were added.
+ */
+int rgph_builder_begin(struct rgph_graph *, int, rgph_vector_hash_t, uintptr_t);
+int rgph_builder_add(struct rgph_graph *, const struct rgph_entry *, size_t);
+int rgph_builder_finish(struct rgph_graph *, int);
+
 int rgph_copy_edge(struct rgph_graph *, size_t, uint32_t *, size_t *);
 
 size_t rgph_count_keys(rgph_entry_iterator_t, void *);
@@ -80,6 +178,21 @@ int rgph_assign(struct rgph_graph *, int);
 int rgph_is_assigned(struct rgph_graph const *);
 const void *rgph_assignments(struct rgph_graph const *, size_t *);
 int rgph_copy_assignment(struct rgph_graph const *, size_t, uint64_t *);
+int rgph_get_lookup_params(struct rgph_graph const *,
+    struct rgph_lookup_params *);
+
+void rgph_get_stats(struct rgph_graph const *, struct rgph_stats *);
+int rgph_get_peel_stats(struct rgph_graph const *, struct rgph_peel_stats *);
+
+int rgph_lookup(struct rgph_graph const *, const void *, size_t, uint64_t *);
+int rgph_lookup_batch(struct rgph_graph const *,
+    const void * const *, const size_t *, size_t, uint64_t *);
+int rgph_lookup_u32(struct rgph_graph const *, uint32_t, uint64_t *);
+int rgph_lookup_u64(struct rgph_graph const *, uint64_t, uint64_t *);
+int rgph_lookup_batch_u32(struct rgph_graph const *,
+    const uint32_t *, size_t, uint64_t *);
+int rgph_lookup_batch_u64(struct rgph_graph const *,
+    const uint64_t *, size_t, uint64_t *);
 
 #ifdef __cplusplus
 }
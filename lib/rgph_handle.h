@@ -0,0 +1,72 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef RGPH_HANDLE_H_INCLUDED
+#define RGPH_HANDLE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct rgph_graph;
+
+/*
+ * Handle of an assigned graph that can be replaced while other threads
+ * look keys up. Readers don't take locks: rgph_handle_enter() returns
+ * the current graph and rgph_handle_leave() must be called with the same
+ * token when the reader is done with it. rgph_handle_publish() swaps in
+ * a new graph, waits until no reader holds the old graph and frees it.
+ * It returns RGPH_INVAL and keeps the old graph if the new graph isn't
+ * assigned, the caller still owns the new graph in that case.
+ * Publishers are serialised, only they can wait.
+ * The handle owns its graph, NULL means an empty table.
+ */
+struct rgph_handle;
+
+struct rgph_handle *rgph_handle_create(struct rgph_graph *);
+void rgph_handle_destroy(struct rgph_handle *);
+
+const struct rgph_graph *rgph_handle_enter(struct rgph_handle *, unsigned *);
+void rgph_handle_leave(struct rgph_handle *, unsigned);
+
+int rgph_handle_publish(struct rgph_handle *, struct rgph_graph *);
+
+/* Enter, rgph_lookup*() and leave, RGPH_NOKEY if there is no graph. */
+int rgph_handle_lookup(struct rgph_handle *,
+    const void *, size_t, uint64_t *);
+int rgph_handle_lookup_batch(struct rgph_handle *,
+    const void * const *, const size_t *, size_t, uint64_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !RGPH_HANDLE_H_INCLUDED */
@@ -55,6 +55,16 @@ void rgph_u32x3_jenkins2v_u64a(const uint64_t *, size_t, uintptr_t, uint32_t *);
 void rgph_u32x3_jenkins2v_f32a(const float *,    size_t, uintptr_t, uint32_t *);
 void rgph_u32x3_jenkins2v_f64a(const double *,   size_t, uintptr_t, uint32_t *);
 
+/* Jenkins 2 x3 hashes for batches of fixed width keys. */
+void rgph_u32x3_jenkins2v_u32_batch(const uint32_t *, size_t, uintptr_t,
+    uint32_t *);
+void rgph_u32x3_jenkins2v_u64_batch(const uint64_t *, size_t, uintptr_t,
+    uint32_t *);
+
+/* Jenkins 2 x3 hashes for batches of keys of any length. */
+void rgph_u32x3_jenkins2v_data_batch(const void * const *, const size_t *,
+    size_t, uintptr_t, uint32_t *);
+
 
 /* 32bit Murmur 3 generic x4 hash for any data. */
 void rgph_u32x4_murmur32v_data(const void *, size_t, uintptr_t, uint32_t *);
@@ -75,6 +85,12 @@ void rgph_u32x4_murmur32v_u64a(const uint64_t *, size_t, uintptr_t, uint32_t *);
 void rgph_u32x4_murmur32v_f32a(const float *,    size_t, uintptr_t, uint32_t *);
 void rgph_u32x4_murmur32v_f64a(const double *,   size_t, uintptr_t, uint32_t *);
 
+/* Murmur 3 x4 hashes for batches of fixed width keys. */
+void rgph_u32x4_murmur32v_u32_batch(const uint32_t *, size_t, uintptr_t,
+    uint32_t *);
+void rgph_u32x4_murmur32v_u64_batch(const uint64_t *, size_t, uintptr_t,
+    uint32_t *);
+
 
 /* 32bit Murmur 3 (short) generic scalar hash for any data. */
 uint32_t rgph_u32_murmur32s_data(const void *, size_t, uintptr_t);
@@ -95,6 +111,12 @@ uint32_t rgph_u32_murmur32s_u64a(const uint64_t *, size_t, uintptr_t);
 uint32_t rgph_u32_murmur32s_f32a(const float *,  size_t, uintptr_t);
 uint32_t rgph_u32_murmur32s_f64a(const double *, size_t, uintptr_t);
 
+/* Murmur 3 scalar 32bit hashes for batches of fixed width keys. */
+void rgph_u32_murmur32s_u32_batch(const uint32_t *, size_t, uintptr_t,
+    uint32_t *);
+void rgph_u32_murmur32s_u64_batch(const uint64_t *, size_t, uintptr_t,
+    uint32_t *);
+
 
 /* 32bit xxHash (short) generic scalar hash for any data. */
 uint32_t rgph_u32_xxh32s_data(const void *, size_t, uintptr_t);
@@ -115,6 +137,12 @@ uint32_t rgph_u32_xxh32s_u64a(const uint64_t *, size_t, uintptr_t);
 uint32_t rgph_u32_xxh32s_f32a(const float *,  size_t, uintptr_t);
 uint32_t rgph_u32_xxh32s_f64a(const double *, size_t, uintptr_t);
 
+/* 32bit xxHash (short) scalar 32bit hashes for batches of fixed width keys. */
+void rgph_u32_xxh32s_u32_batch(const uint32_t *, size_t, uintptr_t,
+    uint32_t *);
+void rgph_u32_xxh32s_u64_batch(const uint64_t *, size_t, uintptr_t,
+    uint32_t *);
+
 
 /* 64bit xxHash (short) generic scalar hash for any data. */
 uint64_t rgph_u64_xxh64s_data(const void *, size_t, uintptr_t);
@@ -135,6 +163,12 @@ uint64_t rgph_u64_xxh64s_u64a(const uint64_t *, size_t, uintptr_t);
 uint64_t rgph_u64_xxh64s_f32a(const float *,  size_t, uintptr_t);
 uint64_t rgph_u64_xxh64s_f64a(const double *, size_t, uintptr_t);
 
+/* 64bit xxHash (short) scalar 64bit hashes for batches of fixed width keys. */
+void rgph_u64_xxh64s_u32_batch(const uint32_t *, size_t, uintptr_t,
+    uint64_t *);
+void rgph_u64_xxh64s_u64_batch(const uint64_t *, size_t, uintptr_t,
+    uint64_t *);
+
 
 /* 64bit t1ha (short) generic scalar hash for any data. */
 uint64_t rgph_u64_t1ha64s_data(const void *, size_t, uintptr_t);
@@ -155,6 +189,58 @@ uint64_t rgph_u64_t1ha64s_u64a(const uint64_t *, size_t, uintptr_t);
 uint64_t rgph_u64_t1ha64s_f32a(const float *,  size_t, uintptr_t);
 uint64_t rgph_u64_t1ha64s_f64a(const double *, size_t, uintptr_t);
 
+/* 64bit t1ha (short) scalar 64bit hashes for batches of fixed width keys. */
+void rgph_u64_t1ha64s_u32_batch(const uint32_t *, size_t, uintptr_t,
+    uint64_t *);
+void rgph_u64_t1ha64s_u64_batch(const uint64_t *, size_t, uintptr_t,
+    uint64_t *);
+
+
+/* AES based generic x4 hash for any data. Uses AES-NI if available. */
+void rgph_u32x4_aes128v_data(const void *, size_t, uintptr_t, uint32_t *);
+
+/* AES based x4 hashes for fixed width types. */
+void rgph_u32x4_aes128v_u8 (uint8_t,  uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_u16(uint16_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_u32(uint32_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_u64(uint64_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_f32(float,    uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_f64(double,   uintptr_t, uint32_t *);
+
+/* AES based x4 hashes for arrays. */
+void rgph_u32x4_aes128v_u8a(const uint8_t *,   size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_u16a(const uint16_t *, size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_u32a(const uint32_t *, size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_u64a(const uint64_t *, size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_f32a(const float *,    size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_aes128v_f64a(const double *,   size_t, uintptr_t, uint32_t *);
+
+
+/* XXH3 128bit generic x4 hash for any data. */
+void rgph_u32x4_xxh128v_data(const void *, size_t, uintptr_t, uint32_t *);
+
+/* XXH3 128bit x4 hashes for fixed width types. */
+void rgph_u32x4_xxh128v_u8 (uint8_t,  uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_u16(uint16_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_u32(uint32_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_u64(uint64_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_f32(float,    uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_f64(double,   uintptr_t, uint32_t *);
+
+/* XXH3 128bit x4 hashes for arrays. */
+void rgph_u32x4_xxh128v_u8a(const uint8_t *,   size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_u16a(const uint16_t *, size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_u32a(const uint32_t *, size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_u64a(const uint64_t *, size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_f32a(const float *,    size_t, uintptr_t, uint32_t *);
+void rgph_u32x4_xxh128v_f64a(const double *,   size_t, uintptr_t, uint32_t *);
+
+/*
+ * Name of kernels selected at runtime for the current CPU, e.g. "avx2"
+ * or "generic". Set the RGPH_KERNELS environment variable to override.
+ */
+const char *rgph_hash_kernels(void);
+
 #ifdef __cplusplus
 }
 #endif
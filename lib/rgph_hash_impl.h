@@ -104,6 +104,31 @@
 #define RGPH_T1HA64S_ROT1 17
 #define RGPH_T1HA64S_ROT2 31
 
+#define RGPH_XXH128V_PRIME32_1 UINT32_C(0x9e3779b1)
+#define RGPH_XXH128V_PRIME32_2 UINT32_C(0x85ebca77)
+#define RGPH_XXH128V_PRIME32_3 UINT32_C(0xc2b2ae3d)
+#define RGPH_XXH128V_PRIME64_1 UINT64_C(0x9e3779b185ebca87)
+#define RGPH_XXH128V_PRIME64_2 UINT64_C(0xc2b2ae3d27d4eb4f)
+#define RGPH_XXH128V_PRIME64_3 UINT64_C(0x165667b19e3779f9)
+#define RGPH_XXH128V_PRIME64_4 UINT64_C(0x85ebca77c2b2ae63)
+#define RGPH_XXH128V_PRIME64_5 UINT64_C(0x27d4eb2f165667c5)
+#define RGPH_XXH128V_PRIME_MX1 UINT64_C(0x165667919e3779f9)
+#define RGPH_XXH128V_PRIME_MX2 UINT64_C(0x9fb21c651e98df25)
+
+/* Round keys, the first 512 bits of pi (also used by Blowfish). */
+#define RGPH_AES128V_K0 \
+	UINT32_C(0x243f6a88), UINT32_C(0x85a308d3), \
+	UINT32_C(0x13198a2e), UINT32_C(0x03707344)
+#define RGPH_AES128V_K1 \
+	UINT32_C(0xa4093822), UINT32_C(0x299f31d0), \
+	UINT32_C(0x082efa98), UINT32_C(0xec4e6c89)
+#define RGPH_AES128V_K2 \
+	UINT32_C(0x452821e6), UINT32_C(0x38d01377), \
+	UINT32_C(0xbe5466cf), UINT32_C(0x34e90c6c)
+#define RGPH_AES128V_K3 \
+	UINT32_C(0xc0ac29b7), UINT32_C(0xc97c50dd), \
+	UINT32_C(0x3f84d5b5), UINT32_C(0xb5470917)
+
 /* XXX Check with the C99 standard. */
 #define rgph_unalias(T, p) ((T)(const char *)(p))
 
@@ -599,6 +624,29 @@ rgph_t1ha64s_mux(uint64_t a, uint64_t b)
 #endif
 }
 
+/*
+ * Full 128bit product of two 64bit words.
+ */
+static inline uint64_t
+rgph_mul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+#if !defined(__STRICT_ANSI__) && defined(__SIZEOF_INT128__)
+	__uint128_t m = (__uint128_t)a * (__uint128_t)b;
+
+	*high = m >> 64;
+	return m;
+#else
+	uint64_t hh = (a >> 32) * (b >> 32);
+	uint64_t hl = (a >> 32) * (b & UINT32_MAX);
+	uint64_t lh = (b >> 32) * (a & UINT32_MAX);
+	uint64_t ll = (a & UINT32_MAX) * (b & UINT32_MAX);
+	uint64_t cross = (ll >> 32) + (hl & UINT32_MAX) + lh;
+
+	*high = hh + (hl >> 32) + (cross >> 32);
+	return (cross << 32) | (ll & UINT32_MAX);
+#endif
+}
+
 static inline void
 rgph_t1ha64s_fmix4(uint64_t k, uint64_t h[/* static 2 */])
 {
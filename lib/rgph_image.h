@@ -0,0 +1,64 @@
+/*-
+ * Copyright (c) 2015 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef RGPH_IMAGE_H_INCLUDED
+#define RGPH_IMAGE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rgph_graph.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Image of an assigned graph: a header with struct rgph_lookup_params
+ * constants followed by the assignments array. Images are in native
+ * byte order and graphs with custom hashes can't be saved.
+ */
+struct rgph_image;
+
+int rgph_save_image(struct rgph_graph const *, const char *);
+
+/* Map an image read-only, pages are shared by all processes. */
+struct rgph_image *rgph_open_image(const char *);
+void rgph_close_image(struct rgph_image *);
+
+size_t rgph_image_entries(struct rgph_image const *);
+const struct rgph_lookup_params *rgph_image_params(struct rgph_image const *);
+
+int rgph_image_lookup(struct rgph_image const *,
+    const void *, size_t, uint64_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !RGPH_IMAGE_H_INCLUDED */
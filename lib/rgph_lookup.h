@@ -0,0 +1,182 @@
+/*-
+ * Copyright (c) 2015 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef RGPH_LOOKUP_H_INCLUDED
+#define RGPH_LOOKUP_H_INCLUDED
+
+/*
+ * Header-only lookup in an assigned graph. It needs nothing from
+ * the graph except struct rgph_lookup_params filled in by
+ * rgph_get_lookup_params() and the assignments array it points to.
+ * Unlike rgph_lookup(), there are no calls through the library and
+ * all constants can be propagated by a compiler if the structure
+ * is a compile-time constant.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rgph_defs.h>
+#include <rgph_graph.h>
+#include <rgph_hash.h>
+
+/* Vertex hashes of built-in scalar hashes, see RGPH_DERIVE_ADD. */
+static inline void
+rgph_inline_derive(uint64_t h, int rank, uint32_t *hashes)
+{
+	uint64_t x;
+	int r;
+
+	for (r = 0; r < rank; r++) {
+		x = h + (r + 1) * RGPH_DERIVE_ADD;
+		x = (x ^ (x >> 32)) * RGPH_DERIVE_MUL;
+		hashes[r] = (uint32_t)(x ^ (x >> 32));
+	}
+}
+
+/* Vertex hashes of a key, at least rank elements are set. */
+static inline void
+rgph_inline_hash(const struct rgph_lookup_params *p,
+    const void *key, size_t keylen, uint32_t hashes[4])
+{
+
+	switch (p->flags & RGPH_HASH_MASK) {
+	case RGPH_HASH_JENKINS2V:
+		rgph_u32x3_jenkins2v_data(key, keylen, p->seed, hashes);
+		break;
+	case RGPH_HASH_MURMUR32V:
+		rgph_u32x4_murmur32v_data(key, keylen, p->seed, hashes);
+		break;
+	case RGPH_HASH_MURMUR32S:
+		rgph_inline_derive(rgph_u32_murmur32s_data(key, keylen,
+		    p->seed), p->rank, hashes);
+		break;
+	case RGPH_HASH_XXH32S:
+		rgph_inline_derive(rgph_u32_xxh32s_data(key, keylen,
+		    p->seed), p->rank, hashes);
+		break;
+	case RGPH_HASH_XXH64S:
+		rgph_inline_derive(rgph_u64_xxh64s_data(key, keylen,
+		    p->seed), p->rank, hashes);
+		break;
+	case RGPH_HASH_T1HA64S:
+		rgph_inline_derive(rgph_u64_t1ha64s_data(key, keylen,
+		    p->seed), p->rank, hashes);
+		break;
+	case RGPH_HASH_AES128V:
+		rgph_u32x4_aes128v_data(key, keylen, p->seed, hashes);
+		break;
+	case RGPH_HASH_XXH128V:
+		rgph_u32x4_xxh128v_data(key, keylen, p->seed, hashes);
+		break;
+	default:
+		p->hash(key, keylen, p->seed, hashes);
+		break;
+	}
+}
+
+/* Vertex of partition r, see fastrem_partition and lemire_partition. */
+static inline uint32_t
+rgph_inline_vertex(const struct rgph_lookup_params *p,
+    const uint32_t *hashes, int r)
+{
+	const uint32_t h = hashes[r];
+	uint32_t hi, q;
+
+	if (p->flags & RGPH_REDUCE_MUL) {
+		return (uint32_t)((h * (uint64_t)p->partsz) >>
+		    p->lemire_shift) + r * p->partsz;
+	}
+
+	hi = (uint32_t)((h * (uint64_t)p->fastdiv_mul) >> 32);
+	q = (hi + ((h - hi) >> 1)) >> p->fastdiv_s2;
+	return h - p->partsz * q + r * p->partsz;
+}
+
+/* Assignment of vertex v zero-extended to 64 bits. */
+static inline uint64_t
+rgph_inline_assignment(const struct rgph_lookup_params *p, uint32_t v)
+{
+
+	switch (p->width) {
+	case 1:
+		return ((const uint8_t *)p->assignments)[v];
+	case 4:
+		return ((const uint32_t *)p->assignments)[v];
+	default:
+		return ((const uint64_t *)p->assignments)[v];
+	}
+}
+
+/* Index of an edge with the given vertex hashes, see rgph_lookup(). */
+static inline uint64_t
+rgph_inline_index(const struct rgph_lookup_params *p, const uint32_t *hashes)
+{
+	const uint64_t mod = p->index_mod;
+	uint32_t verts[3];
+	uint64_t a, h = 0;
+	unsigned int i = 0;
+	int r;
+
+	for (r = 0; r < p->rank; r++)
+		verts[r] = rgph_inline_vertex(p, hashes, r);
+
+	if ((p->flags & RGPH_ALGO_MASK) == RGPH_ALGO_BDZ) {
+		for (r = 0; r < p->rank; r++)
+			i += rgph_inline_assignment(p, verts[r]);
+		return verts[i % p->rank];
+	}
+
+	for (r = 0; r < p->rank; r++) {
+		a = rgph_inline_assignment(p, verts[r]);
+		if (mod != 0)
+			h = (a >= mod - h) ? a - (mod - h) : h + a;
+		else if (p->width == 4)
+			h = (uint32_t)(h + a);
+		else
+			h = h + a;
+	}
+
+	return h + p->index_base;
+}
+
+/*
+ * Look up a key. Like rgph_lookup(), it returns an arbitrary index
+ * for keys that weren't in the graph.
+ */
+static inline uint64_t
+rgph_inline_lookup(const struct rgph_lookup_params *p,
+    const void *key, size_t keylen)
+{
+	uint32_t hashes[4];
+
+	rgph_inline_hash(p, key, keylen, hashes);
+	return rgph_inline_index(p, hashes);
+}
+
+#endif /* !RGPH_LOOKUP_H_INCLUDED */
@@ -33,12 +33,13 @@
 
 #include "rgph_hash_impl.h"
 #include "rgph_hash.h"
+#include "rgph_cpu.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
 
-uint64_t
+inline uint64_t
 rgph_u64_t1ha64s_data(const void *data, size_t len, uintptr_t seed)
 {
 	const uint8_t *key = data;
@@ -135,3 +136,5 @@ rgph_u64_t1ha64s_data(const void *data, size_t len, uintptr_t seed)
 
 	return rgph_t1ha64s_finalise(h);
 }
+
+RGPH_FIXED_SCALAR(rgph_u64_t1ha64s_data, uint64_t)
@@ -0,0 +1,122 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Generic hashes compiled with UNALIGNED_READ for platforms where
+ * unaligned reads are safe, see cpu.c. The aes128v and xxh128v
+ * hashes don't depend on alignment, x86 kernels replace the former
+ * with the AES-NI copy. Including hashes here also defines their
+ * fixed length copies.
+ */
+#include "rgph_hash_impl.h"
+#include "rgph_cpu.h"
+
+#if defined(RGPH_UNALIGNED_KERNELS)
+#if !defined(UNALIGNED_READ)
+#define UNALIGNED_READ
+#endif
+
+#define rgph_u32x3_jenkins2v_data \
+	RGPH_ISA_NAME(rgph_u32x3_jenkins2v_data, unaligned)
+#define rgph_u32x3_jenkins2v_data_batch \
+	RGPH_ISA_NAME(rgph_u32x3_jenkins2v_data_batch, unaligned)
+#define rgph_u32x4_murmur32v_data \
+	RGPH_ISA_NAME(rgph_u32x4_murmur32v_data, unaligned)
+#define rgph_u32_murmur32s_data \
+	RGPH_ISA_NAME(rgph_u32_murmur32s_data, unaligned)
+#define rgph_u32_xxh32s_data \
+	RGPH_ISA_NAME(rgph_u32_xxh32s_data, unaligned)
+#define rgph_u64_xxh64s_data \
+	RGPH_ISA_NAME(rgph_u64_xxh64s_data, unaligned)
+#define rgph_u64_t1ha64s_data \
+	RGPH_ISA_NAME(rgph_u64_t1ha64s_data, unaligned)
+
+#include "jenkins2v.c"
+#include "murmur32v.c"
+#include "murmur32s.c"
+#include "xxh32s.c"
+#include "xxh64s.c"
+#include "t1ha64s.c"
+
+const struct rgph_data_kernels rgph_data_kernels_unaligned = {
+	&rgph_u32x3_jenkins2v_data,
+	&rgph_u32x4_murmur32v_data,
+	&rgph_u32_murmur32s_data,
+	&rgph_u32_xxh32s_data,
+	&rgph_u64_xxh64s_data,
+	&rgph_u64_t1ha64s_data,
+	&rgph_u32x4_aes128v_data_generic,
+	&rgph_u32x4_xxh128v_data,
+	&rgph_u32x3_jenkins2v_data_batch
+};
+
+#define FIXED_KERNELS(n, aes) {                      \
+	&rgph_u32x3_jenkins2v_data_unaligned_fixed##n,  \
+	&rgph_u32x4_murmur32v_data_unaligned_fixed##n,  \
+	&rgph_u32_murmur32s_data_unaligned_fixed##n,    \
+	&rgph_u32_xxh32s_data_unaligned_fixed##n,       \
+	&rgph_u64_xxh64s_data_unaligned_fixed##n,       \
+	&rgph_u64_t1ha64s_data_unaligned_fixed##n,      \
+	&rgph_u32x4_aes128v_data_##aes##_fixed##n,      \
+	&rgph_u32x4_xxh128v_data_fixed##n,              \
+	NULL                                            \
+}
+
+const struct rgph_data_kernels rgph_fixed_kernels_unaligned[RGPH_FIXED_NLENS] = {
+	FIXED_KERNELS(4, generic),
+	FIXED_KERNELS(8, generic),
+	FIXED_KERNELS(12, generic),
+	FIXED_KERNELS(16, generic),
+	FIXED_KERNELS(20, generic),
+	FIXED_KERNELS(32, generic)
+};
+
+#if defined(RGPH_X86_KERNELS)
+const struct rgph_data_kernels rgph_data_kernels_aesni = {
+	&rgph_u32x3_jenkins2v_data,
+	&rgph_u32x4_murmur32v_data,
+	&rgph_u32_murmur32s_data,
+	&rgph_u32_xxh32s_data,
+	&rgph_u64_xxh64s_data,
+	&rgph_u64_t1ha64s_data,
+	&rgph_u32x4_aes128v_data_aesni,
+	&rgph_u32x4_xxh128v_data,
+	&rgph_u32x3_jenkins2v_data_batch
+};
+
+const struct rgph_data_kernels rgph_fixed_kernels_aesni[RGPH_FIXED_NLENS] = {
+	FIXED_KERNELS(4, aesni),
+	FIXED_KERNELS(8, aesni),
+	FIXED_KERNELS(12, aesni),
+	FIXED_KERNELS(16, aesni),
+	FIXED_KERNELS(20, aesni),
+	FIXED_KERNELS(32, aesni)
+};
+#endif
+#endif /* RGPH_UNALIGNED_KERNELS */
@@ -0,0 +1,128 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "rgph_hash_impl.h"
+#include "rgph_hash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+void
+rgph_u32x4_xxh128v_u8(uint8_t value, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(&value, sizeof(value), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u16(uint16_t value, uintptr_t seed, uint32_t *h)
+{
+	const uint16_t le = htole16(value);
+
+	rgph_u32x4_xxh128v_data(&le, sizeof(le), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u32(uint32_t value, uintptr_t seed, uint32_t *h)
+{
+	const uint32_t le = htole32(value);
+
+	rgph_u32x4_xxh128v_data(&le, sizeof(le), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u64(uint64_t value, uintptr_t seed, uint32_t *h)
+{
+	const uint64_t le = htole64(value);
+
+	rgph_u32x4_xxh128v_data(&le, sizeof(le), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_f32(float value, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_u32(rgph_f2u32(value), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_f64(double value, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_u64(rgph_d2u64(value), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u8a(const uint8_t *key,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, len, seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u16a(const uint16_t *key,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, len * sizeof(key[0]), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u32a(const uint32_t *key,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, len * sizeof(key[0]), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_u64a(const uint64_t *key,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, len * sizeof(key[0]), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_f32a(const float *key,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, len * sizeof(key[0]), seed, h);
+}
+
+void
+rgph_u32x4_xxh128v_f64a(const double *key,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, len * sizeof(key[0]), seed, h);
+}
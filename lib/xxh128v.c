@@ -0,0 +1,403 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * XXH3 128bit hash by Yann Collet. Values match XXH3_128bits_withSeed()
+ * of the reference implementation; h[0] and h[1] are the low 64 bits,
+ * h[2] and h[3] are the high 64 bits, in little-endian word order.
+ */
+#include "rgph_hash_impl.h"
+#include "rgph_hash.h"
+#include "rgph_cpu.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STRIPE_LEN 64
+#define SECRET_SIZE 192
+#define SECRET_SIZE_MIN 136
+#define SECRET_MERGEACCS_START 11
+#define SECRET_LASTACC_START 7
+#define MID_SIZE_MAX 240
+
+static const uint8_t secret[SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe,
+	0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+	0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78,
+	0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e,
+	0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+	0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e,
+	0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f,
+	0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+	0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3,
+	0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49,
+	0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+	0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28,
+	0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+/*
+ * Read 32bit and 64bit words from any pointer in little-endian order.
+ */
+static inline uint32_t
+read32(const uint8_t *ptr)
+{
+	uint32_t w;
+
+	memcpy(&w, ptr, sizeof(w));
+	return htole32(w);
+}
+
+static inline uint64_t
+read64(const uint8_t *ptr)
+{
+	uint64_t w;
+
+	memcpy(&w, ptr, sizeof(w));
+	return htole64(w);
+}
+
+static inline uint32_t
+bswap32(uint32_t x)
+{
+
+	return (x >> 24) | ((x >> 8) & 0xff00) |
+	    ((x << 8) & 0xff0000) | (x << 24);
+}
+
+static inline uint64_t
+bswap64(uint64_t x)
+{
+
+	return ((uint64_t)bswap32(x) << 32) | bswap32(x >> 32);
+}
+
+static inline uint64_t
+mul128_fold64(uint64_t a, uint64_t b)
+{
+	uint64_t hi, lo;
+
+	lo = rgph_mul128(a, b, &hi);
+	return lo ^ hi;
+}
+
+static inline uint64_t
+xxh64_avalanche(uint64_t h)
+{
+
+	h ^= h >> 33;
+	h *= RGPH_XXH128V_PRIME64_2;
+	h ^= h >> 29;
+	h *= RGPH_XXH128V_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t
+avalanche(uint64_t h)
+{
+
+	h ^= h >> 37;
+	h *= RGPH_XXH128V_PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline void
+store(uint64_t lo, uint64_t hi, uint32_t *h)
+{
+
+	h[0] = lo;
+	h[1] = lo >> 32;
+	h[2] = hi;
+	h[3] = hi >> 32;
+}
+
+static inline void
+len_1to3(const uint8_t *key, size_t len, uint64_t seed, uint32_t *h)
+{
+	const uint32_t lo = ((uint32_t)key[0] << 16) |
+	    ((uint32_t)key[len >> 1] << 24) | key[len - 1] | (len << 8);
+	const uint32_t hi = rgph_rotl(bswap32(lo), 13);
+	const uint64_t flip_lo =
+	    (read32(secret) ^ read32(secret + 4)) + seed;
+	const uint64_t flip_hi =
+	    (read32(secret + 8) ^ read32(secret + 12)) - seed;
+
+	store(xxh64_avalanche(lo ^ flip_lo),
+	    xxh64_avalanche(hi ^ flip_hi), h);
+}
+
+static inline void
+len_4to8(const uint8_t *key, size_t len, uint64_t seed, uint32_t *h)
+{
+	const uint64_t w = read32(key) + ((uint64_t)read32(key + len - 4) << 32);
+	uint64_t flip, lo, hi;
+
+	seed ^= (uint64_t)bswap32(seed) << 32;
+	flip = (read64(secret + 16) ^ read64(secret + 24)) + seed;
+
+	lo = rgph_mul128(w ^ flip, RGPH_XXH128V_PRIME64_1 + (len << 2), &hi);
+
+	hi += lo << 1;
+	lo ^= hi >> 3;
+
+	lo ^= lo >> 35;
+	lo *= RGPH_XXH128V_PRIME_MX2;
+	lo ^= lo >> 28;
+
+	store(lo, avalanche(hi), h);
+}
+
+static inline void
+len_9to16(const uint8_t *key, size_t len, uint64_t seed, uint32_t *h)
+{
+	const uint64_t flip_lo =
+	    (read64(secret + 32) ^ read64(secret + 40)) - seed;
+	const uint64_t flip_hi =
+	    (read64(secret + 48) ^ read64(secret + 56)) + seed;
+	const uint64_t in_lo = read64(key);
+	uint64_t in_hi = read64(key + len - 8);
+	uint64_t m_lo, m_hi, r_lo, r_hi;
+
+	m_lo = rgph_mul128(in_lo ^ in_hi ^ flip_lo,
+	    RGPH_XXH128V_PRIME64_1, &m_hi);
+
+	m_lo += (uint64_t)(len - 1) << 54;
+	in_hi ^= flip_hi;
+	m_hi += in_hi +
+	    (uint64_t)(uint32_t)in_hi * (RGPH_XXH128V_PRIME32_2 - 1);
+	m_lo ^= bswap64(m_hi);
+
+	r_lo = rgph_mul128(m_lo, RGPH_XXH128V_PRIME64_2, &r_hi);
+	r_hi += m_hi * RGPH_XXH128V_PRIME64_2;
+
+	store(avalanche(r_lo), avalanche(r_hi), h);
+}
+
+static inline uint64_t
+mix16(const uint8_t *key, const uint8_t *s, uint64_t seed)
+{
+
+	return mul128_fold64(read64(key) ^ (read64(s) + seed),
+	    read64(key + 8) ^ (read64(s + 8) - seed));
+}
+
+static inline void
+mix32(uint64_t acc[2], const uint8_t *k1, const uint8_t *k2,
+    const uint8_t *s, uint64_t seed)
+{
+
+	acc[0] += mix16(k1, s, seed);
+	acc[0] ^= read64(k2) + read64(k2 + 8);
+	acc[1] += mix16(k2, s + 16, seed);
+	acc[1] ^= read64(k1) + read64(k1 + 8);
+}
+
+static inline void
+finalise(const uint64_t acc[2], size_t len, uint64_t seed, uint32_t *h)
+{
+	const uint64_t lo = acc[0] + acc[1];
+	const uint64_t hi = acc[0] * RGPH_XXH128V_PRIME64_1 +
+	    acc[1] * RGPH_XXH128V_PRIME64_4 +
+	    (len - seed) * RGPH_XXH128V_PRIME64_2;
+
+	store(avalanche(lo), 0 - avalanche(hi), h);
+}
+
+static inline void
+len_17to128(const uint8_t *key, size_t len, uint64_t seed, uint32_t *h)
+{
+	uint64_t acc[2] = { len * RGPH_XXH128V_PRIME64_1, 0 };
+
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				mix32(acc, key + 48, key + len - 64,
+				    secret + 96, seed);
+			}
+			mix32(acc, key + 32, key + len - 48,
+			    secret + 64, seed);
+		}
+		mix32(acc, key + 16, key + len - 32, secret + 32, seed);
+	}
+	mix32(acc, key, key + len - 16, secret, seed);
+
+	finalise(acc, len, seed, h);
+}
+
+static void
+len_129to240(const uint8_t *key, size_t len, uint64_t seed, uint32_t *h)
+{
+	uint64_t acc[2] = { len * RGPH_XXH128V_PRIME64_1, 0 };
+	const size_t nrounds = len / 32;
+	size_t i;
+
+	for (i = 0; i < 4; i++)
+		mix32(acc, key + 32 * i, key + 32 * i + 16,
+		    secret + 32 * i, seed);
+
+	acc[0] = avalanche(acc[0]);
+	acc[1] = avalanche(acc[1]);
+
+	for (i = 4; i < nrounds; i++)
+		mix32(acc, key + 32 * i, key + 32 * i + 16,
+		    secret + 3 + 32 * (i - 4), seed);
+
+	mix32(acc, key + len - 16, key + len - 32,
+	    secret + SECRET_SIZE_MIN - 17 - 16, 0 - seed);
+
+	finalise(acc, len, seed, h);
+}
+
+static inline void
+accumulate_512(uint64_t acc[8], const uint8_t *key, const uint8_t *s)
+{
+	uint64_t v[8], k[8];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		v[i] = read64(key + 8 * i);
+		k[i] = v[i] ^ read64(s + 8 * i);
+	}
+
+	for (i = 0; i < 8; i++)
+		acc[i] += v[i ^ 1] + (k[i] & UINT32_MAX) * (k[i] >> 32);
+}
+
+static inline void
+scramble(uint64_t acc[8], const uint8_t *s)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		acc[i] ^= acc[i] >> 47;
+		acc[i] ^= read64(s + 8 * i);
+		acc[i] *= RGPH_XXH128V_PRIME32_1;
+	}
+}
+
+static inline uint64_t
+merge(const uint64_t acc[8], const uint8_t *s, uint64_t start)
+{
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		start += mul128_fold64(acc[2 * i] ^ read64(s + 16 * i),
+		    acc[2 * i + 1] ^ read64(s + 16 * i + 8));
+	}
+
+	return avalanche(start);
+}
+
+static void
+len_long(const uint8_t *key, size_t len, uint64_t seed, uint32_t *h)
+{
+	enum { NSTRIPES = (SECRET_SIZE - STRIPE_LEN) / 8 };
+	const size_t block_len = STRIPE_LEN * NSTRIPES;
+	const size_t nblocks = (len - 1) / block_len;
+	uint64_t acc[8] = {
+		RGPH_XXH128V_PRIME32_3, RGPH_XXH128V_PRIME64_1,
+		RGPH_XXH128V_PRIME64_2, RGPH_XXH128V_PRIME64_3,
+		RGPH_XXH128V_PRIME64_4, RGPH_XXH128V_PRIME32_2,
+		RGPH_XXH128V_PRIME64_5, RGPH_XXH128V_PRIME32_1
+	};
+	uint8_t s[SECRET_SIZE];
+	size_t i, j, nstripes;
+
+	/* Derive a secret from the seed. */
+	for (i = 0; i < SECRET_SIZE; i += 16) {
+		uint64_t lo = htole64(read64(secret + i) + seed);
+		uint64_t hi = htole64(read64(secret + i + 8) - seed);
+
+		memcpy(s + i, &lo, sizeof(lo));
+		memcpy(s + i + 8, &hi, sizeof(hi));
+	}
+
+	for (i = 0; i < nblocks; i++) {
+		for (j = 0; j < NSTRIPES; j++) {
+			accumulate_512(acc, key + i * block_len + j * STRIPE_LEN,
+			    s + j * 8);
+		}
+		scramble(acc, s + SECRET_SIZE - STRIPE_LEN);
+	}
+
+	nstripes = (len - 1 - block_len * nblocks) / STRIPE_LEN;
+	for (j = 0; j < nstripes; j++)
+		accumulate_512(acc, key + nblocks * block_len + j * STRIPE_LEN,
+		    s + j * 8);
+	accumulate_512(acc, key + len - STRIPE_LEN,
+	    s + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC_START);
+
+	store(merge(acc, s + SECRET_MERGEACCS_START,
+	    len * RGPH_XXH128V_PRIME64_1),
+	    merge(acc, s + SECRET_SIZE - 64 - SECRET_MERGEACCS_START,
+	    ~(len * RGPH_XXH128V_PRIME64_2)), h);
+}
+
+inline void
+rgph_u32x4_xxh128v_data(const void *data,
+    size_t len, uintptr_t seed, uint32_t *h)
+{
+	const uint8_t *key = data;
+
+	if (len > 16) {
+		if (len <= 128)
+			len_17to128(key, len, seed, h);
+		else if (len <= MID_SIZE_MAX)
+			len_129to240(key, len, seed, h);
+		else
+			len_long(key, len, seed, h);
+	} else if (len > 8) {
+		len_9to16(key, len, seed, h);
+	} else if (len >= 4) {
+		len_4to8(key, len, seed, h);
+	} else if (len > 0) {
+		len_1to3(key, len, seed, h);
+	} else {
+		store(xxh64_avalanche(seed ^
+		    read64(secret + 64) ^ read64(secret + 72)),
+		    xxh64_avalanche(seed ^
+		    read64(secret + 80) ^ read64(secret + 88)), h);
+	}
+}
+
+RGPH_FIXED_VECTOR(rgph_u32x4_xxh128v_data, uint32_t)
@@ -33,12 +33,13 @@
 
 #include "rgph_hash_impl.h"
 #include "rgph_hash.h"
+#include "rgph_cpu.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
 
-uint64_t
+inline uint64_t
 rgph_u64_xxh64s_data(const void *data, size_t len, uintptr_t seed)
 {
 	const uint8_t *key = data;
@@ -112,3 +113,5 @@ rgph_u64_xxh64s_data(const void *data, size_t len, uintptr_t seed)
 
 	return h[0];
 }
+
+RGPH_FIXED_SCALAR(rgph_u64_xxh64s_data, uint64_t)
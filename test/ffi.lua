@@ -0,0 +1,113 @@
+local ffi = require "ffi"
+local rgph = require "rgph_ffi"
+
+local args = { ... }
+local seed = tonumber(args[1] or "123456789")
+
+local function build(g, method, flags, ...)
+	local s = seed
+	while true do
+		local ok, err = g[method](g, flags, s, ...)
+		if ok then return end
+		assert(not err, err)
+		s = s + 1
+	end
+end
+
+local function test_ints(n, flags, ctype)
+	local u32 = ctype == "uint32_t"
+	local keys = ffi.new(ctype .. "[?]", n)
+	local out = ffi.new("uint64_t[?]", n)
+
+	for i = 0, n - 1 do
+		keys[i] = i * 7919 + 13
+	end
+
+	local g = assert(rgph.new_graph(n, flags))
+	build(g, u32 and "build_u32" or "build_u64", flags, keys, n)
+	assert(g:entries() == n)
+	assert(g:assign(flags))
+
+	assert(g[u32 and "lookup_batch_u32" or "lookup_batch_u64"](g,
+	    keys, n, out))
+	for i = 0, n - 1 do
+		assert(out[i] == i)
+		assert(g[u32 and "lookup_u32" or "lookup_u64"](g, keys[i]) == i)
+	end
+
+	local p = assert(g:lookup_params())
+	assert(p.nverts == g:vertices())
+end
+
+local function test_entries(flags)
+	local words = { "abc", "de", "f", "ghij", "klmno", "pq", "rst", "uvwxyz" }
+	local n = #words
+	local entries = ffi.new("struct rgph_entry[?]", n)
+	local ptrs = ffi.new("const void *[?]", n)
+	local lens = ffi.new("size_t[?]", n)
+	local out = ffi.new("uint64_t[?]", n)
+
+	for i = 1, n do
+		entries[i - 1].key = words[i]
+		entries[i - 1].keylen = #words[i]
+		entries[i - 1].index = 100 + i
+		entries[i - 1].has_index = 1
+		ptrs[i - 1] = words[i]
+		lens[i - 1] = #words[i]
+	end
+
+	local g = assert(rgph.new_graph(n, flags))
+	build(g, "build", flags, entries, n)
+	assert(g:assign(flags))
+	assert(g:index_min() == 101 and g:index_max() == 100 + n)
+
+	assert(g:lookup_batch(ptrs, lens, n, out))
+	for i = 1, n do
+		assert(g:lookup(words[i]) == 100 + i)
+		assert(out[i - 1] == 100 + i)
+	end
+end
+
+local function test_steps(n, flags)
+	local words = {}
+	local entries = ffi.new("struct rgph_entry[?]", n)
+
+	for i = 1, n do
+		words[i] = "word " .. i
+		entries[i - 1].key = words[i]
+		entries[i - 1].keylen = #words[i]
+	end
+
+	local g = assert(rgph.new_graph(n, flags))
+
+	for seed = 1, 100 do
+		assert(g:build_begin(flags, seed))
+		local ok, err
+		repeat
+			ok, err = g:build_step(entries, n, 64)
+		until ok ~= nil
+		assert(ok, err)
+		repeat
+			ok, err = g:build_finish(256)
+		until ok ~= nil
+		if ok then break end
+		assert(not err, err)
+	end
+
+	assert(g:assign(flags))
+	for i = 1, n do
+		assert(g:lookup(words[i]) == i - 1)
+	end
+end
+
+test_ints(1000, "chm,rank2", "uint32_t")
+test_ints(1000, "chm,rank3", "uint32_t")
+test_ints(1000, "chm,rank3,xxh64s", "uint64_t")
+test_entries("chm,rank2")
+test_entries("chm,rank3,compact")
+test_steps(1000, "chm,rank3")
+
+assert(not rgph.new_graph(10, "chm,bdz"))
+assert(not pcall(rgph.new_graph, 10, "nosuchflag"))
+local g = rgph.new_graph(10)
+assert(not pcall(g.lookup, g, "key"))
@@ -7,8 +7,8 @@ if not bit32 then bit32 = require "bit" end
 local args = { ... }
 local seed = tonumber(args[1] or "123456789")
 
-local rank2_max = { vec = 0x78787877, s64 = 0x78787877, s32 = 0x00007878 }
-local rank3_max = { vec = 0xccccccca, s64 = 0x00266666, s32 = 0x000004cc }
+local rank2_max = { vec = 0x78787877, s64 = 0x78787877, s32 = 0x00010000 }
+local rank3_max = { vec = 0xccccccca, s64 = 0xccccccca, s32 = 0x00010000 }
 
 local function test_out_of_range(nkeys, flags)
 	local ok, msg = pcall(rgph.new_graph, nkeys, flags)
@@ -34,6 +34,16 @@ test_out_of_range(rank2_max.vec + 1, "jenkins2v,rank2")
 test_out_of_range(rank2_max.vec + 1, "jenkins2v,rank2,mod")
 test_out_of_range(rank2_max.vec + 1, "jenkins2v,rank2,mul")
 
+test_out_of_range(0, "aes128v,rank2")
+test_good_range(rank2_max.vec, "aes128v,rank2,mod", "mod")
+test_good_range(rank2_max.vec, "aes128v,rank2,mul", "mul")
+test_out_of_range(rank2_max.vec + 1, "aes128v,rank2")
+
+test_out_of_range(0, "xxh128v,rank2")
+test_good_range(rank2_max.vec, "xxh128v,rank2,mod", "mod")
+test_good_range(rank2_max.vec, "xxh128v,rank2,mul", "mul")
+test_out_of_range(rank2_max.vec + 1, "xxh128v,rank2")
+
 -- rank2 scalar 64 hash
 test_out_of_range(0, "xxh64s,rank2")
 test_out_of_range(0, "xxh64s,rank2,mod")
@@ -81,6 +91,16 @@ test_out_of_range(rank3_max.vec + 1, "jenkins2v,rank3")
 test_out_of_range(rank3_max.vec + 1, "jenkins2v,rank3,mod")
 test_out_of_range(rank3_max.vec + 1, "jenkins2v,rank3,mul")
 
+test_out_of_range(0, "aes128v,rank3")
+test_good_range(rank3_max.vec, "aes128v,rank3,mod", "mod")
+test_good_range(rank3_max.vec, "aes128v,rank3,mul", "mul")
+test_out_of_range(rank3_max.vec + 1, "aes128v,rank3")
+
+test_out_of_range(0, "xxh128v,rank3")
+test_good_range(rank3_max.vec, "xxh128v,rank3,mod", "mod")
+test_good_range(rank3_max.vec, "xxh128v,rank3,mul", "mul")
+test_out_of_range(rank3_max.vec + 1, "xxh128v,rank3")
+
 -- rank3 scalar 64 hash
 test_out_of_range(0, "xxh64s,rank3")
 test_out_of_range(0, "xxh64s,rank3,mod")
@@ -765,6 +785,62 @@ test_abcz(abcz, seed, "t1ha64s,mul,rank3,sparse")
 test_abcz(abcz, seed, "t1ha64s,mul,chm,rank3,sparse")
 test_abcz(abcz, seed, "t1ha64s,mul,bdz,rank3,sparse")
 
+test_abcz(abcz, seed, "aes128v")
+test_abcz(abcz, seed, "aes128v,chm")
+test_abcz(abcz, seed, "aes128v,bdz")
+test_abcz(abcz, seed, "aes128v,mod")
+test_abcz(abcz, seed, "aes128v,mod,chm")
+test_abcz(abcz, seed, "aes128v,mod,bdz")
+test_abcz(abcz, seed, "aes128v,mul")
+test_abcz(abcz, seed, "aes128v,mul,chm")
+test_abcz(abcz, seed, "aes128v,mul,bdz")
+test_abcz(abcz, seed, "aes128v,rank2")
+test_abcz(abcz, seed, "aes128v,chm,rank2")
+test_abcz(abcz, seed, "aes128v,bdz,rank2")
+test_abcz(abcz, seed, "aes128v,mod,rank2")
+test_abcz(abcz, seed, "aes128v,mod,chm,rank2")
+test_abcz(abcz, seed, "aes128v,mod,bdz,rank2")
+test_abcz(abcz, seed, "aes128v,mul,rank2")
+test_abcz(abcz, seed, "aes128v,mul,chm,rank2")
+test_abcz(abcz, seed, "aes128v,mul,bdz,rank2")
+test_abcz(abcz, seed, "aes128v,rank3")
+test_abcz(abcz, seed, "aes128v,chm,rank3")
+test_abcz(abcz, seed, "aes128v,bdz,rank3")
+test_abcz(abcz, seed, "aes128v,mod,rank3")
+test_abcz(abcz, seed, "aes128v,mod,chm,rank3")
+test_abcz(abcz, seed, "aes128v,mod,bdz,rank3")
+test_abcz(abcz, seed, "aes128v,mul,rank3")
+test_abcz(abcz, seed, "aes128v,mul,chm,rank3")
+test_abcz(abcz, seed, "aes128v,mul,bdz,rank3")
+
+test_abcz(abcz, seed, "xxh128v")
+test_abcz(abcz, seed, "xxh128v,chm")
+test_abcz(abcz, seed, "xxh128v,bdz")
+test_abcz(abcz, seed, "xxh128v,mod")
+test_abcz(abcz, seed, "xxh128v,mod,chm")
+test_abcz(abcz, seed, "xxh128v,mod,bdz")
+test_abcz(abcz, seed, "xxh128v,mul")
+test_abcz(abcz, seed, "xxh128v,mul,chm")
+test_abcz(abcz, seed, "xxh128v,mul,bdz")
+test_abcz(abcz, seed, "xxh128v,rank2")
+test_abcz(abcz, seed, "xxh128v,chm,rank2")
+test_abcz(abcz, seed, "xxh128v,bdz,rank2")
+test_abcz(abcz, seed, "xxh128v,mod,rank2")
+test_abcz(abcz, seed, "xxh128v,mod,chm,rank2")
+test_abcz(abcz, seed, "xxh128v,mod,bdz,rank2")
+test_abcz(abcz, seed, "xxh128v,mul,rank2")
+test_abcz(abcz, seed, "xxh128v,mul,chm,rank2")
+test_abcz(abcz, seed, "xxh128v,mul,bdz,rank2")
+test_abcz(abcz, seed, "xxh128v,rank3")
+test_abcz(abcz, seed, "xxh128v,chm,rank3")
+test_abcz(abcz, seed, "xxh128v,bdz,rank3")
+test_abcz(abcz, seed, "xxh128v,mod,rank3")
+test_abcz(abcz, seed, "xxh128v,mod,chm,rank3")
+test_abcz(abcz, seed, "xxh128v,mod,bdz,rank3")
+test_abcz(abcz, seed, "xxh128v,mul,rank3")
+test_abcz(abcz, seed, "xxh128v,mul,chm,rank3")
+test_abcz(abcz, seed, "xxh128v,mul,bdz,rank3")
+
 
 local function test_build_flags_bad_change(nkeys, flags, build_flags)
 	local seed = 0
@@ -1008,6 +1084,8 @@ local function test_index(keys, seed, flags)
 		assert(assign[v] >= 0 and assign[v] < unassigned)
 	end
 
+	assert(assign["0"] == assign[0]) -- Numeric strings are indices.
+
 	local e = 0
 	for k, _, i in index_iter(keys) do
 		e = e + 1
@@ -1027,6 +1105,20 @@ local function test_index(keys, seed, flags)
 		end
 
 		assert(h == i, "must be order-preserving minimal hash")
+		assert(g:lookup(k) == i)
+		assert(assign:lookup(k) == i)
+	end
+
+	local ks, is = {}, {}
+	for k, _, i in index_iter(keys) do
+		ks[#ks + 1] = k
+		is[#is + 1] = i
+	end
+
+	local res = assign:lookup_many(ks)
+	assert(#res == #ks)
+	for j = 1, #ks do
+		assert(res[j] == is[j])
 	end
 end
 
@@ -1504,3 +1596,189 @@ if has_idiv() then
 	test_index(big63, seed, "chm,rank2,compact")
 	test_index(big63, seed, "chm,rank3,compact")
 end
+
+local function test_peel_stats(keys, seed, flags)
+	local nkeys = rgph.count_keys(pairs(keys))
+	local g = rgph.new_graph(nkeys, flags)
+	local rank = g:rank()
+
+	assert(not g:peel_stats())
+
+	local ok = g:build("instrument", seed, pairs(keys))
+	local stats = assert(g:peel_stats())
+
+	assert(g:flags():find("instrument"))
+
+	local verts, degrees = 0, 0
+	for d = 0, #stats.degree do
+		verts = verts + stats.degree[d]
+		degrees = degrees + d * stats.degree[d]
+	end
+
+	assert(verts == g:vertices())
+	assert(degrees == rank * nkeys) -- No degree overflows the last bin.
+	assert(stats.scan_peeled + stats.cascade_peeled + stats.core_edges
+	    == nkeys)
+	assert(stats.core_edges == g:core_size())
+	assert(ok == (stats.core_edges == 0))
+	assert(ok == (stats.core_verts == 0))
+end
+
+test_peel_stats(abcz, seed, "rank2")
+test_peel_stats(abcz, seed, "rank3")
+
+local function test_build_array(keys, seed, flags)
+	local ks, ds, is = {}, {}, {}
+	for k, i in pairs(keys) do
+		ks[#ks + 1] = k
+		ds[#ds + 1] = "data " .. k
+		is[#is + 1] = i
+	end
+
+	local g = rgph.new_graph(#ks, flags)
+
+	while true do
+		local ok, err = g:build_array(flags, seed, ks, ds, is)
+		if ok then break end
+		assert(not err, err)
+		seed = seed + 1
+	end
+
+	assert(g:datalen_min() == #"data a")
+	assert(g:index_min() == minmax(keys))
+
+	local assign = assert(g:assign(flags))
+
+	for j = 1, #ks do
+		assert(g:lookup(ks[j]) == is[j])
+	end
+end
+
+test_build_array(abcz, seed, "chm,rank2")
+test_build_array(abcz, seed, "chm,rank3")
+test_build_array(zero_to_2p33, seed, "chm,rank3,sparse")
+
+local function test_build_ints(nkeys, seed, flags, width)
+	local keys = {}
+	for j = 1, nkeys do
+		keys[j] = width == 32 and j * 7919 + 13 or j * 2^33 + j
+	end
+
+	local build = width == 32 and "build_u32" or "build_u64"
+	local lookup = width == 32 and "lookup_u32" or "lookup_u64"
+	local g = rgph.new_graph(nkeys, flags)
+
+	while true do
+		local ok, err = g[build](g, flags, seed, keys)
+		if ok then break end
+		assert(not err, err)
+		seed = seed + 1
+	end
+
+	assert(g:keylen() == width / 8)
+
+	local assign = assert(g:assign(flags))
+
+	for j = 1, nkeys do
+		assert(g[lookup](g, keys[j]) == j - 1)
+		assert(assign[lookup](assign, keys[j]) == j - 1)
+	end
+
+	assert(not pcall(g[build], g, flags, seed, { "a", "b" }))
+end
+
+test_build_ints(1000, seed, "chm,rank2", 32)
+test_build_ints(1000, seed, "chm,rank3", 32)
+test_build_ints(1000, seed, "chm,rank2,xxh64s", 64)
+test_build_ints(1000, seed, "chm,rank3,jenkins2v", 64)
+
+local function test_image(keys, seed, flags)
+	local path = os.tmpname()
+	local g = rgph.new_graph(rgph.count_keys(pairs(keys)), flags)
+
+	local ok, err = g:save_image(path)
+	assert(not ok and err == "invalid value")
+
+	while true do
+		local ok, err = g:build(flags, seed, pairs(keys))
+		if ok then break end
+		assert(not err, err)
+		seed = seed + 1
+	end
+
+	assert(g:assign(flags))
+	assert(g:save_image(path))
+
+	local img = assert(rgph.open_image(path))
+	assert(img:entries() == g:entries())
+
+	local ks = {}
+	for k in pairs(keys) do
+		ks[#ks + 1] = k
+	end
+
+	local res = img:lookup_many(ks)
+	for j = 1, #ks do
+		assert(img:lookup(ks[j]) == g:lookup(ks[j]))
+		assert(res[j] == g:lookup(ks[j]))
+		assert(img:lookup_u32(j) == g:lookup_u32(j))
+		assert(img:lookup_u64(j) == g:lookup_u64(j))
+	end
+
+	os.remove(path)
+	assert(not rgph.open_image(path))
+end
+
+test_image(abcz, seed, "chm,rank2")
+test_image(abcz, seed, "bdz,rank3,xxh64s")
+test_image(abcz, seed, "chm,rank3,compact")
+
+local function test_build_step(nkeys, seed, flags)
+	local keys = {}
+	for j = 1, nkeys do
+		keys[j] = "key " .. j
+	end
+
+	local g = rgph.new_graph(nkeys, flags)
+
+	local build = coroutine.wrap(function()
+		while true do
+			assert(g:build_begin(flags, seed))
+
+			local ok, err
+			repeat
+				ok, err = g:build_step(100, keys)
+				coroutine.yield(false)
+			until ok ~= nil
+			assert(ok, err)
+
+			repeat
+				ok, err = g:build_finish(1000)
+				coroutine.yield(false)
+			until ok ~= nil
+			if ok then break end
+			assert(not err, err)
+			seed = seed + 1
+		end
+		return true
+	end)
+
+	local nsteps = 0
+	while not build() do
+		nsteps = nsteps + 1
+	end
+
+	assert(nsteps > nkeys / 100)
+	assert(g:assign(flags))
+
+	for j = 1, nkeys do
+		assert(g:lookup(keys[j]) == j - 1)
+	end
+
+	assert(g:build_begin(flags, seed))
+	local ok, err = g:build_step(0, { "a", "b" })
+	assert(not ok and err == "iterator returned no key")
+end
+
+test_build_step(5000, seed, "chm,rank2")
+test_build_step(5000, seed, "chm,rank3")
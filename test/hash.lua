@@ -0,0 +1,86 @@
+local hash = require "rgph.hash"
+
+-- Compat stuff
+local unpack = unpack or table.unpack
+
+local args = { ... }
+local seed = tonumber(args[1] or "123456789")
+
+local families = {
+	jenkins2v = 3, murmur32v = 4, murmur32s = 1, xxh32s = 1,
+	xxh64s = 2, t1ha64s = 2, aes128v = 4, xxh128v = 4,
+}
+
+-- Little-endian bytes of an integer.
+local function le(n, width)
+	local b = {}
+	for i = 1, width do
+		b[i] = n % 256
+		n = (n - b[i]) / 256
+	end
+	return string.char(unpack(b))
+end
+
+-- Native 32bit words of a packed string.
+local function words(str, n, i)
+	local res = {}
+	for j = 1, n do
+		local off = ((i - 1) * n + j - 1) * 4
+		local b1, b2, b3, b4 = str:byte(off + 1, off + 4)
+		res[j] = b1 + b2 * 0x100 + b3 * 0x10000 + b4 * 0x1000000
+	end
+	return res
+end
+
+local function test_family(name, nwords)
+	assert(select("#", hash[name]("abc", seed)) == nwords)
+
+	for _, w in ipairs { { "u8", 1 }, { "u16", 2 }, { "u32", 4 }, { "u64", 8 } } do
+		local t, width = w[1], w[2]
+		local v = 0x7b
+		local h1 = { hash[name .. "_" .. t](v, seed) }
+		local h2 = { hash[name](le(v, width), seed) }
+		local h3 = { hash[name .. "_" .. t .. "a"](le(v, width), seed) }
+		assert(#h1 == nwords and #h3 == nwords)
+		for j = 1, nwords do
+			assert(h1[j] == h2[j], name .. "_" .. t)
+		end
+	end
+
+	assert(select("#", hash[name .. "_f64"](1.5, seed)) == nwords)
+	assert(not pcall(hash[name .. "_u32a"], "abc", seed))
+
+	for _, w in ipairs { { "u32", 4 }, { "u64", 8 } } do
+		local t, width = w[1], w[2]
+		local keys, packed = {}, {}
+		for i = 1, 100 do
+			keys[i] = i * 7919 + 13
+			packed[i] = le(keys[i], width)
+		end
+		packed = table.concat(packed)
+
+		local batch = hash[name .. "_" .. t .. "_batch"]
+		local out1 = batch(keys, seed)
+		local out2 = batch(packed, seed)
+		assert(out1 == out2)
+		assert(#out1 == 100 * nwords * 4)
+
+		for i = 1, 100 do
+			local h = { hash[name .. "_" .. t](keys[i], seed) }
+			local o = words(out1, nwords, i)
+			for j = 1, nwords do
+				assert(h[j] == o[j], name .. "_" .. t .. "_batch")
+			end
+		end
+
+		assert(batch({}, seed) == "")
+		assert(not pcall(batch, { "a" }, seed))
+		assert(not pcall(batch, "abc", seed))
+	end
+end
+
+for name, nwords in pairs(families) do
+	test_family(name, nwords)
+end
+
+assert(type(hash.kernels()) == "string")
@@ -0,0 +1,120 @@
+require "dynasm" -- to load rgph_jit.dasl
+local ffi = require "ffi"
+local rgph = require "rgph"
+local rgph_jit = require "rgph_jit"
+
+local args = { ... }
+local seed = tonumber(args[1] or "123456789")
+
+local nkeys = 1000
+local nabsent = 100
+
+local hashes = {
+	"jenkins2v", "murmur32v", "murmur32s", "xxh32s",
+	"xxh64s", "t1ha64s", "aes128v", "xxh128v",
+}
+
+-- CHM index modes with the first index and a step between indices.
+local indices = {
+	{ "compact", 5, 1 },
+	{ "sparse", 0, 3 },
+	{ "compact", 2^32, 1 },
+	{ "sparse", 2^32, 3 },
+}
+
+-- Little-endian bytes of a 32bit key.
+local function le32(n)
+	local b = {}
+	for i = 1, 4 do
+		b[i] = n % 256
+		n = (n - b[i]) / 256
+	end
+	return string.char(b[1], b[2], b[3], b[4])
+end
+
+-- Distinct pseudo-random keys, absent keys follow present keys.
+local keys = ffi.new("uint32_t[?]", nkeys + nabsent)
+do
+	local seen, x = {}, seed % 2^32
+	local i = 0
+	while i < nkeys + nabsent do
+		x = (x * 1103515245 + 12345) % 2^32
+		if not seen[x] then
+			seen[x] = true
+			keys[i] = x
+			i = i + 1
+		end
+	end
+end
+
+local function iter(base, step)
+	local i = 0
+	return function()
+		if i == nkeys then return nil end
+		i = i + 1
+		return le32(keys[i - 1]), nil, base + (i - 1) * step
+	end
+end
+
+local function build(flags, base, step)
+	local g = rgph.new_graph(nkeys, flags)
+	local s = seed
+
+	for i = 1, 100 do
+		local ok, err = g:build(flags, s, iter(base, step))
+		if ok then return g end
+		assert(not err, err)
+		s = s + 1
+	end
+end
+
+local function test_jit(flags, base, step)
+	local g = build(flags, base, step)
+
+	-- Only one lane of murmur32v mixes 4 byte keys, rank 3 graphs
+	-- of such keys don't build.
+	if not g and flags:find("murmur32v,rank3") then return end
+	assert(g, flags)
+
+	local lookup, lookup_batch = rgph_jit.compile(g)
+	local out = ffi.new("uint64_t[?]", nkeys + nabsent)
+
+	lookup_batch(keys, nkeys + nabsent, out)
+
+	for i = 0, nkeys + nabsent - 1 do
+		local index = g:lookup(le32(keys[i]))
+		if i < nkeys and flags:find("chm") then
+			assert(index == base + i * step)
+		end
+		assert(lookup(keys[i]) == index, flags)
+		assert(out[i] == index, flags)
+	end
+end
+
+for _, hash in ipairs(hashes) do
+	for _, rank in ipairs { "rank2", "rank3" } do
+		for _, reduction in ipairs { "mod", "mul" } do
+			local flags = table.concat({ hash, rank, reduction }, ",")
+			test_jit(flags .. ",bdz", 0, 1)
+			for _, index in ipairs(indices) do
+				test_jit(flags .. ",chm," .. index[1],
+				    index[2], index[3])
+			end
+		end
+	end
+end
+
+-- Graphs of other keys can't be compiled.
+local u64 = {}
+for i = 1, nkeys do
+	u64[i] = i * 7919 + 13
+end
+
+local g = rgph.new_graph(nkeys)
+local s = seed
+while not g:build_u64("chm", s, u64) do
+	s = s + 1
+end
+
+local ok, err = pcall(rgph_jit.compile, g)
+assert(not ok and err:find("4 byte keys"))
@@ -0,0 +1,208 @@
+#include "t_util.h"
+
+#include <rgph_hash.h>
+#include <string.h>
+
+static const char msg[] =
+	"Richard Of York Gave Battle In Vain.\n"
+	"Ryanair Offers You Great Breaks In Venice.";
+
+/*
+ * Output for msg prefixes. Portable and AES-NI code must agree, run
+ * t_rgph with RGPH_KERNELS=generic to test the former.
+ */
+static const uintptr_t msg_seed = 0xbb8bb8d2;
+static const uint32_t msg_hashes[][4] = {
+	{ 0x5bde1beb, 0xd06dae44, 0xddb476fc, 0x18273d28 }, /* empty string */
+	{ 0xe1949a0f, 0xebf26224, 0xd2538f72, 0xf56c5182 },
+	{ 0xe6cac8f6, 0xa4d30c31, 0x62a64783, 0x1b61b71f },
+	{ 0x7ad5e562, 0x2880d980, 0x345678e6, 0x3511ad3c },
+	{ 0x68a79570, 0x6c97cdb2, 0xe676536b, 0xd273e893 },
+	{ 0x1c8a1cec, 0x955945b4, 0xed7f39c7, 0xfb19eec8 },
+	{ 0x2b23eb27, 0xfe18196b, 0x5fa2f8c3, 0x63513e4b },
+	{ 0xd1e28a9b, 0x2448bbf0, 0xde36812a, 0xbfddb7da },
+	{ 0xd73cfdff, 0xb785dd21, 0x4548b354, 0x7629dc57 },
+	{ 0xc25c65bb, 0x547fb676, 0x274ad2ba, 0xefbe4ee4 },
+	{ 0xe41ab104, 0xff17d9fd, 0x4c7ab850, 0x31928603 },
+	{ 0x06ca073c, 0x8a46b911, 0xa588df71, 0xd48a1343 },
+	{ 0xe841ea41, 0x7bbfbef1, 0xacd36ab8, 0x9c7eb0f4 },
+	{ 0x11226064, 0x2481b7c9, 0x5bdb48c3, 0xa43de8cc },
+	{ 0x29d6172d, 0x025c1411, 0x236d2004, 0xe536bf27 },
+	{ 0xd47ef961, 0xd737a790, 0x7f1de76a, 0xf00ff244 },
+	{ 0x5a4c1686, 0x72c88dfb, 0x2fbe5dd8, 0x4b4da564 },
+	{ 0x1315c55f, 0xd27466a2, 0xa9e5e29b, 0xc76cba3e },
+	{ 0x01023f7a, 0xfce4c5f4, 0x1c1f3da1, 0xbab59fe6 },
+	{ 0x44a0c639, 0x397e6e26, 0x980865fc, 0xb66cb0fe },
+	{ 0xd46cdf3a, 0x8103a67e, 0x0804624b, 0xcadd266b },
+	{ 0xf3dd3edd, 0x096be327, 0xcd4c91e5, 0x6a08d0d4 },
+	{ 0x1d43796f, 0x041088ef, 0x2e08558c, 0x45cc8d5f },
+	{ 0x49cdefe6, 0x0b40f959, 0x62857eb0, 0x245ce17a },
+	{ 0x61a6b8af, 0xdc7f9a13, 0xb305b08a, 0x974c0517 },
+	{ 0x906fa635, 0xf73bc5ab, 0x8d50e477, 0x5f065496 },
+	{ 0xdfe36098, 0x717bd04a, 0x8cfb2f52, 0xcabcbe39 },
+	{ 0x10e9a684, 0xa8bebc09, 0xff0f9d72, 0x0a6726cf },
+	{ 0xe71e39ef, 0x70c99e26, 0x18b12b67, 0x5a773bed },
+	{ 0x3640194e, 0xc0e485a6, 0xe0720814, 0xb596a7af },
+	{ 0x8ebf639b, 0xdbff6145, 0xf2cbb18f, 0xf930cf7c },
+	{ 0xaee377b4, 0xaccb21f4, 0xa07b1eb3, 0xfa63cf62 },
+	{ 0xc584670b, 0x46fb5a63, 0x51bc45c2, 0xdff03550 },
+	{ 0xd4945576, 0x0690c88b, 0xcaaf8b87, 0x6e3d558e },
+	{ 0x8a06f961, 0xfdf410cb, 0x8ae92b69, 0xa1ba7cef },
+	{ 0xcd46bd8e, 0x3a0d61f6, 0xe9dcf5b0, 0x172c38b0 },
+	{ 0x3bd26277, 0x9466cf1e, 0xf6b16fe3, 0xebfe07cb },
+	{ 0xe79e68fc, 0xb19ba641, 0x3a70edcc, 0xd10e9e86 },
+	{ 0xf3d9191e, 0x8c064469, 0xff16ba88, 0xe3a50c26 },
+	{ 0x8076c607, 0x0b055150, 0xf6977ca3, 0xdc45f765 },
+	{ 0xe6e1c689, 0xd4eb5f29, 0xe910d4bb, 0xd6bf702d },
+	{ 0x87ebfa83, 0xb6478482, 0x921b5796, 0xa2cb92dc },
+	{ 0xf78886d2, 0xee936948, 0xad850e1a, 0x8ddb6250 },
+	{ 0x85cb89c5, 0x07334121, 0xd10a1495, 0xa4dd245d },
+	{ 0x1d61297a, 0x26d92683, 0x6c157e75, 0x681897b7 },
+	{ 0xa9dbebad, 0x2c7a5fd7, 0x20957cca, 0xc4e71abe },
+	{ 0x8c42b4ba, 0xe97cf49c, 0x07fc4493, 0x02f12815 },
+	{ 0x519a4f5f, 0x7e573914, 0x34de1ad3, 0xa980c97f },
+	{ 0xe1889250, 0xce6f574d, 0x751a2f02, 0xcb4ee89e },
+	{ 0xee710770, 0x2598b84c, 0x908d0ec0, 0x1a5783f6 },
+	{ 0xb1639698, 0x62e631e3, 0x56e2bfef, 0x387b3a12 },
+	{ 0x8396f1de, 0x3d04177d, 0x7a2166ee, 0xaef219b5 },
+	{ 0x939218db, 0xf0a66ae7, 0x7878ab2c, 0xaba4f6d1 },
+	{ 0xfa69397a, 0x6dc51cfe, 0xd36b8cba, 0x528d9f85 },
+	{ 0xe66df42a, 0x365bd007, 0x4570c74a, 0x33febe03 },
+	{ 0x4a9a542f, 0xa4658f01, 0xd5722526, 0x33a39056 },
+	{ 0xc5a068ee, 0x0ebbaec9, 0xe159630b, 0xb7b2371c },
+	{ 0x742297bc, 0x48805e03, 0xdb49a35c, 0x4a557d17 },
+	{ 0x555f9dc8, 0x472feb7a, 0x0eef1732, 0xe6e5df22 },
+	{ 0x415cb080, 0x61c37c93, 0x7ddfd3e1, 0x79b856ae },
+	{ 0x67c0f0d7, 0xb15af79c, 0xec5790db, 0x91a9844b },
+	{ 0xc9992e57, 0xa1eb5547, 0x35f78877, 0x5b239861 },
+	{ 0x72b86f7a, 0xaa234a46, 0xa4472724, 0x77989326 },
+	{ 0x3c955df9, 0xa1fa9bbd, 0xb4f8c6c3, 0xac3d8bc7 },
+	{ 0x87c592fe, 0x62f9b386, 0x21d4025d, 0x6281ee80 },
+	{ 0x3fc176f6, 0x9326c720, 0xb1073a1d, 0x43a33c4e },
+	{ 0x02ca05a4, 0x39e19307, 0xa10aed5d, 0xdb7e4106 },
+	{ 0x33e34104, 0xb2f0fc3f, 0x1519b5b6, 0x17c87c23 },
+	{ 0xbcd0e945, 0x82d2387e, 0x5df2e106, 0xfef055b1 },
+	{ 0xb8c225e3, 0x9e031165, 0x83b5eeed, 0x2652a212 },
+	{ 0x36f5c87b, 0x4a283dcc, 0x4e8b9964, 0x32483ada },
+	{ 0xb1a0834b, 0xde390842, 0xf9b4be23, 0x12f67db0 },
+	{ 0x2e82410b, 0x48075a27, 0x2798fa77, 0x4b226e51 },
+	{ 0xc13234f0, 0x8d3ae22c, 0xd7e85ced, 0x7cf339ba },
+	{ 0x78d74171, 0xa77b1f7a, 0x16a72115, 0x2bba4f3b },
+	{ 0x327b8861, 0x5dda6b0c, 0x1b022c41, 0xa147bef3 },
+	{ 0x264b1c17, 0xedcb2c74, 0xaada0fe8, 0x49c2c190 },
+	{ 0x9d4a18be, 0x6fff1601, 0xccb226e4, 0xabd9650e },
+	{ 0x17be8c35, 0x9c39e88c, 0x408a672e, 0x2b4e144a },
+	{ 0x9e53cdf9, 0xc4049b16, 0xf0e9e213, 0x1cfd6696 }
+};
+
+static void
+rgph_test_aes128v_data(void)
+{
+	uint32_t h[4];
+	size_t l;
+
+	for (l = 0; l < sizeof(msg); l++) {
+		rgph_u32x4_aes128v_data(msg, l, msg_seed, h);
+		CHECK(memcmp(h, msg_hashes[l], sizeof(h)) == 0);
+	}
+}
+
+static void
+rgph_test_aes128v_types(void)
+{
+	const uint8_t  u8[24]  = { 0x8, 1, 2, 3 };
+	const uint16_t u16[24] = { 0x1661, 1, 2, 3 };
+	const uint32_t u32[24] = { UINT32_C(0x42233223), 1, 2, 3 };
+	const uint64_t u64[24] = { UINT64_C(0x6446644664466446), 1, 2, 3 };
+	const float    f32[24] = { 32e23, 1, 2, 3 };
+	const double   f64[24] = { 64e46, 1, 2, 3 };
+	const uintptr_t seed = 123456789;
+
+	uint32_t h[12];
+	size_t i;
+
+	rgph_u32x4_aes128v_data(u8, sizeof(u8[0]), seed, h);
+	rgph_u32x4_aes128v_u8(u8[0], seed, h + 4);
+	rgph_u32x4_aes128v_u8a(u8, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_aes128v_data(u16, sizeof(u16[0]), seed, h);
+	rgph_u32x4_aes128v_u16(u16[0], seed, h + 4);
+	rgph_u32x4_aes128v_u16a(u16, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_aes128v_data(u32, sizeof(u32[0]), seed, h);
+	rgph_u32x4_aes128v_u32(u32[0], seed, h + 4);
+	rgph_u32x4_aes128v_u32a(u32, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_aes128v_data(u64, sizeof(u64[0]), seed, h);
+	rgph_u32x4_aes128v_u64(u64[0], seed, h + 4);
+	rgph_u32x4_aes128v_u64a(u64, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_aes128v_data(f32, sizeof(f32[0]), seed, h);
+	rgph_u32x4_aes128v_f32(f32[0], seed, h + 4);
+	rgph_u32x4_aes128v_f32a(f32, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_aes128v_data(f64, sizeof(f64[0]), seed, h);
+	rgph_u32x4_aes128v_f64(f64[0], seed, h + 4);
+	rgph_u32x4_aes128v_f64a(f64, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	for (i = 0; i <= 24; i++) {
+		rgph_u32x4_aes128v_data(u16, i * sizeof(u16[0]), seed, h);
+		rgph_u32x4_aes128v_u16a(u16, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_aes128v_data(u32, i * sizeof(u32[0]), seed, h);
+		rgph_u32x4_aes128v_u32a(u32, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_aes128v_data(u64, i * sizeof(u64[0]), seed, h);
+		rgph_u32x4_aes128v_u64a(u64, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_aes128v_data(f32, i * sizeof(f32[0]), seed, h);
+		rgph_u32x4_aes128v_f32a(f32, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_aes128v_data(f64, i * sizeof(f64[0]), seed, h);
+		rgph_u32x4_aes128v_f64a(f64, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+	}
+
+	/* Test data of different lengths with different alignments. */
+	for (i = 0; i < 16; i++) {
+		char *s;
+		size_t l;
+
+		for (l = 0; l <= sizeof(msg); l++) {
+
+			s = malloc(i + (l + i > 0 ? l : 1));
+			REQUIRE(s != NULL);
+			memcpy(s + i, msg, l);
+
+			rgph_u32x4_aes128v_data(msg, l, seed, &h[0]);
+			rgph_u32x4_aes128v_data(s+i, l, seed, &h[4]);
+			CHECK(memcmp(h, h + 4, 16) == 0);
+
+			free(s);
+		}
+	}
+}
+
+void
+rgph_test_aes128v(void)
+{
+
+	rgph_test_aes128v_data();
+	rgph_test_aes128v_types();
+}
@@ -0,0 +1,171 @@
+/*
+ * Check that resumable builds with small budgets produce the same
+ * graphs as rgph_build_graph() and don't lose keys between steps.
+ */
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NKEYS 5000
+
+struct iter_state {
+	struct rgph_entry e;
+	uint64_t base;
+	uint64_t key;
+	size_t i;
+	size_t n;
+};
+
+static const struct rgph_entry *
+iter(void *arg)
+{
+	struct iter_state *s = arg;
+
+	if (s->i == s->n)
+		return NULL;
+
+	s->key = s->i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	s->e.key = &s->key;
+	s->e.keylen = sizeof(s->key);
+	s->e.index = s->base + s->i;
+	s->e.has_index = s->base != 0;
+	s->i++;
+	return &s->e;
+}
+
+static void
+init_state(struct iter_state *s, uint64_t base, size_t n)
+{
+
+	memset(s, 0, sizeof(*s));
+	s->base = base;
+	s->n = n;
+}
+
+static int
+build_steps(struct rgph_graph *g, int flags, unsigned long seed,
+    uint64_t base, size_t maxkeys, size_t maxverts, size_t *nsteps)
+{
+	struct iter_state s;
+	int res;
+
+	init_state(&s, base, NKEYS);
+	*nsteps = 0;
+
+	res = rgph_build_begin(g, flags, NULL, seed);
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	do {
+		res = rgph_build_step(g, &iter, &s, maxkeys, 0);
+		*nsteps += 1;
+		if (rgph_build_position(g) != s.i)
+			return RGPH_NOKEY;
+	} while (res == RGPH_PARTIAL);
+
+	if (res != RGPH_SUCCESS)
+		return res;
+
+	do {
+		res = rgph_build_finish(g, maxverts, 0);
+		*nsteps += 1;
+	} while (res == RGPH_PARTIAL);
+
+	return res;
+}
+
+static void
+test_build_step(int flags, uint64_t base)
+{
+	struct iter_state s;
+	struct rgph_graph *g;
+	uint64_t index, val;
+	unsigned long seed;
+	size_t i, nsteps;
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++) {
+		init_state(&s, base, NKEYS);
+		res = rgph_build_graph(g, flags, NULL, seed, &iter, &s);
+	}
+
+	REQUIRE(res == RGPH_SUCCESS);
+	seed--;
+
+	/* A failed seed must fail in steps too. */
+	if (seed > 0) {
+		CHECK(build_steps(g, flags, seed - 1, base,
+		    17, 333, &nsteps) == RGPH_AGAIN);
+		CHECK(rgph_is_built(g));
+		CHECK(rgph_assign(g, flags) == RGPH_AGAIN);
+	}
+
+	CHECK(build_steps(g, flags, seed, base,
+	    17, 333, &nsteps) == RGPH_SUCCESS);
+	CHECK(nsteps > NKEYS / 17);
+	CHECK(rgph_core_size(g) == 0);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+
+	for (i = 0; i < NKEYS; i++) {
+		init_state(&s, base, NKEYS);
+		s.i = i;
+		iter(&s);
+		REQUIRE(rgph_lookup(g, &s.key, sizeof(s.key), &val) ==
+		    RGPH_SUCCESS);
+		index = base != 0 ? base + i : i;
+		if (flags & RGPH_ALGO_CHM)
+			CHECK(val == index);
+	}
+
+	/* Unlimited budgets finish in one call each. */
+	CHECK(build_steps(g, flags, seed, base, 0, 0, &nsteps) ==
+	    RGPH_SUCCESS);
+	CHECK(nsteps == 2);
+
+	rgph_free_graph(g);
+}
+
+static void
+test_bad_steps(void)
+{
+	struct iter_state s;
+	struct rgph_graph *g;
+	int flags = RGPH_ALGO_CHM | RGPH_RANK3;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	init_state(&s, 0, NKEYS - 1);
+	CHECK(rgph_build_step(g, &iter, &s, 0, 0) == RGPH_INVAL);
+	CHECK(rgph_build_finish(g, 0, 0) == RGPH_INVAL);
+
+	CHECK(rgph_build_begin(g, flags, NULL, 0) == RGPH_SUCCESS);
+	CHECK(rgph_build_finish(g, 0, 0) == RGPH_INVAL);
+	CHECK(rgph_build_step(g, &iter, &s, 100, 0) == RGPH_PARTIAL);
+	CHECK(rgph_build_position(g) == 100);
+	CHECK(rgph_build_step(g, &iter, &s, 0, 0) == RGPH_NOKEY);
+	CHECK(!rgph_is_built(g));
+	CHECK(rgph_assign(g, flags) == RGPH_INVAL);
+
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_build_step(void)
+{
+
+	test_build_step(RGPH_ALGO_CHM | RGPH_RANK2, 0);
+	test_build_step(RGPH_ALGO_CHM | RGPH_RANK3, 0);
+	test_build_step(RGPH_ALGO_BDZ | RGPH_RANK3 | RGPH_HASH_XXH64S, 0);
+	test_build_step(RGPH_ALGO_CHM | RGPH_RANK3 | RGPH_REDUCE_MUL, 7);
+	/* Index switches to 64-bit in the middle of a step. */
+	test_build_step(RGPH_ALGO_CHM | RGPH_RANK3, UINT64_C(0xfffff000));
+	test_bad_steps();
+}
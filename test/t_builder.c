@@ -0,0 +1,168 @@
+/*
+ * Add keys to a graph from several threads with rgph_builder_add()
+ * and check that every key is found at its index.
+ */
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NKEYS    20000
+#define NTHREADS 4
+#define BATCH    100
+#define KEYLEN   40 /* Long enough for data batch hashes. */
+
+struct key {
+	uint8_t bytes[KEYLEN];
+};
+
+struct producer {
+	struct rgph_graph *g;
+	struct key *keys;
+	size_t first;
+	size_t n;
+	int res;
+};
+
+/* Keys i % 3 == 0 are 4 bytes, i % 3 == 1 are 8 bytes long. */
+static size_t
+make_key(struct key *k, size_t i)
+{
+	uint64_t x = i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	size_t j;
+
+	for (j = 0; j < KEYLEN; j++)
+		k->bytes[j] = x >> (j % 8 * 8) ^ j;
+
+	return i % 3 == 0 ? 4 : i % 3 == 1 ? 8 : KEYLEN;
+}
+
+static void *
+produce(void *arg)
+{
+	struct rgph_entry ents[BATCH];
+	struct producer *p = arg;
+	size_t i, j, n;
+
+	p->res = RGPH_SUCCESS;
+	for (i = 0; i < p->n && p->res == RGPH_SUCCESS; i += n) {
+		n = p->n - i < BATCH ? p->n - i : BATCH;
+		memset(ents, 0, sizeof(ents));
+		for (j = 0; j < n; j++) {
+			size_t const k = p->first + i + j;
+
+			ents[j].key = &p->keys[k];
+			ents[j].keylen = make_key(&p->keys[k], k);
+			ents[j].index = 1000 + k;
+			ents[j].has_index = 1;
+		}
+		p->res = rgph_builder_add(p->g, ents, n);
+	}
+
+	return NULL;
+}
+
+static int
+build_threads(struct rgph_graph *g, int flags, unsigned long seed,
+    struct key *keys)
+{
+	struct producer p[NTHREADS];
+	pthread_t t[NTHREADS];
+	size_t i;
+
+	REQUIRE(rgph_builder_begin(g, flags, NULL, seed) == RGPH_SUCCESS);
+
+	for (i = 0; i < NTHREADS; i++) {
+		p[i].g = g;
+		p[i].keys = keys;
+		p[i].first = i * (NKEYS / NTHREADS);
+		p[i].n = i < NTHREADS - 1 ?
+		    NKEYS / NTHREADS : NKEYS - p[i].first;
+		REQUIRE(pthread_create(&t[i], NULL, &produce, &p[i]) == 0);
+	}
+
+	for (i = 0; i < NTHREADS; i++) {
+		REQUIRE(pthread_join(t[i], NULL) == 0);
+		CHECK(p[i].res == RGPH_SUCCESS);
+	}
+
+	return rgph_builder_finish(g, flags);
+}
+
+static void
+test_builder(int flags)
+{
+	static struct key keys[NKEYS];
+	struct rgph_graph *g;
+	unsigned long seed;
+	uint64_t val;
+	size_t i, keylen;
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++)
+		res = build_threads(g, flags, seed, keys);
+
+	REQUIRE(res == RGPH_SUCCESS);
+	CHECK(rgph_is_assigned(g));
+	CHECK(rgph_index_min(g) == 1000);
+	CHECK(rgph_index_max(g) == 1000 + NKEYS - 1);
+
+	for (i = 0; i < NKEYS; i++) {
+		keylen = make_key(&keys[i], i);
+		REQUIRE(rgph_lookup(g, &keys[i], keylen, &val) ==
+		    RGPH_SUCCESS);
+		if (flags & RGPH_ALGO_CHM)
+			CHECK(val == 1000 + i);
+	}
+
+	rgph_free_graph(g);
+}
+
+static void
+test_bad_builder(void)
+{
+	struct rgph_entry ent;
+	struct rgph_graph *g;
+	uint32_t key = 1;
+
+	memset(&ent, 0, sizeof(ent));
+	ent.key = &key;
+	ent.keylen = sizeof(key);
+
+	g = rgph_alloc_graph(2, RGPH_ALGO_CHM);
+	REQUIRE(g != NULL);
+
+	CHECK(rgph_builder_add(g, &ent, 1) == RGPH_INVAL);
+	CHECK(rgph_builder_finish(g, 0) == RGPH_INVAL);
+
+	REQUIRE(rgph_builder_begin(g, RGPH_ALGO_CHM, NULL, 0) ==
+	    RGPH_SUCCESS);
+	CHECK(rgph_build_finish(g, 0, 0) == RGPH_INVAL);
+	CHECK(rgph_builder_add(g, &ent, 1) == RGPH_SUCCESS);
+	CHECK(rgph_builder_finish(g, 0) == RGPH_NOKEY);
+	CHECK(rgph_builder_add(g, &ent, 3) == RGPH_RANGE);
+	CHECK(rgph_builder_add(g, &ent, 1) == RGPH_SUCCESS);
+	CHECK(rgph_builder_add(g, &ent, 1) == RGPH_RANGE);
+	CHECK(rgph_builder_finish(g, 0) == RGPH_RANGE);
+
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_builder(void)
+{
+
+	test_builder(RGPH_ALGO_CHM | RGPH_RANK2);
+	test_builder(RGPH_ALGO_CHM | RGPH_RANK3);
+	test_builder(RGPH_ALGO_CHM | RGPH_RANK3 | RGPH_HASH_XXH64S |
+	    RGPH_REDUCE_MUL);
+	test_builder(RGPH_ALGO_BDZ | RGPH_RANK3 | RGPH_HASH_JENKINS2V);
+	test_bad_builder();
+}
@@ -0,0 +1,128 @@
+/*
+ * Check that runtime selection of hash kernels picked known kernels
+ * and honoured RGPH_KERNELS if the CPU supports them. Run t_rgph with different
+ * RGPH_KERNELS values to test all kernels supported by the CPU.
+ */
+#include "t_util.h"
+
+#include <rgph_hash.h>
+#include <rgph_cpu.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Kernels for fixed length keys must agree with data kernels. */
+static void
+test_fixed_kernels(const struct rgph_kernels *k)
+{
+	static const size_t lens[] = { 4, 8, 12, 16, 20, 32 };
+	uint64_t buf[8];
+	uint32_t h1[4], h2[4];
+	const uint8_t *key;
+	uintptr_t seed;
+	size_t i, j, len, off;
+	const struct rgph_data_kernels *x, *d = k->data;
+
+	for (i = 0; i < sizeof(buf); i++)
+		((uint8_t *)buf)[i] = i * 37 + 11;
+
+	CHECK(rgph_fixed_kernels(k, 0) == NULL);
+	CHECK(rgph_fixed_kernels(k, 5) == NULL);
+	CHECK(rgph_fixed_kernels(k, 64) == NULL);
+
+	for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+		len = lens[i];
+		x = rgph_fixed_kernels(k, len);
+		REQUIRE(x != NULL);
+
+		for (off = 0; off < 8; off++) {
+			key = (const uint8_t *)buf + off;
+			seed = 0x9e3779b9 * (off + 1);
+
+			d->jenkins2v(key, len, seed, h1);
+			x->jenkins2v(key, len, seed, h2);
+			for (j = 0; j < 3; j++)
+				CHECK(h1[j] == h2[j]);
+
+			d->murmur32v(key, len, seed, h1);
+			x->murmur32v(key, len, seed, h2);
+			for (j = 0; j < 4; j++)
+				CHECK(h1[j] == h2[j]);
+
+			d->aes128v(key, len, seed, h1);
+			x->aes128v(key, len, seed, h2);
+			for (j = 0; j < 4; j++)
+				CHECK(h1[j] == h2[j]);
+
+			d->xxh128v(key, len, seed, h1);
+			x->xxh128v(key, len, seed, h2);
+			for (j = 0; j < 4; j++)
+				CHECK(h1[j] == h2[j]);
+
+			CHECK(d->murmur32s(key, len, seed) ==
+			    x->murmur32s(key, len, seed));
+			CHECK(d->xxh32s(key, len, seed) ==
+			    x->xxh32s(key, len, seed));
+			CHECK(d->xxh64s(key, len, seed) ==
+			    x->xxh64s(key, len, seed));
+			CHECK(d->t1ha64s(key, len, seed) ==
+			    x->t1ha64s(key, len, seed));
+		}
+	}
+}
+
+/* Kernels that RGPH_KERNELS=name must select, AES-NI isn't required. */
+static int
+supported(const char *name)
+{
+
+	if (strcmp(name, "generic") == 0)
+		return 1;
+#if defined(RGPH_UNALIGNED_KERNELS)
+	if (strcmp(name, "unaligned") == 0)
+		return 1;
+#endif
+#if defined(RGPH_X86_KERNELS)
+	__builtin_cpu_init();
+	if (strcmp(name, "sse4.2") == 0)
+		return __builtin_cpu_supports("sse4.2");
+	if (strcmp(name, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+	if (strcmp(name, "avx512") == 0) {
+		return __builtin_cpu_supports("avx512f") &&
+		    __builtin_cpu_supports("avx512dq");
+	}
+#endif
+	return 0;
+}
+
+void
+rgph_test_cpu(void)
+{
+	static const char *known[] = {
+		"generic", "unaligned", "sse4.2", "avx2", "avx512", NULL
+	};
+	const char *name = rgph_hash_kernels();
+	const char *env = getenv("RGPH_KERNELS");
+	size_t i;
+
+	REQUIRE(name != NULL);
+
+	for (i = 0; known[i] != NULL; i++) {
+		if (strcmp(name, known[i]) == 0)
+			break;
+	}
+
+	CHECK(known[i] != NULL);
+
+	if (env != NULL && supported(env))
+		CHECK(strcmp(name, env) == 0);
+
+#if defined(RGPH_X86_KERNELS)
+	if (!__builtin_cpu_supports("aes"))
+		CHECK(rgph_kernels()->data != &rgph_data_kernels_aesni);
+#endif
+
+	test_fixed_kernels(rgph_kernels());
+}
@@ -0,0 +1,286 @@
+/*
+ * Insert, delete and look up keys in a dynamic table, rebuild it
+ * manually and from the background thread while other threads read.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <sys/resource.h>
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NKEYS    5000
+#define NREADERS 3
+/* Big enough for malloc to map and unmap it directly. */
+#define BIGKEY   (64u << 20)
+
+struct reader {
+	struct rgph_dynamic *d;
+	pthread_mutex_t *lock;
+	int *stop;
+	int res;
+};
+
+static uint64_t
+make_key(uint64_t i)
+{
+
+	return i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+}
+
+static int
+stopped(struct reader *r)
+{
+	int res;
+
+	pthread_mutex_lock(r->lock);
+	res = *r->stop;
+	pthread_mutex_unlock(r->lock);
+
+	return res;
+}
+
+/* Keys below NKEYS / 2 are never deleted and map to i + 1. */
+static void *
+read_stable(void *arg)
+{
+	struct reader *r = arg;
+	uint64_t i, key, val;
+
+	r->res = 1;
+	while (!stopped(r)) {
+		for (i = 0; i < NKEYS / 2; i++) {
+			key = make_key(i);
+			if (rgph_dynamic_lookup(r->d, &key, sizeof(key),
+			    &val) != RGPH_SUCCESS || val != i + 1) {
+				r->res = 0;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void
+check_keys(struct rgph_dynamic *d, size_t deleted)
+{
+	uint64_t i, key, val;
+	int res;
+
+	for (i = 0; i < NKEYS; i++) {
+		key = make_key(i);
+		res = rgph_dynamic_lookup(d, &key, sizeof(key), &val);
+		if (i >= NKEYS / 2 && i % 2 == 0 && i < deleted) {
+			CHECK(res == RGPH_NOKEY);
+		} else {
+			CHECK(res == RGPH_SUCCESS);
+			CHECK(val == i + 1);
+		}
+	}
+}
+
+static void
+test_dynamic(int flags)
+{
+	struct rgph_dynamic *d;
+	uint64_t i, key, val;
+
+	d = rgph_dynamic_create(flags, 0);
+	REQUIRE(d != NULL);
+
+	key = make_key(0);
+	CHECK(rgph_dynamic_lookup(d, &key, sizeof(key), &val) == RGPH_NOKEY);
+	CHECK(rgph_dynamic_delete(d, &key, sizeof(key)) == RGPH_NOKEY);
+	CHECK(rgph_dynamic_rebuild(d) == RGPH_SUCCESS);
+
+	for (i = 0; i < NKEYS; i++) {
+		key = make_key(i);
+		REQUIRE(rgph_dynamic_insert(d, &key, sizeof(key), 0) ==
+		    RGPH_SUCCESS);
+	}
+
+	CHECK(rgph_dynamic_entries(d) == NKEYS);
+	CHECK(rgph_dynamic_changes(d) == NKEYS);
+	REQUIRE(rgph_dynamic_rebuild(d) == RGPH_SUCCESS);
+	CHECK(rgph_dynamic_changes(d) == 0);
+
+	/* Replace values of static keys. */
+	for (i = 0; i < NKEYS; i++) {
+		key = make_key(i);
+		REQUIRE(rgph_dynamic_insert(d, &key, sizeof(key), i + 1) ==
+		    RGPH_SUCCESS);
+	}
+
+	CHECK(rgph_dynamic_entries(d) == NKEYS);
+	check_keys(d, 0);
+	REQUIRE(rgph_dynamic_rebuild(d) == RGPH_SUCCESS);
+	check_keys(d, 0);
+
+	for (i = NKEYS / 2; i < NKEYS; i += 2) {
+		key = make_key(i);
+		CHECK(rgph_dynamic_delete(d, &key, sizeof(key)) ==
+		    RGPH_SUCCESS);
+		CHECK(rgph_dynamic_delete(d, &key, sizeof(key)) ==
+		    RGPH_NOKEY);
+	}
+
+	CHECK(rgph_dynamic_entries(d) == NKEYS - NKEYS / 4);
+	CHECK(rgph_dynamic_changes(d) == NKEYS / 4);
+	check_keys(d, NKEYS);
+	REQUIRE(rgph_dynamic_rebuild(d) == RGPH_SUCCESS);
+	CHECK(rgph_dynamic_changes(d) == 0);
+	check_keys(d, NKEYS);
+
+	rgph_dynamic_destroy(d);
+}
+
+static void
+test_background(int flags)
+{
+	struct timespec const pause = { 0, 1000000 };
+	struct reader r[NREADERS];
+	pthread_t t[NREADERS];
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct rgph_dynamic *d;
+	int stop = 0;
+	uint64_t i, key;
+	int n;
+
+	d = rgph_dynamic_create(flags, NKEYS / 10);
+	REQUIRE(d != NULL);
+
+	for (i = 0; i < NKEYS / 2; i++) {
+		key = make_key(i);
+		REQUIRE(rgph_dynamic_insert(d, &key, sizeof(key), i + 1) ==
+		    RGPH_SUCCESS);
+	}
+
+	for (i = 0; i < NREADERS; i++) {
+		r[i].d = d;
+		r[i].lock = &lock;
+		r[i].stop = &stop;
+		REQUIRE(pthread_create(&t[i], NULL, &read_stable, &r[i]) == 0);
+	}
+
+	for (i = NKEYS / 2; i < NKEYS; i++) {
+		key = make_key(i);
+		REQUIRE(rgph_dynamic_insert(d, &key, sizeof(key), i + 1) ==
+		    RGPH_SUCCESS);
+	}
+
+	for (i = NKEYS / 2; i < NKEYS; i += 2) {
+		key = make_key(i);
+		CHECK(rgph_dynamic_delete(d, &key, sizeof(key)) ==
+		    RGPH_SUCCESS);
+	}
+
+	/* The background thread should catch up eventually. */
+	for (n = 0; n < 10000; n++) {
+		if (rgph_dynamic_changes(d) < NKEYS / 10)
+			break;
+		nanosleep(&pause, NULL);
+	}
+
+	CHECK(rgph_dynamic_changes(d) < NKEYS / 10);
+
+	pthread_mutex_lock(&lock);
+	stop = 1;
+	pthread_mutex_unlock(&lock);
+
+	for (i = 0; i < NREADERS; i++) {
+		REQUIRE(pthread_join(t[i], NULL) == 0);
+		CHECK(r[i].res);
+	}
+
+	CHECK(rgph_dynamic_entries(d) == NKEYS - NKEYS / 4);
+	check_keys(d, NKEYS);
+	rgph_dynamic_destroy(d);
+}
+
+/* Current size of the address space or 0 if it's not known. */
+static size_t
+vm_size(void)
+{
+	unsigned long pages;
+	FILE *f;
+	int n;
+
+	f = fopen("/proc/self/statm", "r");
+	if (f == NULL)
+		return 0;
+
+	n = fscanf(f, "%lu", &pages);
+	fclose(f);
+
+	return n == 1 ? pages * sysconf(_SC_PAGESIZE) : 0;
+}
+
+/*
+ * Replace a static key when the overflow table can't allocate a copy
+ * of it. The number of entries shouldn't change.
+ */
+static void
+test_nomem(void)
+{
+	struct rgph_dynamic *d;
+	struct rlimit old, lim;
+	uint64_t val;
+	size_t vm;
+	char *key;
+	int res;
+
+	key = malloc(BIGKEY);
+	REQUIRE(key != NULL);
+	memset(key, 'k', BIGKEY);
+
+	d = rgph_dynamic_create(RGPH_RANK2, 0);
+	REQUIRE(d != NULL);
+
+	REQUIRE(rgph_dynamic_insert(d, key, BIGKEY, 1) == RGPH_SUCCESS);
+	REQUIRE(rgph_dynamic_rebuild(d) == RGPH_SUCCESS);
+	CHECK(rgph_dynamic_entries(d) == 1);
+
+	vm = vm_size();
+	if (vm == 0 || getrlimit(RLIMIT_AS, &old) != 0)
+		goto out;
+
+	lim = old;
+	lim.rlim_cur = vm + BIGKEY / 4;
+	if (old.rlim_cur != RLIM_INFINITY && old.rlim_cur < lim.rlim_cur)
+		goto out;
+	if (setrlimit(RLIMIT_AS, &lim) != 0)
+		goto out;
+
+	res = rgph_dynamic_insert(d, key, BIGKEY, 2);
+	REQUIRE(setrlimit(RLIMIT_AS, &old) == 0);
+
+	CHECK(res == RGPH_NOMEM);
+	CHECK(rgph_dynamic_entries(d) == 1);
+	CHECK(rgph_dynamic_lookup(d, key, BIGKEY, &val) == RGPH_SUCCESS);
+	CHECK(val == 1);
+out:
+	rgph_dynamic_destroy(d);
+	free(key);
+}
+
+void
+rgph_test_dynamic(void)
+{
+
+	CHECK(rgph_dynamic_create(RGPH_RANK_MASK, 0) == NULL);
+	CHECK(rgph_dynamic_create(RGPH_HASH_CUSTOM, 0) == NULL);
+	test_dynamic(RGPH_RANK2);
+	test_dynamic(RGPH_RANK3 | RGPH_HASH_XXH64S);
+	test_background(RGPH_RANK3);
+	test_nomem();
+}
@@ -0,0 +1,182 @@
+/*
+ * Publish new graphs with rgph_handle_publish() while other threads
+ * look keys up through the handle.
+ */
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NKEYS    2000
+#define NREADERS 4
+#define NGRAPHS  50
+
+struct reader {
+	struct rgph_handle *h;
+	pthread_mutex_t *lock;
+	int *stop;
+	size_t nlookups;
+	int res;
+};
+
+static uint64_t keys[NKEYS];
+
+static struct rgph_graph *
+build(int flags, unsigned long *seed)
+{
+	struct rgph_graph *g;
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	while (res == RGPH_AGAIN) {
+		res = rgph_build_graph_u64(g, flags, NULL, (*seed)++,
+		    keys, NKEYS);
+	}
+
+	REQUIRE(res == RGPH_SUCCESS);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+	return g;
+}
+
+static int
+stopped(struct reader *r)
+{
+	int res;
+
+	pthread_mutex_lock(r->lock);
+	res = *r->stop;
+	pthread_mutex_unlock(r->lock);
+
+	return res;
+}
+
+static void *
+read_keys(void *arg)
+{
+	struct reader *r = arg;
+	const struct rgph_graph *g;
+	unsigned token;
+	uint64_t val;
+	size_t i;
+
+	r->res = 1;
+	r->nlookups = 0;
+	while (!stopped(r)) {
+		for (i = 0; i < NKEYS; i++) {
+			g = rgph_handle_enter(r->h, &token);
+			if (rgph_lookup_u64(g, keys[i], &val) !=
+			    RGPH_SUCCESS || val >= rgph_vertices(g)) {
+				r->res = 0;
+			}
+			if ((rgph_flags(g) & RGPH_ALGO_CHM) && val != i)
+				r->res = 0;
+			rgph_handle_leave(r->h, token);
+		}
+		r->nlookups += NKEYS;
+	}
+
+	return NULL;
+}
+
+static void
+test_publish(int flags)
+{
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct reader r[NREADERS];
+	pthread_t t[NREADERS];
+	struct rgph_handle *h;
+	unsigned long seed = 0;
+	uint64_t val;
+	size_t i;
+	int stop = 0;
+
+	for (i = 0; i < NKEYS; i++)
+		keys[i] = i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+
+	h = rgph_handle_create(build(flags, &seed));
+	REQUIRE(h != NULL);
+
+	for (i = 0; i < NREADERS; i++) {
+		r[i].h = h;
+		r[i].lock = &lock;
+		r[i].stop = &stop;
+		REQUIRE(pthread_create(&t[i], NULL, &read_keys, &r[i]) == 0);
+	}
+
+	/* Each graph has a different seed, readers of a stale one fail. */
+	for (i = 0; i < NGRAPHS; i++)
+		CHECK(rgph_handle_publish(h, build(flags, &seed)) ==
+		    RGPH_SUCCESS);
+
+	pthread_mutex_lock(&lock);
+	stop = 1;
+	pthread_mutex_unlock(&lock);
+
+	for (i = 0; i < NREADERS; i++) {
+		REQUIRE(pthread_join(t[i], NULL) == 0);
+		CHECK(r[i].res);
+		CHECK(r[i].nlookups > 0);
+	}
+
+	CHECK(rgph_handle_lookup(h, &keys[1], sizeof(keys[1]), &val) ==
+	    RGPH_SUCCESS);
+
+	CHECK(rgph_handle_publish(h, NULL) == RGPH_SUCCESS);
+	CHECK(rgph_handle_lookup(h, &keys[1], sizeof(keys[1]), &val) ==
+	    RGPH_NOKEY);
+
+	rgph_handle_destroy(h);
+}
+
+static void
+test_bad_handle(void)
+{
+	struct rgph_graph *g;
+	struct rgph_handle *h;
+	unsigned long seed;
+	uint64_t val;
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(2, RGPH_ALGO_CHM);
+	REQUIRE(g != NULL);
+
+	errno = 0;
+	CHECK(rgph_handle_create(g) == NULL);
+	CHECK(errno == EINVAL);
+
+	h = rgph_handle_create(NULL);
+	REQUIRE(h != NULL);
+	CHECK(rgph_handle_publish(h, g) == RGPH_INVAL);
+	CHECK(rgph_handle_lookup(h, &val, sizeof(val), &val) == RGPH_NOKEY);
+
+	/* Built but not assigned. */
+	keys[0] = 1;
+	keys[1] = 2;
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++) {
+		res = rgph_build_graph_u64(g, RGPH_ALGO_CHM, NULL, seed,
+		    keys, 2);
+	}
+	REQUIRE(res == RGPH_SUCCESS);
+	errno = 0;
+	CHECK(rgph_handle_create(g) == NULL);
+	CHECK(errno == EINVAL);
+	CHECK(rgph_handle_publish(h, g) == RGPH_INVAL);
+
+	rgph_handle_destroy(h);
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_handle(void)
+{
+
+	test_publish(RGPH_ALGO_CHM | RGPH_RANK3);
+	test_publish(RGPH_ALGO_BDZ | RGPH_RANK2 | RGPH_HASH_XXH64S);
+	test_bad_handle();
+}
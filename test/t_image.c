@@ -0,0 +1,192 @@
+/*
+ * Save images of assigned graphs, map them and compare lookups
+ * with rgph_lookup().
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NKEYS 1000
+
+static void
+test_image(int flags, const char *path)
+{
+	const struct rgph_lookup_params *p;
+	struct rgph_image *img;
+	struct rgph_graph *g;
+	uint64_t keys[NKEYS], key, index, val;
+	unsigned long seed;
+	size_t i;
+	int res = RGPH_AGAIN;
+
+	for (i = 0; i < NKEYS; i++)
+		keys[i] = i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	CHECK(rgph_save_image(g, path) == RGPH_INVAL);
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++)
+		res = rgph_build_graph_u64(g, flags, NULL, seed, keys, NKEYS);
+
+	REQUIRE(res == RGPH_SUCCESS);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+	REQUIRE(rgph_save_image(g, path) == RGPH_SUCCESS);
+
+	img = rgph_open_image(path);
+	REQUIRE(img != NULL);
+
+	p = rgph_image_params(img);
+	CHECK(rgph_image_entries(img) == NKEYS);
+	CHECK(p->nverts == rgph_vertices(g));
+	CHECK(p->flags == rgph_flags(g));
+
+	for (i = 0; i < 2 * NKEYS; i++) {
+		key = i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+		REQUIRE(rgph_lookup_u64(g, key, &index) == RGPH_SUCCESS);
+		CHECK(rgph_image_lookup(img, &key, sizeof(key), &val) ==
+		    RGPH_SUCCESS);
+		CHECK(val == index);
+		if ((flags & RGPH_ALGO_CHM) && i < NKEYS)
+			CHECK(val == i);
+	}
+
+	rgph_close_image(img);
+	rgph_free_graph(g);
+}
+
+static void
+test_bad_image(const char *path)
+{
+	FILE *f;
+
+	errno = 0;
+	CHECK(rgph_open_image("/nonexistent/rgph.img") == NULL);
+	CHECK(errno == ENOENT);
+
+	f = fopen(path, "w");
+	REQUIRE(f != NULL);
+	fputs("not an image", f);
+	fclose(f);
+
+	errno = 0;
+	CHECK(rgph_open_image(path) == NULL);
+	CHECK(errno == EINVAL);
+}
+
+/* Offsets in struct image_header in image.c. */
+#define IMAGE_FASTDIV_MUL    68
+#define IMAGE_FASTDIV_S2     72
+#define IMAGE_LEMIRE_SHIFT   73
+#define IMAGE_PARTITION_BITS 74
+#define IMAGE_WIDTH          75
+#define IMAGE_FLAGS          80
+
+/* Xor a field of size 1 or 4 with mask in place. */
+static void
+patch_image(const char *path, long off, size_t size, uint32_t mask)
+{
+	uint32_t u32;
+	uint8_t u8;
+	FILE *f;
+
+	f = fopen(path, "r+b");
+	REQUIRE(f != NULL);
+	REQUIRE(fseek(f, off, SEEK_SET) == 0);
+	if (size == 1) {
+		REQUIRE(fread(&u8, 1, 1, f) == 1);
+		u8 ^= mask;
+	} else {
+		REQUIRE(fread(&u32, sizeof(u32), 1, f) == 1);
+		u32 ^= mask;
+	}
+	REQUIRE(fseek(f, off, SEEK_SET) == 0);
+	REQUIRE(fwrite(size == 1 ? (void *)&u8 : (void *)&u32,
+	    size, 1, f) == 1);
+	REQUIRE(fclose(f) == 0);
+}
+
+static void
+test_corrupt_image(const char *path)
+{
+	static const struct {
+		long off;
+		size_t size;
+		uint32_t mask;
+	} patches[] = {
+		{ IMAGE_FASTDIV_MUL, 4, 1 },
+		{ IMAGE_FASTDIV_S2, 1, 1 },
+		{ IMAGE_LEMIRE_SHIFT, 1, 32 },
+		{ IMAGE_PARTITION_BITS, 1, 1 },
+		{ IMAGE_WIDTH, 1, 4 ^ 1 },  /* CHM with 1-byte width. */
+		{ IMAGE_FLAGS, 4, RGPH_ALGO_BDZ },
+		{ IMAGE_FLAGS, 4, RGPH_REDUCE_MUL },  /* MOD and MUL. */
+		{ IMAGE_FLAGS, 4, RGPH_RANK_MASK },
+		{ IMAGE_FLAGS, 4, RGPH_INSTRUMENT << 1 }
+	};
+	const int flags = RGPH_ALGO_CHM | RGPH_RANK3 | RGPH_INDEX_COMPACT;
+	struct rgph_image *img;
+	struct rgph_graph *g;
+	uint64_t keys[NKEYS];
+	unsigned long seed;
+	size_t i;
+	int res = RGPH_AGAIN;
+
+	for (i = 0; i < NKEYS; i++)
+		keys[i] = i;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++)
+		res = rgph_build_graph_u64(g, flags, NULL, seed, keys, NKEYS);
+
+	REQUIRE(res == RGPH_SUCCESS);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+	REQUIRE(rgph_save_image(g, path) == RGPH_SUCCESS);
+
+	for (i = 0; i < sizeof(patches) / sizeof(patches[0]); i++) {
+		patch_image(path, patches[i].off, patches[i].size,
+		    patches[i].mask);
+		errno = 0;
+		CHECK(rgph_open_image(path) == NULL);
+		CHECK(errno == EINVAL);
+		patch_image(path, patches[i].off, patches[i].size,
+		    patches[i].mask);
+	}
+
+	img = rgph_open_image(path);
+	CHECK(img != NULL);
+	rgph_close_image(img);
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_image(void)
+{
+	char path[] = "/tmp/t_image.XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	REQUIRE(fd != -1);
+	close(fd);
+
+	test_image(RGPH_ALGO_BDZ | RGPH_RANK3 | RGPH_HASH_XXH64S, path);
+	test_image(RGPH_ALGO_CHM | RGPH_RANK2 | RGPH_HASH_JENKINS2V, path);
+	test_image(RGPH_ALGO_CHM | RGPH_RANK3 | RGPH_REDUCE_MUL |
+	    RGPH_INDEX_COMPACT, path);
+	test_bad_image(path);
+	test_corrupt_image(path);
+
+	unlink(path);
+}
@@ -0,0 +1,136 @@
+/*
+ * Build graphs from arrays of integers and check that rgph_lookup_u32(),
+ * rgph_lookup_u64() and their batch variants agree with rgph_lookup()
+ * on little-endian bytes of keys for vector and scalar hashes.
+ */
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NKEYS 1000
+
+static uint32_t keys32[2 * NKEYS];
+static uint64_t keys64[2 * NKEYS];
+static uint64_t out[2 * NKEYS];
+
+static void
+make_keys(void)
+{
+	uint64_t k;
+	size_t i;
+
+	for (i = 0; i < 2 * NKEYS; i++) {
+		k = i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+		keys32[i] = k >> 32;
+		keys64[i] = k;
+	}
+}
+
+static size_t
+le_bytes(uint64_t key, size_t width, uint8_t *buf)
+{
+	size_t i;
+
+	for (i = 0; i < width; i++)
+		buf[i] = key >> (8 * i);
+	return width;
+}
+
+static int
+build(struct rgph_graph *g, int flags, unsigned long seed, size_t width,
+    size_t nkeys)
+{
+
+	return width == sizeof(uint32_t)
+	    ? rgph_build_graph_u32(g, flags, NULL, seed, keys32, nkeys)
+	    : rgph_build_graph_u64(g, flags, NULL, seed, keys64, nkeys);
+}
+
+static void
+test_ints(int flags, size_t width)
+{
+	struct rgph_graph *g;
+	uint8_t buf[sizeof(uint64_t)];
+	uint64_t index, val;
+	unsigned long seed;
+	size_t i, len;
+	int built, res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++)
+		res = build(g, flags, seed, width, NKEYS);
+
+	REQUIRE(res == RGPH_SUCCESS);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+
+	/* Wrong counts don't change flags of the built graph. */
+	built = rgph_flags(g);
+	CHECK(build(g, RGPH_HASH_XXH128V, seed, width, NKEYS - 1) ==
+	    RGPH_INVAL);
+	CHECK(build(g, RGPH_HASH_XXH128V, seed, width, NKEYS + 1) ==
+	    RGPH_INVAL);
+	CHECK(rgph_flags(g) == built);
+
+	if (width == sizeof(uint32_t)) {
+		REQUIRE(rgph_lookup_batch_u32(g, keys32, 2 * NKEYS, out) ==
+		    RGPH_SUCCESS);
+	} else {
+		REQUIRE(rgph_lookup_batch_u64(g, keys64, 2 * NKEYS, out) ==
+		    RGPH_SUCCESS);
+	}
+
+	for (i = 0; i < 2 * NKEYS; i++) {
+		if (width == sizeof(uint32_t)) {
+			len = le_bytes(keys32[i], width, buf);
+			REQUIRE(rgph_lookup_u32(g, keys32[i], &val) ==
+			    RGPH_SUCCESS);
+		} else {
+			len = le_bytes(keys64[i], width, buf);
+			REQUIRE(rgph_lookup_u64(g, keys64[i], &val) ==
+			    RGPH_SUCCESS);
+		}
+
+		REQUIRE(rgph_lookup(g, buf, len, &index) == RGPH_SUCCESS);
+		CHECK(val == index);
+		CHECK(out[i] == index);
+		if ((flags & RGPH_ALGO_CHM) && i < NKEYS)
+			CHECK(index == i);
+	}
+
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_ints(void)
+{
+	static const int hashes[] = {
+		RGPH_HASH_JENKINS2V, RGPH_HASH_MURMUR32V, RGPH_HASH_MURMUR32S,
+		RGPH_HASH_XXH32S, RGPH_HASH_XXH64S, RGPH_HASH_T1HA64S,
+		RGPH_HASH_AES128V, RGPH_HASH_XXH128V
+	};
+	static const int algos[] = { RGPH_ALGO_BDZ, RGPH_ALGO_CHM };
+	static const int ranks[] = { RGPH_RANK2, RGPH_RANK3 };
+	size_t i;
+	int flags;
+
+	make_keys();
+
+	for (i = 0; i < 8 * 2 * 2; i++) {
+		flags = hashes[i % 8] | algos[i / 8 % 2] | ranks[i / 16] |
+		    RGPH_REDUCE_MOD | RGPH_INDEX_COMPACT;
+		/*
+		 * Only one lane of murmur32v mixes keys up to 4 bytes long,
+		 * rank 3 graphs of such keys don't build.
+		 */
+		if ((flags & RGPH_HASH_MASK) != RGPH_HASH_MURMUR32V ||
+		    (flags & RGPH_RANK3) == 0) {
+			test_ints(flags, sizeof(uint32_t));
+		}
+		test_ints(flags, sizeof(uint64_t));
+	}
+}
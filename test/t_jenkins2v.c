@@ -8,6 +8,81 @@ static const char msg[] =
 	"Richard Of York Gave Battle In Vain.\n"
 	"Ryanair Offers You Great Breaks In Venice.";
 
+static void
+rgph_test_jenkins2_batch(void)
+{
+	enum { NKEYS = 37 }; /* Not a multiple of any lane count. */
+	const uintptr_t seed = 123456789;
+
+	uint32_t u32[NKEYS];
+	uint64_t u64[NKEYS];
+	uint32_t out[3 * (NKEYS + 1)], h[3];
+	size_t i, n;
+
+	for (i = 0; i < NKEYS; i++) {
+		u64[i] = UINT64_C(0x9e3779b97f4a7c15) * (i + 1);
+		u32[i] = u64[i] >> 17;
+	}
+
+	for (n = 0; n <= NKEYS; n++) {
+		memset(out, 0xa5, sizeof(out));
+		rgph_u32x3_jenkins2v_u32_batch(u32, n, seed, out);
+		for (i = 0; i < n; i++) {
+			rgph_u32x3_jenkins2v_data(&u32[i], sizeof(u32[0]), seed, h);
+			CHECK(memcmp(&out[3*i], h, sizeof(h)) == 0);
+		}
+		CHECK(out[3*n] == (uint32_t)UINT64_C(0xa5a5a5a5a5a5a5a5));
+
+		memset(out, 0xa5, sizeof(out));
+		rgph_u32x3_jenkins2v_u64_batch(u64, n, seed, out);
+		for (i = 0; i < n; i++) {
+			rgph_u32x3_jenkins2v_data(&u64[i], sizeof(u64[0]), seed, h);
+			CHECK(memcmp(&out[3*i], h, sizeof(h)) == 0);
+		}
+		CHECK(out[3*n] == (uint32_t)UINT64_C(0xa5a5a5a5a5a5a5a5));
+	}
+}
+
+static void
+rgph_test_jenkins2_data_batch(void)
+{
+	enum { NKEYS = 23 }; /* Groups of four and a tail. */
+	const uintptr_t seed = 123456789;
+
+	const void *keys[NKEYS];
+	size_t lens[NKEYS];
+	uint32_t out[3 * (NKEYS + 1)], h[3];
+	size_t i, n;
+
+	/* Misaligned keys of 0 to 66 bytes, short keys in some groups. */
+	for (i = 0; i < NKEYS; i++) {
+		keys[i] = &msg[i % 11];
+		lens[i] = (i * 29) % 67;
+	}
+
+	for (n = 0; n <= NKEYS; n++) {
+		memset(out, 0xa5, sizeof(out));
+		rgph_u32x3_jenkins2v_data_batch(keys, lens, n, seed, out);
+		for (i = 0; i < n; i++) {
+			rgph_u32x3_jenkins2v_data(keys[i], lens[i], seed, h);
+			CHECK(memcmp(&out[3*i], h, sizeof(h)) == 0);
+		}
+		CHECK(out[3*n] == (uint32_t)UINT64_C(0xa5a5a5a5a5a5a5a5));
+	}
+
+	/* Long keys of equal and similar lengths. */
+	for (i = 0; i < NKEYS; i++) {
+		keys[i] = &msg[i % 5];
+		lens[i] = sizeof(msg) - 6 - i % 3;
+	}
+
+	rgph_u32x3_jenkins2v_data_batch(keys, lens, NKEYS, seed, out);
+	for (i = 0; i < NKEYS; i++) {
+		rgph_u32x3_jenkins2v_data(keys[i], lens[i], seed, h);
+		CHECK(memcmp(&out[3*i], h, sizeof(h)) == 0);
+	}
+}
+
 void
 rgph_test_jenkins2(void)
 {
@@ -217,4 +292,7 @@ rgph_test_jenkins2(void)
 			free(s);
 		}
 	}
+
+	rgph_test_jenkins2_batch();
+	rgph_test_jenkins2_data_batch();
 }
@@ -0,0 +1,120 @@
+/*
+ * Check that rgph_inline_lookup() with parameters exported by
+ * rgph_get_lookup_params() agrees with rgph_lookup() for every
+ * hash, rank, algorithm, reduction and index mode.
+ */
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NKEYS 1000
+
+struct iter_state {
+	struct rgph_entry e;
+	uint64_t base;
+	uint64_t key;
+	size_t i;
+};
+
+static const struct rgph_entry *
+iter(void *arg)
+{
+	struct iter_state *s = arg;
+
+	if (s->i == NKEYS)
+		return NULL;
+
+	s->key = s->i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	s->e.key = &s->key;
+	s->e.keylen = sizeof(s->key);
+	s->e.index = s->base + 3 * s->i;
+	s->e.has_index = 1;
+	s->i++;
+	return &s->e;
+}
+
+static void
+custom_hash(const void *key, size_t keylen, uintptr_t seed, uint32_t *h)
+{
+
+	rgph_u32x4_xxh128v_data(key, keylen, seed ^ 0x5eed, h);
+}
+
+static void
+test_lookup(int flags, uint64_t base)
+{
+	struct iter_state s;
+	struct rgph_lookup_params p;
+	struct rgph_graph *g;
+	rgph_vector_hash_t hash;
+	uint64_t index;
+	uint64_t key;
+	unsigned long seed;
+	size_t i;
+	int res = RGPH_AGAIN;
+
+	hash = (flags & RGPH_HASH_MASK) == RGPH_HASH_CUSTOM ? &custom_hash : NULL;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	CHECK(rgph_get_lookup_params(g, &p) == RGPH_INVAL);
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++) {
+		memset(&s, 0, sizeof(s));
+		s.base = base;
+		res = rgph_build_graph(g, flags, hash, seed, &iter, &s);
+	}
+
+	REQUIRE(res == RGPH_SUCCESS);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+	REQUIRE(rgph_get_lookup_params(g, &p) == RGPH_SUCCESS);
+
+	CHECK(p.nverts == rgph_vertices(g));
+	CHECK(p.rank == rgph_rank(g));
+	CHECK(p.seed == rgph_seed(g));
+	CHECK(p.assignments == rgph_assignments(g, NULL));
+
+	for (i = 0; i < 2 * NKEYS; i++) {
+		key = i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+		REQUIRE(rgph_lookup(g, &key, sizeof(key), &index) == 0);
+		CHECK(rgph_inline_lookup(&p, &key, sizeof(key)) == index);
+		if ((flags & RGPH_ALGO_CHM) && i < NKEYS)
+			CHECK(index == base + 3 * i);
+	}
+
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_lookup(void)
+{
+	static const int hashes[] = {
+		RGPH_HASH_JENKINS2V, RGPH_HASH_MURMUR32V, RGPH_HASH_MURMUR32S,
+		RGPH_HASH_XXH32S, RGPH_HASH_XXH64S, RGPH_HASH_T1HA64S,
+		RGPH_HASH_AES128V, RGPH_HASH_XXH128V, RGPH_HASH_CUSTOM
+	};
+	static const int modes[] = {
+		RGPH_ALGO_BDZ,
+		RGPH_ALGO_CHM,
+		RGPH_ALGO_CHM | RGPH_INDEX_COMPACT,
+		RGPH_ALGO_CHM | RGPH_INDEX_SPARSE
+	};
+	static const uint64_t bases[] = { 0, 3000000000u, UINT64_C(1) << 40 };
+	static const int ranks[] = { RGPH_RANK2, RGPH_RANK3 };
+	static const int reductions[] = { RGPH_REDUCE_MOD, RGPH_REDUCE_MUL };
+	size_t i, nbases;
+	int flags;
+
+	for (i = 0; i < 9 * 4 * 2 * 2; i++) {
+		flags = hashes[i % 9] | modes[i / 9 % 4] |
+		    ranks[i / 36 % 2] | reductions[i / 72];
+		nbases = (flags & RGPH_ALGO_BDZ) ? 1 : 3;
+		while (nbases-- > 0)
+			test_lookup(flags, bases[nbases]);
+	}
+}
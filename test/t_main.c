@@ -11,6 +11,17 @@ int main()
 	rgph_test_xxh32s();
 	rgph_test_xxh64s();
 	rgph_test_t1ha64s();
+	rgph_test_aes128v();
+	rgph_test_xxh128v();
 	rgph_test_fastdiv();
+	rgph_test_cpu();
+	rgph_test_lookup();
+	rgph_test_image();
+	rgph_test_build_step();
+	rgph_test_builder();
+	rgph_test_dynamic();
+	rgph_test_handle();
+	rgph_test_stats();
+	rgph_test_ints();
 	return exit_status;
 }
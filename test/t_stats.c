@@ -0,0 +1,167 @@
+/*
+ * Check counters and timers returned by rgph_get_stats() and
+ * rgph_get_peel_stats().
+ */
+#include "t_util.h"
+
+#include <rgph.h>
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NKEYS 1000
+
+struct iter_state {
+	struct rgph_entry e;
+	uint64_t key;
+	size_t i;
+	int sparse;
+};
+
+/*
+ * Indices aren't implicit and indices of the second half of keys
+ * don't fit into 32 bits.
+ */
+static const struct rgph_entry *
+iter(void *arg)
+{
+	struct iter_state *s = arg;
+
+	if (s->i == NKEYS)
+		return NULL;
+
+	memset(&s->e, 0, sizeof(s->e));
+	s->key = s->i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+	s->e.key = &s->key;
+	s->e.keylen = sizeof(s->key);
+	if (s->sparse) {
+		s->e.index = 3 * s->i;
+		if (s->i >= NKEYS / 2)
+			s->e.index += UINT64_C(1) << 40;
+		s->e.has_index = 1;
+	}
+	s->i++;
+	return &s->e;
+}
+
+static void
+test_stats(int flags, int sparse)
+{
+	struct rgph_stats stats;
+	struct iter_state state;
+	struct rgph_graph *g;
+	unsigned long seed;
+	size_t allocated, dup;
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	rgph_get_stats(g, &stats);
+	CHECK(stats.nkeys == 0);
+	CHECK(stats.nbuilds == 0);
+	CHECK(stats.index_reallocs == 0);
+	CHECK(stats.hash_ns == 0);
+	CHECK(stats.assign_ns == 0);
+	CHECK(stats.allocated >= NKEYS * sizeof(uint32_t));
+	allocated = stats.allocated;
+
+	for (seed = 0; seed < 100 && res == RGPH_AGAIN; seed++) {
+		memset(&state, 0, sizeof(state));
+		state.sparse = sparse;
+		res = rgph_build_graph(g, flags, NULL, seed, &iter, &state);
+	}
+
+	REQUIRE(res == RGPH_SUCCESS);
+
+	rgph_get_stats(g, &stats);
+	CHECK(stats.nbuilds == seed);
+	CHECK(stats.nkeys == NKEYS * stats.nbuilds);
+	CHECK(stats.hash_ns > 0);
+	CHECK(stats.add_edge_ns > 0);
+	CHECK(stats.peel_ns > 0);
+	if (sparse) {
+		/* From no index to 32-bit to 64-bit indices. */
+		CHECK(stats.index_reallocs == 2);
+		CHECK(stats.allocated ==
+		    allocated + NKEYS * sizeof(uint64_t));
+	} else {
+		CHECK(stats.index_reallocs == 0);
+		CHECK(stats.allocated == allocated);
+	}
+	allocated = stats.allocated;
+
+	memset(&state, 0, sizeof(state));
+	state.sparse = sparse;
+	/* No duplicates in a peeled graph. */
+	CHECK(rgph_find_duplicates(g, &iter, &state, &dup) == RGPH_NOKEY);
+	REQUIRE(rgph_assign(g, flags) == RGPH_SUCCESS);
+
+	rgph_get_stats(g, &stats);
+	CHECK(stats.duplicates_ns > 0);
+	CHECK(stats.peel_index_ns > 0);
+	CHECK(stats.assign_ns > 0);
+	CHECK(stats.allocated >= allocated);
+
+	rgph_free_graph(g);
+}
+
+static void
+test_peel_stats(int flags)
+{
+	struct rgph_peel_stats ps;
+	struct iter_state state;
+	struct rgph_graph *g;
+	size_t d, verts, degrees;
+	int res;
+
+	errno = 0;
+	CHECK(rgph_alloc_graph(NKEYS, flags | RGPH_INSTRUMENT) == NULL);
+	CHECK(errno == EINVAL);
+
+	g = rgph_alloc_graph(NKEYS, flags);
+	REQUIRE(g != NULL);
+
+	CHECK(rgph_get_peel_stats(g, &ps) == RGPH_INVAL);
+
+	memset(&state, 0, sizeof(state));
+	res = rgph_build_graph(g, flags | RGPH_INSTRUMENT, NULL, 0,
+	    &iter, &state);
+	REQUIRE(res == RGPH_SUCCESS || res == RGPH_AGAIN);
+	CHECK(rgph_flags(g) & RGPH_INSTRUMENT);
+	REQUIRE(rgph_get_peel_stats(g, &ps) == RGPH_SUCCESS);
+
+	verts = degrees = 0;
+	for (d = 0; d < RGPH_DEGREE_BINS; d++) {
+		verts += ps.degree[d];
+		degrees += d * ps.degree[d];
+	}
+
+	CHECK(verts == rgph_vertices(g));
+	CHECK(degrees == (size_t)rgph_rank(g) * NKEYS); /* No overflows. */
+	CHECK(ps.scan_peeled + ps.cascade_peeled + ps.core_edges == NKEYS);
+	CHECK(ps.core_edges == rgph_core_size(g));
+	CHECK((res == RGPH_SUCCESS) == (ps.core_verts == 0));
+
+	/* The flag doesn't stick to later builds. */
+	memset(&state, 0, sizeof(state));
+	res = rgph_build_graph(g, flags, NULL, 1, &iter, &state);
+	REQUIRE(res == RGPH_SUCCESS || res == RGPH_AGAIN);
+	CHECK(!(rgph_flags(g) & RGPH_INSTRUMENT));
+	CHECK(rgph_get_peel_stats(g, &ps) == RGPH_INVAL);
+
+	rgph_free_graph(g);
+}
+
+void
+rgph_test_stats(void)
+{
+
+	test_stats(RGPH_ALGO_CHM | RGPH_RANK3, 0);
+	test_stats(RGPH_ALGO_CHM | RGPH_RANK3 | RGPH_INDEX_SPARSE, 1);
+	test_stats(RGPH_ALGO_BDZ | RGPH_RANK2, 0);
+	test_peel_stats(RGPH_RANK2);
+	test_peel_stats(RGPH_RANK3);
+}
@@ -25,6 +25,17 @@ void rgph_test_murmur32s(void);
 void rgph_test_xxh32s(void);
 void rgph_test_xxh64s(void);
 void rgph_test_t1ha64s(void);
+void rgph_test_aes128v(void);
+void rgph_test_xxh128v(void);
 void rgph_test_fastdiv(void);
+void rgph_test_cpu(void);
+void rgph_test_lookup(void);
+void rgph_test_image(void);
+void rgph_test_build_step(void);
+void rgph_test_builder(void);
+void rgph_test_dynamic(void);
+void rgph_test_handle(void);
+void rgph_test_stats(void);
+void rgph_test_ints(void);
 
 #endif /* #ifndef RGPH_TEST_UTIL_H_INCLUDED */
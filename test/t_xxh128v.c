@@ -0,0 +1,230 @@
+#include "t_util.h"
+
+#include <rgph_hash.h>
+#include <string.h>
+
+static const char msg[] =
+	"Richard Of York Gave Battle In Vain.\n"
+	"Ryanair Offers You Great Breaks In Venice.";
+
+/* XXH3_128bits_withSeed() output for msg prefixes, low word first. */
+static const uintptr_t msg_seed = 0xbb8bb8d2;
+static const uint32_t msg_hashes[][4] = {
+	{ 0xc1eb9601, 0x2ef5bd3d, 0x7c76021f, 0x64904df2 }, /* empty string */
+	{ 0xe9f14271, 0x2229f6bc, 0x3b39da96, 0x3426e214 },
+	{ 0x34fd1ee5, 0x0147f1c7, 0xd2b5282d, 0xf5c23807 },
+	{ 0x9f2b14f0, 0x542076be, 0xaaca39e9, 0x64652ac3 },
+	{ 0xaea26f1e, 0xfc24de18, 0xd44b07ae, 0x8966b4df },
+	{ 0x4cb4e6df, 0xa4673c1c, 0x72a5ff6f, 0x32149329 },
+	{ 0xbeb8b1d5, 0xcd45bb3e, 0x00320dce, 0xcab856c4 },
+	{ 0x333a6510, 0x9ac67c58, 0xabf8f99f, 0xe74473ba },
+	{ 0xdf6379c7, 0x2262e9e3, 0xb67103b0, 0x904353c2 },
+	{ 0xc90b9f51, 0x90295ffc, 0x7f62e5bf, 0x2b6e1c8b },
+	{ 0xdb94d697, 0xf1a0fb72, 0xb8e2091f, 0x699e9cb2 },
+	{ 0xda796fdd, 0x01ad33da, 0xc27a5c5b, 0xcbc15f1f },
+	{ 0x3cddd8e5, 0x5fc94661, 0xd53d03f1, 0xe01bc479 },
+	{ 0x107680f4, 0x91835c60, 0xb61307e4, 0x1ad7b808 },
+	{ 0xf77ccfa8, 0x7cc46728, 0x17036976, 0x49d80057 },
+	{ 0x2714f9fe, 0x24937e16, 0x6ea5aff1, 0x05bab270 },
+	{ 0x2e98372e, 0x2eb16dbd, 0xecb7e411, 0x622393c2 },
+	{ 0x3287986d, 0x4950e9f2, 0xb5f85bf1, 0xeebb398b },
+	{ 0x58d5837c, 0x1f84e0a6, 0x4a8147b7, 0xc312aaec },
+	{ 0x5bf3072b, 0xc50f8bf6, 0x753bf952, 0x4895b780 },
+	{ 0xb7a4209d, 0x9f6b21db, 0x267d41a3, 0x8234a3cd },
+	{ 0x21b30e87, 0x73dd728a, 0xafd1a040, 0xdd66fa24 },
+	{ 0xdb03b553, 0xbc59dd35, 0xc77ef706, 0x0e5a57cd },
+	{ 0x4b5cf4b4, 0xf8115edf, 0x93b4edac, 0x90522ec2 },
+	{ 0x6146d589, 0x0339bf59, 0x358c9bbb, 0x3080d1c4 },
+	{ 0x4305ecfc, 0x3cf67b4b, 0x276b4fa5, 0xce4e15e3 },
+	{ 0xb6b026fe, 0x425c94a8, 0xce0c94ca, 0x443c63ca },
+	{ 0x5117afe2, 0xba731141, 0x73fcd520, 0x6517c8ec },
+	{ 0x3c497893, 0xec90c69f, 0x354b182d, 0xdb13907b },
+	{ 0x0184ee92, 0x8f81dd74, 0x32fdd8d2, 0xc23db4b6 },
+	{ 0x2abef49d, 0x7428179c, 0x1c213c57, 0x8b4ceafc },
+	{ 0x3214a2a2, 0xd1bccc42, 0x13e75f97, 0x3da9f1d3 },
+	{ 0x0582d48d, 0xb1ac64d1, 0xb0fc4cf5, 0xcdb7b4c7 },
+	{ 0x66fd04fb, 0xfd0a1a7c, 0x0e33b374, 0x7d687945 },
+	{ 0xbb2628b3, 0x5f4cb2bf, 0xf43d99a9, 0x092fe254 },
+	{ 0xf262ff65, 0xf760a688, 0x0afcc494, 0x63e22aae },
+	{ 0x21979857, 0xfaf00512, 0xac730a5b, 0xa83c1480 },
+	{ 0x0da350a8, 0x70748b9c, 0x78cb57c8, 0xcb409a55 },
+	{ 0xd8eec3d3, 0x4513525f, 0xbfa91d0f, 0x89517a0f },
+	{ 0x9a924636, 0x3ee80518, 0xc14acb66, 0xf2491e0c },
+	{ 0xf4f492f5, 0xe3888e49, 0x876399cb, 0xddf6c0fc },
+	{ 0xcafe2071, 0x7222c0d4, 0x02ac6d40, 0x7f8760ed },
+	{ 0x35027341, 0x958fa388, 0xb1d2f822, 0x94ca1614 },
+	{ 0x85b84f80, 0x62638e52, 0x2ee0ade3, 0x275db9bf },
+	{ 0x9876ceec, 0x9a3f6e15, 0xce7eceda, 0xa34d9954 },
+	{ 0xa9f502e8, 0xc644702e, 0xadb6ba95, 0x6bb84b13 },
+	{ 0x55881438, 0xa821c2dd, 0x1c6d88cc, 0x198c54bc },
+	{ 0x4c3a439a, 0xd85c1e58, 0x292f3909, 0x25aef567 },
+	{ 0x7918e786, 0x534b5dc1, 0x8a43d22a, 0x02da39d4 },
+	{ 0x32a327a1, 0x79ff4a2c, 0x890c2f24, 0xe6ddeec1 },
+	{ 0x4a969a7d, 0x3e538df1, 0x544ff469, 0x0e7ca86f },
+	{ 0x5420d383, 0xcfd6c762, 0xc4da9c34, 0x505eec3a },
+	{ 0xf11559c2, 0xc2d5eb2f, 0x919199fa, 0xeeeb0cb1 },
+	{ 0x50e0471d, 0xa6f05eb7, 0x973d9d4b, 0x093a1730 },
+	{ 0x61fd8409, 0xb70c5e95, 0xbaab57cf, 0x9effc75a },
+	{ 0x208ecbe0, 0x4d4bac4a, 0xba4f49a5, 0x24554679 },
+	{ 0xb6ed041a, 0x3e887699, 0x3e0fdd30, 0x84cf216b },
+	{ 0xb61b8c1d, 0xbd47efd0, 0x729c34ce, 0x8c30b965 },
+	{ 0xabe8fb70, 0x6ad12a76, 0x3555c9d2, 0x0a45bc9b },
+	{ 0xa5e82aef, 0xce65f56b, 0xe9a55653, 0x4c7616fb },
+	{ 0x6b2f4ada, 0xd4c38c79, 0x535130ea, 0x0fbeaeb7 },
+	{ 0x68c71a43, 0xb2fe385f, 0x76211955, 0x0251c934 },
+	{ 0x549cc082, 0x6bb94b00, 0x591d640a, 0x5633d2ba },
+	{ 0xcc34f8ff, 0xb1740745, 0x28fae69d, 0x9ebb2e13 },
+	{ 0x98003cfd, 0xe0b2d4e4, 0x8997675c, 0xef1c238d },
+	{ 0x1ddd7312, 0x6c9df709, 0xd7037374, 0xd6973daa },
+	{ 0x35485f75, 0x0934aa82, 0x16749d28, 0xc3ed06ef },
+	{ 0xe5e86a4f, 0x7030b096, 0x809e0dcb, 0x6fc33f98 },
+	{ 0x4c060c74, 0xf5313a44, 0xbe4df6e4, 0x160ce2d7 },
+	{ 0xa560b113, 0x7064a053, 0xe35f314a, 0x669e2677 },
+	{ 0xbca90d55, 0x9369a9e7, 0x18c7db8b, 0x3d3a7fe0 },
+	{ 0xf59fd795, 0x9e91e680, 0xe5ff4848, 0xf541c425 },
+	{ 0x77b8eb5c, 0xff73c98d, 0x6690c440, 0x44e15b2a },
+	{ 0x42bdca78, 0x500b7df4, 0x0918ab43, 0x8dd08c0d },
+	{ 0xf9b2574a, 0x92d65d17, 0x42b041d8, 0x07f1695c },
+	{ 0xc62a59c2, 0xd45d6d01, 0xc71d4db4, 0xf0aa67ce },
+	{ 0xac05ac34, 0x05f6bac0, 0xcc6316f3, 0x77b0229a },
+	{ 0x2b3ea74a, 0x9b890c09, 0xf3c7cc98, 0xad1d2c31 },
+	{ 0x246ba32d, 0x5050c40e, 0x3decded1, 0x34175fe0 },
+	{ 0x89b9321e, 0x78414de5, 0x3ea5247a, 0x88e99958 }
+};
+
+/* Same for long keys, every byte is i * 7 + (i >> 8). */
+static const struct {
+	size_t len;
+	uint32_t h[4];
+} long_hashes[] = {
+	{  129, { 0xa3ed689d, 0x57b35f7e, 0xe26ab402, 0x9c4b7662 } },
+	{  200, { 0x665a6ecf, 0xfc55a3c7, 0x176de19e, 0x68e33982 } },
+	{  240, { 0x355f3582, 0x0e80e1b6, 0x2d68fd4e, 0x21a5af1e } },
+	{  241, { 0x6246c932, 0x8802cb11, 0xc678f605, 0x0ee35677 } },
+	{  256, { 0x4b9968c7, 0x026510b0, 0x76d88acd, 0x3327f90c } },
+	{ 1024, { 0x146b1f8d, 0x1376d5be, 0xc81ffa23, 0x9adc9108 } },
+	{ 1025, { 0x56836d51, 0x687389a0, 0x1540ef00, 0xfdc71d48 } },
+	{ 2048, { 0xa0d7f67d, 0xf6a2b715, 0x40e0bc60, 0x64a2a917 } },
+	{ 4096, { 0xb74692be, 0x7316e6f1, 0x4b06c0ac, 0xe82061f5 } }
+};
+
+static void
+rgph_test_xxh128v_data(void)
+{
+	uint8_t buf[4096];
+	uint32_t h[4];
+	size_t i, l;
+
+	for (l = 0; l < sizeof(msg); l++) {
+		rgph_u32x4_xxh128v_data(msg, l, msg_seed, h);
+		CHECK(memcmp(h, msg_hashes[l], sizeof(h)) == 0);
+	}
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	for (i = 0; i < sizeof(long_hashes) / sizeof(long_hashes[0]); i++) {
+		rgph_u32x4_xxh128v_data(buf, long_hashes[i].len, msg_seed, h);
+		CHECK(memcmp(h, long_hashes[i].h, sizeof(h)) == 0);
+	}
+}
+
+static void
+rgph_test_xxh128v_types(void)
+{
+	const uint8_t  u8[24]  = { 0x8, 1, 2, 3 };
+	const uint16_t u16[24] = { 0x1661, 1, 2, 3 };
+	const uint32_t u32[24] = { UINT32_C(0x42233223), 1, 2, 3 };
+	const uint64_t u64[24] = { UINT64_C(0x6446644664466446), 1, 2, 3 };
+	const float    f32[24] = { 32e23, 1, 2, 3 };
+	const double   f64[24] = { 64e46, 1, 2, 3 };
+	const uintptr_t seed = 123456789;
+
+	uint32_t h[12];
+	size_t i;
+
+	rgph_u32x4_xxh128v_data(u8, sizeof(u8[0]), seed, h);
+	rgph_u32x4_xxh128v_u8(u8[0], seed, h + 4);
+	rgph_u32x4_xxh128v_u8a(u8, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_xxh128v_data(u16, sizeof(u16[0]), seed, h);
+	rgph_u32x4_xxh128v_u16(u16[0], seed, h + 4);
+	rgph_u32x4_xxh128v_u16a(u16, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_xxh128v_data(u32, sizeof(u32[0]), seed, h);
+	rgph_u32x4_xxh128v_u32(u32[0], seed, h + 4);
+	rgph_u32x4_xxh128v_u32a(u32, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_xxh128v_data(u64, sizeof(u64[0]), seed, h);
+	rgph_u32x4_xxh128v_u64(u64[0], seed, h + 4);
+	rgph_u32x4_xxh128v_u64a(u64, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_xxh128v_data(f32, sizeof(f32[0]), seed, h);
+	rgph_u32x4_xxh128v_f32(f32[0], seed, h + 4);
+	rgph_u32x4_xxh128v_f32a(f32, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	rgph_u32x4_xxh128v_data(f64, sizeof(f64[0]), seed, h);
+	rgph_u32x4_xxh128v_f64(f64[0], seed, h + 4);
+	rgph_u32x4_xxh128v_f64a(f64, 1, seed, h + 8);
+	CHECK(memcmp(h, h + 4, 16) == 0);
+	CHECK(memcmp(h, h + 8, 16) == 0);
+
+	for (i = 0; i <= 24; i++) {
+		rgph_u32x4_xxh128v_data(u16, i * sizeof(u16[0]), seed, h);
+		rgph_u32x4_xxh128v_u16a(u16, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_xxh128v_data(u32, i * sizeof(u32[0]), seed, h);
+		rgph_u32x4_xxh128v_u32a(u32, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_xxh128v_data(u64, i * sizeof(u64[0]), seed, h);
+		rgph_u32x4_xxh128v_u64a(u64, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_xxh128v_data(f32, i * sizeof(f32[0]), seed, h);
+		rgph_u32x4_xxh128v_f32a(f32, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+
+		rgph_u32x4_xxh128v_data(f64, i * sizeof(f64[0]), seed, h);
+		rgph_u32x4_xxh128v_f64a(f64, i, seed, h + 4);
+		CHECK(memcmp(h, h + 4, 16) == 0);
+	}
+
+	/* Test data of different lengths with different alignments. */
+	for (i = 0; i < 8; i++) {
+		char *s;
+		size_t l;
+
+		for (l = 0; l <= sizeof(msg); l++) {
+
+			s = malloc(i + (l + i > 0 ? l : 1));
+			REQUIRE(s != NULL);
+			memcpy(s + i, msg, l);
+
+			rgph_u32x4_xxh128v_data(msg, l, seed, &h[0]);
+			rgph_u32x4_xxh128v_data(s+i, l, seed, &h[4]);
+			CHECK(memcmp(h, h + 4, 16) == 0);
+
+			free(s);
+		}
+	}
+}
+
+void
+rgph_test_xxh128v(void)
+{
+
+	rgph_test_xxh128v_data();
+	rgph_test_xxh128v_types();
+}
@@ -3355,10 +3355,46 @@ rgph_test_xxh32s_types(void)
 	}
 }
 
+static void
+rgph_test_xxh32s_batch(void)
+{
+	enum { NKEYS = 37 }; /* Not a multiple of any lane count. */
+	const uintptr_t seed = 123456789;
+
+	uint32_t u32[NKEYS];
+	uint64_t u64[NKEYS];
+	uint32_t out[NKEYS + 1], h;
+	size_t i, n;
+
+	for (i = 0; i < NKEYS; i++) {
+		u64[i] = UINT64_C(0x9e3779b97f4a7c15) * (i + 1);
+		u32[i] = u64[i] >> 17;
+	}
+
+	for (n = 0; n <= NKEYS; n++) {
+		memset(out, 0xa5, sizeof(out));
+		rgph_u32_xxh32s_u32_batch(u32, n, seed, out);
+		for (i = 0; i < n; i++) {
+			h = rgph_u32_xxh32s_data(&u32[i], sizeof(u32[0]), seed);
+			CHECK(out[i] == h);
+		}
+		CHECK(out[n] == (uint32_t)UINT64_C(0xa5a5a5a5a5a5a5a5));
+
+		memset(out, 0xa5, sizeof(out));
+		rgph_u32_xxh32s_u64_batch(u64, n, seed, out);
+		for (i = 0; i < n; i++) {
+			h = rgph_u32_xxh32s_data(&u64[i], sizeof(u64[0]), seed);
+			CHECK(out[i] == h);
+		}
+		CHECK(out[n] == (uint32_t)UINT64_C(0xa5a5a5a5a5a5a5a5));
+	}
+}
+
 void
 rgph_test_xxh32s(void)
 {
 
 	rgph_test_xxh32s_data();
 	rgph_test_xxh32s_types();
+	rgph_test_xxh32s_batch();
 }
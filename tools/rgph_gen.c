@@ -0,0 +1,827 @@
+/*-
+ * Copyright (c) 2017 Alexander Nasonov.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Generate C source of a perfect hash function for a set of keys.
+ *
+ * Like nbperf(1), rgph_gen reads keys, one per line, builds a graph
+ * and writes two files. The header has an inline hash and lookup
+ * function with all constants of the graph as literals, the source
+ * file has an assignment table as const data. The generated code
+ * doesn't depend on the library and returns the same values as
+ * rgph_lookup().
+ *
+ * Only built-in scalar hashes are supported because their vertices
+ * are derived from a single hash value with a few lines of code.
+ */
+
+#include <assert.h>
+#include <err.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rgph.h>
+
+struct key {
+	const void *key;
+	size_t keylen;
+};
+
+struct keyset {
+	struct key *keys;
+	size_t nkeys;
+};
+
+struct iterator_state {
+	struct keyset const *ks;
+	size_t pos;
+	struct rgph_entry entry;
+};
+
+struct name {
+	const char *name;
+	int flag;
+};
+
+/* Graph parameters used by the generated code. */
+struct params {
+	const char *name;
+	const char *upper; /* Upper case name for macros. */
+	int flags;
+	int rank;
+	uint32_t seed;
+	size_t nkeys;
+	size_t nverts;
+	uint32_t partsz;
+	uint32_t mul;  /* RGPH_REDUCE_MOD only. */
+	uint8_t s2;    /* RGPH_REDUCE_MOD only. */
+	uint64_t mod;  /* CHM only. */
+};
+
+static const struct name hashes[] = {
+	{ "xxh32s", RGPH_HASH_XXH32S },
+	{ "xxh64s", RGPH_HASH_XXH64S },
+	{ NULL, 0 }
+};
+
+static const struct name ranks[] = {
+	{ "2", RGPH_RANK2 },
+	{ "3", RGPH_RANK3 },
+	{ NULL, 0 }
+};
+
+static const struct name algos[] = {
+	{ "chm", RGPH_ALGO_CHM },
+	{ "bdz", RGPH_ALGO_BDZ },
+	{ NULL, 0 }
+};
+
+static const struct name reductions[] = {
+	{ "mod", RGPH_REDUCE_MOD },
+	{ "mul", RGPH_REDUCE_MUL },
+	{ NULL, 0 }
+};
+
+/*
+ * Read helpers and hash functions of the generated header. Every @
+ * is replaced with the function name before the template is passed
+ * to vfprintf(3). Reads are little-endian like in the library.
+ */
+static const char read_tmpl[] =
+"static inline uint32_t\n"
+"@_read32(const uint8_t *p)\n"
+"{\n"
+"\n"
+"\treturn (uint32_t)p[0] | (uint32_t)p[1] << 8 |\n"
+"\t    (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;\n"
+"}\n"
+"\n"
+"static inline uint64_t\n"
+"@_read64(const uint8_t *p)\n"
+"{\n"
+"\n"
+"\treturn @_read32(p) | (uint64_t)@_read32(p + 4) << 32;\n"
+"}\n"
+"\n";
+
+/* rgph_u32_xxh32s_data() with a literal seed. */
+static const char xxh32s_tmpl[] =
+"static inline uint32_t\n"
+"@_rotl32(uint32_t x, int l)\n"
+"{\n"
+"\n"
+"\treturn x << l | x >> (32 - l);\n"
+"}\n"
+"\n"
+"static inline uint64_t\n"
+"@_hash(const uint8_t *key, size_t len)\n"
+"{\n"
+"\tconst uint8_t *end = key + len;\n"
+"\tconst uint32_t seed = UINT32_C(0x%08" PRIx32 ");\n"
+"\tuint32_t h[4];\n"
+"\tsize_t i;\n"
+"\n"
+"\tif (len < 16) {\n"
+"\t\th[0] = seed + UINT32_C(374761393);\n"
+"\t} else {\n"
+"\t\th[0] = seed + UINT32_C(2654435761) + UINT32_C(2246822519);\n"
+"\t\th[1] = seed + UINT32_C(2246822519);\n"
+"\t\th[2] = seed;\n"
+"\t\th[3] = seed - UINT32_C(2654435761);\n"
+"\n"
+"\t\tfor (; end - key >= 16; key += 16) {\n"
+"\t\t\tfor (i = 0; i < 4; i++) {\n"
+"\t\t\t\th[i] += @_read32(&key[4 * i]) *\n"
+"\t\t\t\t    UINT32_C(2246822519);\n"
+"\t\t\t\th[i] = @_rotl32(h[i], 13) * UINT32_C(2654435761);\n"
+"\t\t\t}\n"
+"\t\t}\n"
+"\n"
+"\t\th[0] = @_rotl32(h[0], 1) + @_rotl32(h[1], 7) +\n"
+"\t\t    @_rotl32(h[2], 12) + @_rotl32(h[3], 18);\n"
+"\t}\n"
+"\n"
+"\th[0] += (uint32_t)len;\n"
+"\n"
+"\tfor (; end - key >= 4; key += 4) {\n"
+"\t\th[0] += @_read32(key) * UINT32_C(3266489917);\n"
+"\t\th[0] = @_rotl32(h[0], 17) * UINT32_C(668265263);\n"
+"\t}\n"
+"\n"
+"\tfor (; key < end; key++) {\n"
+"\t\th[0] += key[0] * UINT32_C(374761393);\n"
+"\t\th[0] = @_rotl32(h[0], 11) * UINT32_C(2654435761);\n"
+"\t}\n"
+"\n"
+"\th[0] ^= h[0] >> 15;\n"
+"\th[0] *= UINT32_C(2246822519);\n"
+"\th[0] ^= h[0] >> 13;\n"
+"\th[0] *= UINT32_C(3266489917);\n"
+"\th[0] ^= h[0] >> 16;\n"
+"\n"
+"\treturn h[0];\n"
+"}\n"
+"\n";
+
+/* rgph_u64_xxh64s_data() with a literal seed. */
+static const char xxh64s_tmpl[] =
+"static inline uint64_t\n"
+"@_rotl64(uint64_t x, int l)\n"
+"{\n"
+"\n"
+"\treturn x << l | x >> (64 - l);\n"
+"}\n"
+"\n"
+"static inline uint64_t\n"
+"@_hash(const uint8_t *key, size_t len)\n"
+"{\n"
+"\tconst uint8_t *end = key + len;\n"
+"\tconst uint64_t seed = UINT64_C(0x%08" PRIx32 ");\n"
+"\tuint64_t h[4], w;\n"
+"\tsize_t i;\n"
+"\n"
+"\tif (len < 32) {\n"
+"\t\th[0] = seed + UINT64_C(0x27d4eb2f165667c5);\n"
+"\t} else {\n"
+"\t\th[0] = seed + UINT64_C(0x9e3779b185ebca87) +\n"
+"\t\t    UINT64_C(0xc2b2ae3d27d4eb4f);\n"
+"\t\th[1] = seed + UINT64_C(0xc2b2ae3d27d4eb4f);\n"
+"\t\th[2] = seed;\n"
+"\t\th[3] = seed - UINT64_C(0x9e3779b185ebca87);\n"
+"\n"
+"\t\tfor (; end - key >= 32; key += 32) {\n"
+"\t\t\tfor (i = 0; i < 4; i++) {\n"
+"\t\t\t\th[i] += @_read64(&key[8 * i]) *\n"
+"\t\t\t\t    UINT64_C(0xc2b2ae3d27d4eb4f);\n"
+"\t\t\t\th[i] = @_rotl64(h[i], 31) *\n"
+"\t\t\t\t    UINT64_C(0x9e3779b185ebca87);\n"
+"\t\t\t}\n"
+"\t\t}\n"
+"\n"
+"\t\tw = @_rotl64(h[0], 1) + @_rotl64(h[1], 7) +\n"
+"\t\t    @_rotl64(h[2], 12) + @_rotl64(h[3], 18);\n"
+"\n"
+"\t\tfor (i = 0; i < 4; i++) {\n"
+"\t\t\th[i] *= UINT64_C(0xc2b2ae3d27d4eb4f);\n"
+"\t\t\th[i] = @_rotl64(h[i], 31) * UINT64_C(0x9e3779b185ebca87);\n"
+"\t\t\tw ^= h[i];\n"
+"\t\t\tw = w * UINT64_C(0x9e3779b185ebca87) +\n"
+"\t\t\t    UINT64_C(0x85ebca77c2b2ae63);\n"
+"\t\t}\n"
+"\n"
+"\t\th[0] = w;\n"
+"\t}\n"
+"\n"
+"\th[0] += len;\n"
+"\n"
+"\tfor (; end - key >= 8; key += 8) {\n"
+"\t\tw = @_read64(key) * UINT64_C(0xc2b2ae3d27d4eb4f);\n"
+"\t\tw = @_rotl64(w, 31) * UINT64_C(0x9e3779b185ebca87);\n"
+"\t\th[0] ^= w;\n"
+"\t\th[0] = @_rotl64(h[0], 27) * UINT64_C(0x9e3779b185ebca87) +\n"
+"\t\t    UINT64_C(0x85ebca77c2b2ae63);\n"
+"\t}\n"
+"\n"
+"\tif (end - key >= 4) {\n"
+"\t\th[0] ^= @_read32(key) * UINT64_C(0x9e3779b185ebca87);\n"
+"\t\th[0] = @_rotl64(h[0], 23) * UINT64_C(0xc2b2ae3d27d4eb4f) +\n"
+"\t\t    UINT64_C(0x165667b19e3779f9);\n"
+"\t\tkey += 4;\n"
+"\t}\n"
+"\n"
+"\tfor (; key < end; key++) {\n"
+"\t\th[0] ^= key[0] * UINT64_C(0x27d4eb2f165667c5);\n"
+"\t\th[0] = @_rotl64(h[0], 11) * UINT64_C(0x9e3779b185ebca87);\n"
+"\t}\n"
+"\n"
+"\th[0] ^= h[0] >> 33;\n"
+"\th[0] *= UINT64_C(0xc2b2ae3d27d4eb4f);\n"
+"\th[0] ^= h[0] >> 29;\n"
+"\th[0] *= UINT64_C(0x165667b19e3779f9);\n"
+"\th[0] ^= h[0] >> 32;\n"
+"\n"
+"\treturn h[0];\n"
+"}\n"
+"\n";
+
+/* Derive a vertex hash, see RGPH_DERIVE_ADD in rgph_graph.h. */
+static const char derive_tmpl[] =
+"static inline uint32_t\n"
+"@_derive(uint64_t h, uint64_t add)\n"
+"{\n"
+"\tuint64_t x = h + add;\n"
+"\n"
+"\tx = (x ^ (x >> 32)) * UINT64_C(0x%016" PRIx64 ");\n"
+"\treturn x ^ (x >> 32);\n"
+"}\n"
+"\n";
+
+/* fast_remainder32(3) with literal constants. */
+static const char fastrem_tmpl[] =
+"static inline uint32_t\n"
+"@_part(uint32_t x)\n"
+"{\n"
+"\tconst uint32_t hi = (x * UINT64_C(%" PRIu32 ")) >> 32;\n"
+"\n"
+"\treturn x - UINT32_C(%" PRIu32 ") * ((hi + ((x - hi) >> 1)) >> %u);\n"
+"}\n"
+"\n";
+
+/* Lemire's reduction of a full 32bit vertex hash. */
+static const char lemire_tmpl[] =
+"static inline uint32_t\n"
+"@_part(uint32_t x)\n"
+"{\n"
+"\n"
+"\treturn (x * UINT64_C(%" PRIu32 ")) >> 32;\n"
+"}\n"
+"\n";
+
+static size_t ntries = 100;
+static unsigned long seed = 0;
+
+static const struct rgph_entry *
+iterator_func(void *state)
+{
+	struct iterator_state *s = (struct iterator_state *)state;
+	struct key const *k;
+
+	if (s->pos == s->ks->nkeys)
+		return NULL;
+
+	k = &s->ks->keys[s->pos++];
+	s->entry.key = k->key;
+	s->entry.keylen = k->keylen;
+	return &s->entry;
+}
+
+/* One key per line without a newline character. */
+static void
+file_keys(struct keyset *ks, FILE *f, const char *filename)
+{
+	char *line = NULL;
+	size_t linecap = 0, cap = 0;
+	ssize_t len;
+
+	ks->nkeys = 0;
+	ks->keys = NULL;
+
+	while ((len = getline(&line, &linecap, f)) > 0) {
+		if (line[len-1] == '\n')
+			line[--len] = '\0';
+
+		if (ks->nkeys == cap) {
+			cap = cap != 0 ? 2 * cap : 1024;
+			ks->keys = realloc(ks->keys, cap * sizeof(ks->keys[0]));
+			if (ks->keys == NULL)
+				err(EXIT_FAILURE, "realloc");
+		}
+
+		ks->keys[ks->nkeys].key = strdup(line);
+		ks->keys[ks->nkeys].keylen = len;
+		if (ks->keys[ks->nkeys].key == NULL)
+			err(EXIT_FAILURE, "strdup");
+		ks->nkeys++;
+	}
+
+	if (ferror(f))
+		err(EXIT_FAILURE, "%s", filename);
+
+	free(line);
+}
+
+static int
+parse_name(const char *opt, const struct name *names)
+{
+	size_t i;
+
+	for (i = 0; names[i].name != NULL; i++) {
+		if (strcmp(names[i].name, opt) == 0)
+			return names[i].flag;
+	}
+
+	errx(EXIT_FAILURE, "unknown name '%s'", opt);
+}
+
+static bool
+is_identifier(const char *s)
+{
+	const char *p;
+
+	if (*s == '\0' || strchr("0123456789", *s) != NULL)
+		return false;
+
+	for (p = s; *p != '\0'; p++) {
+		if (*p != '_' && strchr("abcdefghijklmnopqrstuvwxyz"
+		    "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789", *p) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+static size_t
+min_width(uint64_t max)
+{
+
+	return max <= UINT8_MAX ? 1 : max <= UINT16_MAX ? 2 :
+	    max <= UINT32_MAX ? 4 : 8;
+}
+
+/*
+ * Build and assign the graph. Every failed build bumps the seed.
+ */
+static struct rgph_graph *
+build(struct keyset const *ks, int flags)
+{
+	struct iterator_state state;
+	struct rgph_graph *g;
+	size_t i, dup[2];
+	int res = RGPH_AGAIN;
+
+	g = rgph_alloc_graph(ks->nkeys, flags);
+	if (g == NULL)
+		err(EXIT_FAILURE, "rgph_alloc_graph");
+
+	for (i = 0; i < ntries && res == RGPH_AGAIN; i++, seed++) {
+		memset(&state, 0, sizeof(state));
+		state.ks = ks;
+		res = rgph_build_graph(g, flags, NULL, seed,
+		    &iterator_func, &state);
+		if (res == RGPH_SUCCESS)
+			break;
+	}
+
+	if (res == RGPH_AGAIN) {
+		memset(&state, 0, sizeof(state));
+		state.ks = ks;
+		if (rgph_find_duplicates(g,
+		    &iterator_func, &state, dup) == RGPH_SUCCESS) {
+			errx(EXIT_FAILURE, "duplicate keys at lines %zu and %zu",
+			    dup[0] + 1, dup[1] + 1);
+		}
+
+		errx(EXIT_FAILURE, "no graph after %zu tries", ntries);
+	}
+
+	if (res != RGPH_SUCCESS)
+		errx(EXIT_FAILURE, "rgph_build_graph failed: %d", res);
+
+	res = rgph_assign(g, flags);
+	if (res != RGPH_SUCCESS)
+		errx(EXIT_FAILURE, "rgph_assign failed: %d", res);
+
+	return g;
+}
+
+/*
+ * Keys don't have explicit indices and the default RGPH_INDEX_COMPACT
+ * is used, so CHM assignments are sums modulo nkeys, see lookup_chm()
+ * in graph.cc.
+ */
+static void
+get_params(struct rgph_graph const *g, const char *name, struct params *p)
+{
+	uint8_t s1;
+	char *upper;
+
+	p->name = name;
+	p->upper = upper = strdup(name);
+	if (upper == NULL)
+		err(EXIT_FAILURE, "strdup");
+
+	for (; *upper != '\0'; upper++) {
+		if (*upper >= 'a' && *upper <= 'z')
+			*upper = *upper - 'a' + 'A';
+	}
+
+	p->flags = rgph_flags(g);
+	p->rank = rgph_rank(g);
+	p->seed = rgph_seed(g);
+	p->nkeys = rgph_entries(g);
+	p->nverts = rgph_vertices(g);
+	p->partsz = p->nverts / p->rank;
+	p->mod = rgph_index_max(g) - rgph_index_min(g) + 1;
+
+	assert(p->flags & RGPH_INDEX_COMPACT);
+	assert(rgph_index_min(g) == 0);
+
+	rgph_fastdiv_prepare(p->partsz, &p->mul, &s1, &p->s2, true);
+}
+
+static size_t
+table_width(struct params const *p)
+{
+	bool const bdz = (p->flags & RGPH_ALGO_MASK) == RGPH_ALGO_BDZ;
+
+	return bdz ? 1 : min_width(p->mod - 1);
+}
+
+static const char *
+table_type(struct params const *p)
+{
+
+	switch (table_width(p)) {
+	case 1: return "uint8_t";
+	case 2: return "uint16_t";
+	case 4: return "uint32_t";
+	default: return "uint64_t";
+	}
+}
+
+static size_t
+table_size(struct params const *p)
+{
+	bool const bdz = (p->flags & RGPH_ALGO_MASK) == RGPH_ALGO_BDZ;
+	size_t const per_byte = p->rank == 2 ? 8 : 4;
+
+	return bdz ? (p->nverts + per_byte - 1) / per_byte : p->nverts;
+}
+
+/*
+ * Write elements of the assignment table. BDZ assignments are
+ * packed 4 (rank 3) or 8 (rank 2) per byte, a value equal to
+ * the rank is the same as zero in the lookup.
+ */
+static void
+write_table(FILE *f, struct rgph_graph const *g, struct params const *p)
+{
+	bool const bdz = (p->flags & RGPH_ALGO_MASK) == RGPH_ALGO_BDZ;
+	size_t const per_byte = p->rank == 2 ? 8 : 4;
+	size_t const per_line = bdz ? 12 : 8;
+	size_t v, n = 0;
+	uint64_t a, b = 0;
+
+	for (v = 0; v < p->nverts; v++) {
+		if (rgph_copy_assignment(g, v, &a) != RGPH_SUCCESS)
+			errx(EXIT_FAILURE, "rgph_copy_assignment failed");
+
+		if (bdz) {
+			b |= (a % p->rank) << (v % per_byte * (8 / per_byte));
+			if (v % per_byte != per_byte - 1 && v != p->nverts - 1)
+				continue;
+			a = b;
+			b = 0;
+		}
+
+		fprintf(f, "%s", n % per_line == 0 ? "\t" : " ");
+		if (bdz)
+			fprintf(f, "0x%02" PRIx64 ",", a);
+		else if (table_width(p) == sizeof(uint64_t))
+			fprintf(f, "UINT64_C(%" PRIu64 "),", a);
+		else
+			fprintf(f, "%" PRIu64 ",", a);
+		if (++n % per_line == 0)
+			fprintf(f, "\n");
+	}
+
+	if (n % per_line != 0)
+		fprintf(f, "\n");
+}
+
+/* Copy fmt replacing every @ with name and pass it to vfprintf(3). */
+static void
+emit(FILE *f, const char *name, const char *fmt, ...)
+{
+	size_t const namelen = strlen(name);
+	size_t n = strlen(fmt) + 1;
+	const char *s;
+	char *buf, *d;
+	va_list ap;
+
+	for (s = fmt; *s != '\0'; s++) {
+		if (*s == '@')
+			n += namelen;
+	}
+
+	buf = malloc(n);
+	if (buf == NULL)
+		err(EXIT_FAILURE, "malloc");
+
+	for (s = fmt, d = buf; *s != '\0'; s++) {
+		if (*s == '@') {
+			memcpy(d, name, namelen);
+			d += namelen;
+		} else {
+			*d++ = *s;
+		}
+	}
+	*d = '\0';
+
+	va_start(ap, fmt);
+	vfprintf(f, buf, ap);
+	va_end(ap);
+
+	free(buf);
+}
+
+/* Vertex r of a key with a hash value h. */
+static void
+emit_vertex(FILE *f, struct params const *p, int r)
+{
+	uint64_t const add = (r + 1) * RGPH_DERIVE_ADD;
+
+	emit(f, p->name, "\tconst uint32_t v%d = ", r);
+	if (r > 0)
+		fprintf(f, "UINT32_C(%" PRIu32 ") + ", r * p->partsz);
+	emit(f, p->name, "@_part(@_derive(h,\n"
+	    "\t    UINT64_C(0x%016" PRIx64 ")));\n", add);
+}
+
+static void
+emit_lookup(FILE *f, struct params const *p)
+{
+	bool const bdz = (p->flags & RGPH_ALGO_MASK) == RGPH_ALGO_BDZ;
+	int r;
+
+	if (!bdz) {
+		emit(f, p->name,
+		    "static inline uint64_t\n"
+		    "@_add(uint64_t h, uint64_t a)\n"
+		    "{\n"
+		    "\tconst uint64_t mod = UINT64_C(%" PRIu64 ");\n"
+		    "\n"
+		    "\treturn a >= mod - h ? a - (mod - h) : h + a;\n"
+		    "}\n"
+		    "\n", p->mod);
+	}
+
+	emit(f, p->name,
+	    "static inline uint32_t\n"
+	    "@(const void *key, size_t keylen)\n"
+	    "{\n"
+	    "\tconst uint64_t h = @_hash((const uint8_t *)key, keylen);\n");
+
+	for (r = 0; r < p->rank; r++)
+		emit_vertex(f, p, r);
+
+	fprintf(f, "\n");
+
+	if (bdz) {
+		int const bits = p->rank == 2 ? 1 : 2;
+		int const shift = p->rank == 2 ? 3 : 2;
+		int const mask = (1 << bits) - 1;
+
+		for (r = 0; r < p->rank; r++) {
+			emit(f, p->name, "\t%s (@_g[v%d >> %d] >> "
+			    "(v%d & %d)%s & %d)%s\n",
+			    r == 0 ? "const unsigned int i =" : "   ",
+			    r, shift, r, (1 << shift) - 1,
+			    bits == 1 ? "" : " * 2", mask,
+			    r == p->rank - 1 ? ";" : " +");
+		}
+
+		fprintf(f, "\n");
+		if (p->rank == 2) {
+			fprintf(f, "\treturn (i & 1) ? v1 : v0;\n");
+		} else {
+			fprintf(f, "\treturn i %% 3 == 0 ? v0 : "
+			    "i %% 3 == 1 ? v1 : v2;\n");
+		}
+	} else {
+		fprintf(f, "\tuint64_t res = 0;\n\n");
+		for (r = 0; r < p->rank; r++)
+			emit(f, p->name, "\tres = @_add(res, @_g[v%d]);\n", r);
+		fprintf(f, "\n\treturn res;\n");
+	}
+
+	fprintf(f, "}\n");
+}
+
+static void
+write_header(FILE *f, struct params const *p)
+{
+	int const hash = p->flags & RGPH_HASH_MASK;
+	int const reduce = p->flags & RGPH_REDUCE_MASK;
+
+	fprintf(f, "/* Generated by rgph_gen, do not edit. */\n\n");
+	fprintf(f, "#ifndef %s_H_INCLUDED\n#define %s_H_INCLUDED\n\n",
+	    p->upper, p->upper);
+	fprintf(f, "#include <stddef.h>\n#include <stdint.h>\n\n");
+
+	fprintf(f, "#define %s_NKEYS  %zu\n", p->upper, p->nkeys);
+	fprintf(f, "#define %s_NVERTS %zu\n\n", p->upper, p->nverts);
+
+	emit(f, p->name, "extern const %s @_g[%zu];\n\n",
+	    table_type(p), table_size(p));
+
+	emit(f, p->name, read_tmpl);
+
+	if (hash == RGPH_HASH_XXH32S)
+		emit(f, p->name, xxh32s_tmpl, p->seed);
+	else
+		emit(f, p->name, xxh64s_tmpl, p->seed);
+
+	emit(f, p->name, derive_tmpl, RGPH_DERIVE_MUL);
+
+	if (reduce == RGPH_REDUCE_MUL)
+		emit(f, p->name, lemire_tmpl, p->partsz);
+	else
+		emit(f, p->name, fastrem_tmpl, p->mul, p->partsz, p->s2);
+
+	emit_lookup(f, p);
+	fprintf(f, "\n#endif /* !%s_H_INCLUDED */\n", p->upper);
+}
+
+static void
+write_source(FILE *f, struct rgph_graph const *g, struct params const *p,
+    const char *header)
+{
+
+	fprintf(f, "/* Generated by rgph_gen, do not edit. */\n\n");
+	fprintf(f, "#include \"%s\"\n\n", header);
+	emit(f, p->name, "const %s @_g[%zu] = {\n",
+	    table_type(p), table_size(p));
+	write_table(f, g, p);
+	fprintf(f, "};\n");
+}
+
+static char *
+concat(const char *s1, const char *s2)
+{
+	size_t const len1 = strlen(s1), len2 = strlen(s2);
+	char *res;
+
+	res = malloc(len1 + len2 + 1);
+	if (res == NULL)
+		err(EXIT_FAILURE, "malloc");
+
+	memcpy(res, s1, len1);
+	memcpy(res + len1, s2, len2 + 1);
+	return res;
+}
+
+static FILE *
+open_output(const char *prefix, const char *suffix, char **path)
+{
+	FILE *f;
+
+	*path = concat(prefix, suffix);
+	f = fopen(*path, "w");
+	if (f == NULL)
+		err(EXIT_FAILURE, "%s", *path);
+	return f;
+}
+
+static void
+close_output(FILE *f, const char *path)
+{
+
+	if (ferror(f) || fclose(f) != 0)
+		err(EXIT_FAILURE, "%s", path);
+}
+
+static void
+usage(void)
+{
+
+	fprintf(stderr, "usage: rgph_gen [-n name] [-o prefix] [-s seed] "
+	    "[-t tries]\n"
+	    "\t[-H hash] [-R rank] [-A algo] [-M reduce] [file]\n");
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct keyset ks;
+	struct params p;
+	struct rgph_graph *g;
+	const char *filename = "-", *name = "hash", *prefix = NULL;
+	const char *s;
+	char *hpath, *cpath;
+	int hash = RGPH_HASH_XXH64S, rank = RGPH_RANK3;
+	int algo = RGPH_ALGO_CHM, reduce = RGPH_REDUCE_MOD;
+	FILE *f;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "A:H:M:n:o:R:s:t:")) != -1) {
+		switch (ch) {
+		case 'A': algo = parse_name(optarg, algos); break;
+		case 'H': hash = parse_name(optarg, hashes); break;
+		case 'M': reduce = parse_name(optarg, reductions); break;
+		case 'n': name = optarg; break;
+		case 'o': prefix = optarg; break;
+		case 'R': rank = parse_name(optarg, ranks); break;
+		case 's': seed = strtoul(optarg, NULL, 0); break;
+		case 't': ntries = strtoul(optarg, NULL, 0); break;
+		default:
+			usage();
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	if (argc > 1 || ntries == 0)
+		usage();
+
+	if (!is_identifier(name))
+		errx(EXIT_FAILURE, "'%s' isn't a C identifier", name);
+
+	if (argc == 1)
+		filename = argv[0];
+
+	if (strcmp(filename, "-") == 0) {
+		file_keys(&ks, stdin, "stdin");
+	} else {
+		f = fopen(filename, "r");
+		if (f == NULL)
+			err(EXIT_FAILURE, "%s", filename);
+		file_keys(&ks, f, filename);
+		fclose(f);
+	}
+
+	if (ks.nkeys == 0)
+		errx(EXIT_FAILURE, "no keys");
+
+	g = build(&ks, hash | rank | algo | reduce);
+	get_params(g, name, &p);
+
+	if (prefix == NULL)
+		prefix = name;
+
+	f = open_output(prefix, ".h", &hpath);
+	write_header(f, &p);
+	close_output(f, hpath);
+
+	s = strrchr(hpath, '/');
+	f = open_output(prefix, ".c", &cpath);
+	write_source(f, g, &p, s != NULL ? s + 1 : hpath);
+	close_output(f, cpath);
+
+	rgph_free_graph(g);
+	return EXIT_SUCCESS;
+}